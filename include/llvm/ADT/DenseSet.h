@@ -152,6 +152,15 @@ public:
     return TheMap.insert(std::make_pair(V, Empty));
   }
 
+  /// Alternative version of insert that uses a different (and possibly less
+  /// expensive) key type.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(const ValueT &V,
+                                      const LookupKeyT &LookupKey) {
+    detail::DenseSetEmpty Empty;
+    return TheMap.insert_as(std::make_pair(V, Empty), LookupKey);
+  }
+
   // Range insertion of values.
   template<typename InputIt>
   void insert(InputIt I, InputIt E) {
@@ -32,9 +32,12 @@ class PreservedAnalyses;
 ///
 /// If \c EmitFunctionSummary, emit the function summary index (currently
 /// for use in ThinLTO optimization).
+///
+/// If \c EmitSymbolTable, emit a symbol table block for the linker.
 ModulePass *createBitcodeWriterPass(raw_ostream &Str,
                                     bool ShouldPreserveUseListOrder = false,
-                                    bool EmitFunctionSummary = false);
+                                    bool EmitFunctionSummary = false,
+                                    bool EmitSymbolTable = false);
 
 /// \brief Pass for writing a module of IR out to a bitcode file.
 ///
@@ -44,6 +47,7 @@ class BitcodeWriterPass {
   raw_ostream &OS;
   bool ShouldPreserveUseListOrder;
   bool EmitFunctionSummary;
+  bool EmitSymbolTable;
 
 public:
   /// \brief Construct a bitcode writer pass around a particular output stream.
@@ -53,11 +57,15 @@ public:
   ///
   /// If \c EmitFunctionSummary, emit the function summary index (currently
   /// for use in ThinLTO optimization).
+  ///
+  /// If \c EmitSymbolTable, emit a symbol table block for the linker.
   explicit BitcodeWriterPass(raw_ostream &OS,
                              bool ShouldPreserveUseListOrder = false,
-                             bool EmitFunctionSummary = false)
+                             bool EmitFunctionSummary = false,
+                             bool EmitSymbolTable = false)
       : OS(OS), ShouldPreserveUseListOrder(ShouldPreserveUseListOrder),
-        EmitFunctionSummary(EmitFunctionSummary) {}
+        EmitFunctionSummary(EmitFunctionSummary),
+        EmitSymbolTable(EmitSymbolTable) {}
 
   /// \brief Run the bitcode writer pass, and output the module to the selected
   /// output stream.
@@ -52,7 +52,11 @@ enum BlockIDs {
 
   OPERAND_BUNDLE_TAGS_BLOCK_ID,
 
-  METADATA_KIND_BLOCK_ID
+  METADATA_KIND_BLOCK_ID,
+
+  // Block listing the symbols of the module, so that a linker can resolve
+  // them without materializing the IR.
+  SYMTAB_BLOCK_ID
 };
 
 /// Identification block contains a string that describes the producer details,
@@ -188,6 +192,22 @@ enum { BITCODE_CURRENT_EPOCH = 0 };
     FS_CODE_COMBINED_ENTRY  = 2,  // FS_ENTRY: [modid, instcount]
   };
 
+  // The symbol table block (SYMTAB_BLOCK_ID) has the comdats of the module,
+  // followed by its global values in the order functions, global variables,
+  // aliases. The names are mangled for the target of the module.
+  enum SymtabCodes {
+    SYMTAB_CODE_COMDAT = 1, // COMDAT: [namechar x N]
+    SYMTAB_CODE_ENTRY  = 2, // ENTRY:  [linkage, visibility, flags, comdat,
+                            //          commonsize, commonalign, namechar x N]
+  };
+
+  // The flags of a SYMTAB_CODE_ENTRY record.
+  enum SymtabFlags {
+    SYMTAB_FLAG_UNDEFINED       = 1 << 0,
+    SYMTAB_FLAG_FORMAT_SPECIFIC = 1 << 1,
+    SYMTAB_FLAG_CAN_BE_OMITTED  = 1 << 2
+  };
+
   enum MetadataCodes {
     METADATA_STRING        = 1,   // MDSTRING:      [values]
     METADATA_VALUE         = 2,   // VALUE:         [type num, value num]
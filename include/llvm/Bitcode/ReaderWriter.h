@@ -16,11 +16,13 @@
 
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/GlobalValue.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
   class BitstreamWriter;
@@ -86,6 +88,46 @@ namespace llvm {
       MemoryBufferRef Buffer, DiagnosticHandlerFunction DiagnosticHandler,
       StringRef FunctionName, std::unique_ptr<FunctionInfoIndex> Index);
 
+  /// A global value of a bitcode module, as read by readBitcodeSymbols.
+  struct BitcodeSymbol {
+    /// The name of the symbol, mangled for the target of the module by the
+    /// Mangler. dllimport declarations get no "__imp_" prefix.
+    std::string Name;
+    GlobalValue::LinkageTypes Linkage;
+    GlobalValue::VisibilityTypes Visibility;
+    /// True if the value is a declaration as far as the linker is concerned.
+    bool IsDeclaration;
+    /// True if the value has private linkage, a name starting with "llvm.",
+    /// or is in the "llvm.metadata" section, so that it is not a symbol of
+    /// the object file.
+    bool IsFormatSpecific;
+    /// The name of the comdat of the value, or empty if it has none. The
+    /// comdat of an alias is only known if the module has a symbol table
+    /// block.
+    std::string Comdat;
+    /// The size of a common symbol. Only known if the module has a symbol
+    /// table block, zero otherwise.
+    uint64_t CommonSize;
+    /// The alignment of a common symbol, or zero if it is unspecified.
+    unsigned CommonAlign;
+    /// True if the value is linkonce_odr and its address is not significant,
+    /// so that the linker may hide it (see canBeOmittedFromSymbolTable). Only
+    /// known if the module has a symbol table block, false otherwise.
+    bool CanBeOmittedFromSymbolTable;
+  };
+
+  /// Read the global values of the specified bitcode buffer without creating
+  /// a Module or parsing any function body. The functions come first, then
+  /// the global variables and then the aliases, each in the order of the
+  /// module. If the module has a symbol table block (see WriteBitcodeToFile),
+  /// only that block is read. Otherwise the global values are read from the
+  /// records of the module block, and errc::function_not_supported is
+  /// returned if the module has inline asm, which may define other symbols,
+  /// or if a name cannot be mangled without the IR. If \p HasSymbolTable is
+  /// not null, it is set to whether the module has a symbol table block.
+  ErrorOr<std::vector<BitcodeSymbol>>
+  readBitcodeSymbols(MemoryBufferRef Buffer, bool *HasSymbolTable = nullptr);
+
   /// \brief Write the specified module to the specified raw output stream.
   ///
   /// For streams where it matters, the given stream should be in "binary"
@@ -97,9 +139,15 @@ namespace llvm {
   ///
   /// If \c EmitFunctionSummary, emit the function summary index (currently
   /// for use in ThinLTO optimization).
+  ///
+  /// If \c EmitSymbolTable, emit a symbol table block that readBitcodeSymbols
+  /// can answer from without reading the rest of the module. It is omitted
+  /// for modules with module-level inline asm, whose symbols are only known
+  /// to the target's asm parser.
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
                           bool ShouldPreserveUseListOrder = false,
-                          bool EmitFunctionSummary = false);
+                          bool EmitFunctionSummary = false,
+                          bool EmitSymbolTable = false);
 
   /// Write the specified function summary index to the given raw output stream,
   /// where it will be written in a new bitcode block. This is used when
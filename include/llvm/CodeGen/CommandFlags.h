@@ -224,6 +224,11 @@ FunctionSections("function-sections",
                  cl::desc("Emit functions into separate sections"),
                  cl::init(false));
 
+cl::opt<unsigned>
+ObjectWriterThreads("object-writer-threads",
+                    cl::desc("Number of threads used to write the object file"),
+                    cl::init(1));
+
 cl::opt<bool> EmulatedTLS("emulated-tls",
                           cl::desc("Use emulated TLS model"),
                           cl::init(false));
@@ -290,6 +295,7 @@ static inline TargetOptions InitTargetOptionsFromCodeGenFlags() {
   Options.FunctionSections = FunctionSections;
   Options.UniqueSectionNames = UniqueSectionNames;
   Options.EmulatedTLS = EmulatedTLS;
+  Options.ObjectWriterThreads = ObjectWriterThreads;
 
   Options.MCOptions = InitMCTargetOptionsFromFlags();
   Options.JTType = JTableType;
@@ -55,6 +55,12 @@ class LiveRegMatrix : public MachineFunctionPass {
   unsigned RegMaskVirtReg;
   BitVector RegMaskUsable;
 
+  // Cached fixed register unit interference info, indexed by PhysReg.
+  unsigned RegUnitTag;
+  unsigned RegUnitVirtReg;
+  BitVector RegUnitChecked;
+  BitVector RegUnitInterference;
+
   // MachineFunctionPass boilerplate.
   void getAnalysisUsage(AnalysisUsage&) const override;
   bool runOnMachineFunction(MachineFunction&) override;
@@ -29,6 +29,10 @@ class raw_pwrite_stream;
 /// files if linked together are intended to be equivalent to the single output
 /// file that would have been code generated from M.
 ///
+/// If PreserveOrder is true, the partitions are contiguous runs of M, so that
+/// linking the output files in the order of OSs lays out the code and data
+/// as if M had been code generated as a whole.
+///
 /// \returns M if OSs.size() == 1, otherwise returns std::unique_ptr<Module>().
 std::unique_ptr<Module>
 splitCodeGen(std::unique_ptr<Module> M, ArrayRef<raw_pwrite_stream *> OSs,
@@ -36,7 +40,8 @@ splitCodeGen(std::unique_ptr<Module> M, ArrayRef<raw_pwrite_stream *> OSs,
              Reloc::Model RM = Reloc::Default,
              CodeModel::Model CM = CodeModel::Default,
              CodeGenOpt::Level OL = CodeGenOpt::Default,
-             TargetMachine::CodeGenFileType FT = TargetMachine::CGFT_ObjectFile);
+             TargetMachine::CodeGenFileType FT = TargetMachine::CGFT_ObjectFile,
+             bool PreserveOrder = false);
 
 } // namespace llvm
 
@@ -172,6 +172,10 @@ namespace llvm {
 
     ~ScheduleDAGInstrs() override {}
 
+    /// Name of the timer group used to report the scheduling phases with
+    /// -time-passes.
+    static const char TimerGroupName[];
+
     /// \brief Get the machine model for instruction scheduling.
     const TargetSchedModel *getSchedModel() const { return &SchedModel; }
 
@@ -80,6 +80,32 @@ template<> struct FoldingSetTrait<SDVTListNode> : DefaultFoldingSetTrait<SDVTLis
   }
 };
 
+/// Specialize FoldingSetTrait for SDNode to remember the hash of each node in
+/// the CSE map. Nodes in the same bucket are then told apart by comparing
+/// their hash before their full profile is recomputed, and growing the map
+/// does not recompute the profile of every node.
+template<> struct FoldingSetTrait<SDNode> : DefaultFoldingSetTrait<SDNode> {
+  static bool Equals(const SDNode &X, const FoldingSetNodeID &ID,
+                     unsigned IDHash, FoldingSetNodeID &TempID) {
+    if (X.CSEHash) {
+      if (X.CSEHash != IDHash)
+        return false;
+      X.Profile(TempID);
+      return ID == TempID;
+    }
+    X.Profile(TempID);
+    X.CSEHash = TempID.ComputeHash();
+    return X.CSEHash == IDHash && ID == TempID;
+  }
+  static unsigned ComputeHash(const SDNode &X, FoldingSetNodeID &TempID) {
+    if (!X.CSEHash) {
+      X.Profile(TempID);
+      X.CSEHash = TempID.ComputeHash();
+    }
+    return X.CSEHash;
+  }
+};
+
 template<> struct ilist_traits<SDNode> : public ilist_default_traits<SDNode> {
 private:
   mutable ilist_half_node<SDNode> Sentinel;
@@ -436,12 +436,20 @@ private:
 
   friend class SelectionDAG;
   friend struct ilist_traits<SDNode>;
+  friend struct FoldingSetTrait<SDNode>;
 
 public:
   /// Unique and persistent id per SDNode in the DAG.
   /// Used for debug printing.
   uint16_t PersistentId;
 
+private:
+  /// The hash of the CSE profile of this node, or zero if it has not been
+  /// computed since the node was last added to the CSE map.
+  mutable unsigned CSEHash;
+
+public:
+
   //===--------------------------------------------------------------------===//
   //  Accessors
   //
@@ -794,7 +802,8 @@ protected:
         SubclassData(0), NodeId(-1),
         OperandList(Ops.size() ? new SDUse[Ops.size()] : nullptr),
         ValueList(VTs.VTs), UseList(nullptr), NumOperands(Ops.size()),
-        NumValues(VTs.NumVTs), IROrder(Order), debugLoc(std::move(dl)) {
+        NumValues(VTs.NumVTs), IROrder(Order), debugLoc(std::move(dl)),
+        CSEHash(0) {
     assert(debugLoc.hasTrivialDestructor() && "Expected trivial destructor");
     assert(NumOperands == Ops.size() &&
            "NumOperands wasn't wide enough for its operands!");
@@ -814,7 +823,7 @@ protected:
       : NodeType(Opc), OperandsNeedDelete(false), HasDebugValue(false),
         SubclassData(0), NodeId(-1), OperandList(nullptr), ValueList(VTs.VTs),
         UseList(nullptr), NumOperands(0), NumValues(VTs.NumVTs),
-        IROrder(Order), debugLoc(std::move(dl)) {
+        IROrder(Order), debugLoc(std::move(dl)), CSEHash(0) {
     assert(debugLoc.hasTrivialDestructor() && "Expected trivial destructor");
     assert(NumValues == VTs.NumVTs &&
            "NumValues wasn't wide enough for its operands!");
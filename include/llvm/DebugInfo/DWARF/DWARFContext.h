@@ -174,6 +174,12 @@ public:
   /// Get a pointer to a parsed line table corresponding to a compile unit.
   const DWARFDebugLine::LineTable *getLineTableForUnit(DWARFUnit *cu);
 
+  /// Extract the DIEs and parse the line tables of all the compile units, and
+  /// build the address ranges, on \p NumThreads threads. Each unit is parsed
+  /// on its own, and the results are merged once all the units are done:
+  /// after this, looking up an address does not parse anything.
+  void parseAllUnits(unsigned NumThreads);
+
   DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
   DILineInfoTable getLineInfoForAddressRange(uint64_t Address, uint64_t Size,
@@ -10,7 +10,9 @@
 #ifndef LLVM_LIB_DEBUGINFO_DWARFDEBUGARANGES_H
 #define LLVM_LIB_DEBUGINFO_DWARFDEBUGARANGES_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/Support/DataExtractor.h"
 #include <vector>
 
@@ -20,7 +22,11 @@ class DWARFContext;
 
 class DWARFDebugAranges {
 public:
-  void generate(DWARFContext *CTX);
+  /// Build the ranges from .debug_aranges and from the compile units of
+  /// \p CTX. \p CURanges, if not empty, holds the address ranges already
+  /// collected for each compile unit of \p CTX, in order.
+  void generate(DWARFContext *CTX,
+                ArrayRef<DWARFAddressRangesVector> CURanges = None);
   uint32_t findAddress(uint64_t Address) const;
 
 private:
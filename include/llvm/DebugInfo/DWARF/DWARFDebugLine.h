@@ -224,6 +224,10 @@ public:
   const LineTable *getOrParseLineTable(DataExtractor debug_line_data,
                                        uint32_t offset);
 
+  /// Create an empty line table for \p offset, for the caller to parse.
+  /// Returns null if there already is a line table for this offset.
+  LineTable *createLineTable(uint32_t offset);
+
 private:
   struct ParsingState {
     ParsingState(struct LineTable *LT);
@@ -26,6 +26,8 @@ namespace symbolize {
 using namespace object;
 using FunctionNameKind = DILineInfoSpecifier::FunctionNameKind;
 
+class SymbolizationCache;
+
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -35,6 +37,13 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// If non-zero, parse the DWARF of each module up front on this many
+    /// threads instead of lazily on the first lookups.
+    unsigned DWARFParseThreads = 0;
+    /// If not empty, the results of the code lookups are saved in this
+    /// directory, in one file per module build ID, and later runs answer the
+    /// same lookups from there without reading the debug info.
+    std::string CacheDir;
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
             bool RelativeAddresses = false, std::string DefaultArch = "")
@@ -43,10 +52,8 @@ public:
           DefaultArch(DefaultArch) {}
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
-  ~LLVMSymbolizer() {
-    flush();
-  }
+  LLVMSymbolizer(const Options &Opts = Options());
+  ~LLVMSymbolizer();
 
   ErrorOr<DILineInfo> symbolizeCode(const std::string &ModuleName,
                                     uint64_t ModuleOffset);
@@ -65,6 +72,9 @@ private:
 
   ErrorOr<SymbolizableModule *>
   getOrCreateModuleInfo(const std::string &ModuleName);
+  /// \brief Returns the cache of the code lookups on \p ModuleName, or null
+  /// if they are not cached.
+  SymbolizationCache *getOrCreateCache(const std::string &ModuleName);
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -97,6 +107,14 @@ private:
       ObjectForUBPathAndArch;
 
   Options Opts;
+
+  /// \brief Contains the cache of the lookups for each module name, or null if
+  /// the lookups on this module are not cached.
+  std::map<std::string, SymbolizationCache *> CacheForModule;
+
+  /// \brief Owns the caches, by file path: several module names may refer to
+  /// the same object file.
+  std::map<std::string, std::unique_ptr<SymbolizationCache>> Caches;
 };
 
 } // namespace symbolize
@@ -32,6 +32,7 @@ namespace llvm {
 /// LLVM as well as ensuring uniqueness of names.
 ///
 class ValueSymbolTable {
+  friend class Function;
   friend class Value;
   friend class SymbolTableListTraits<Argument>;
   friend class SymbolTableListTraits<BasicBlock>;
@@ -118,6 +119,12 @@ private:
   /// symtab.
   void removeValueName(ValueName *V);
 
+  /// This method drops the names of all the values in the symbol table, and
+  /// empties it. It is used when all these values are about to be deleted:
+  /// removing them from the symbol table one at a time would look up every
+  /// name again.
+  void dropAllNames();
+
   /// @}
   /// @name Internal Data
   /// @{
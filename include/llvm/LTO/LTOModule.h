@@ -15,6 +15,7 @@
 #define LLVM_LTO_LTOMODULE_H
 
 #include "llvm-c/lto.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/IR/Module.h"
@@ -49,6 +50,11 @@ private:
 
   std::string LinkerOpts;
 
+  // The mapped input file, when the module was created from a file. Function
+  // bodies are then only read from it when they are materialized, e.g. when
+  // the linker pulls them in.
+  std::unique_ptr<MemoryBuffer> OwnedBuffer;
+
   std::unique_ptr<object::IRObjectFile> IRFile;
   std::unique_ptr<TargetMachine> _target;
   std::vector<NameAndAttributes> _symbols;
@@ -57,6 +63,9 @@ private:
   StringSet<>                             _defines;
   StringMap<NameAndAttributes> _undefines;
   std::vector<const char*>                _asm_undefines;
+  /// The global values that the symbol table block of the bitcode allows to
+  /// be hidden, for a module whose function bodies are not all materialized.
+  DenseSet<const GlobalValue *>           HideableSymbols;
 
   LTOModule(std::unique_ptr<object::IRObjectFile> Obj, TargetMachine *TM);
   LTOModule(std::unique_ptr<object::IRObjectFile> Obj, TargetMachine *TM,
@@ -205,10 +214,12 @@ private:
   /// Get string that the data pointer points to.
   bool objcClassNameFromExpression(const Constant *c, std::string &name);
 
-  /// Create an LTOModule (private version).
+  /// Create an LTOModule (private version). If \p OwnedBuffer is provided, it
+  /// backs \p Buffer and the module is loaded lazily from it.
   static ErrorOr<std::unique_ptr<LTOModule>>
   makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
-                LLVMContext *Context);
+                LLVMContext *Context,
+                std::unique_ptr<MemoryBuffer> OwnedBuffer = nullptr);
 };
 }
 #endif
@@ -0,0 +1,161 @@
+//===-ThinLTOCodeGenerator.h - LLVM Link Time Optimizer -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the ThinLTOCodeGenerator class.
+//
+//   Unlike LTOCodeGenerator, which links every input into a single merged
+// module, the ThinLTOCodeGenerator keeps each input module separate. A
+// combined FunctionInfoIndex is built from the per-module summaries, and is
+// then used to drive function importing into every module independently.
+// Each module is imported, optimized and compiled on its own thread with its
+// own LLVMContext, producing one native object per input module.
+//
+//   The native objects can optionally be cached on disk. Each object is first
+// looked up by a hash of the module, of the combined index and of the code
+// generation options, which finds it without even parsing the module when
+// the same set of modules is linked again. Otherwise, the module is imported
+// into and looked up by a hash of the module, of the functions imported into
+// it and of the options, so that relinking after a small change only
+// recompiles the modules that are actually affected.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LTO_THINLTOCODEGENERATOR_H
+#define LLVM_LTO_THINLTOCODEGENERATOR_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+class FunctionInfoIndex;
+class LLVMContext;
+class MD5;
+class Module;
+
+//===----------------------------------------------------------------------===//
+/// Driver for the ThinLTO backends: cross-module function importing,
+/// per-module optimization and code generation, run in parallel over the set
+/// of input modules.
+///
+class ThinLTOCodeGenerator {
+public:
+  ThinLTOCodeGenerator();
+  ~ThinLTOCodeGenerator();
+
+  /// Add a module to the set of modules to compile. The buffer is not owned:
+  /// it must outlive the code generator. \p Identifier is used as the module
+  /// identifier, and must match the module path recorded in the summary.
+  void addModule(StringRef Identifier, StringRef Data);
+
+  void setTargetOptions(TargetOptions Options) { this->Options = Options; }
+  void setCodePICModel(Reloc::Model Model) { RelocModel = Model; }
+  void setFileType(TargetMachine::CodeGenFileType FT) { FileType = FT; }
+  void setCpu(std::string MCpu) { this->MCpu = std::move(MCpu); }
+  void setAttr(std::string MAttr) { this->MAttr = std::move(MAttr); }
+  void setOptLevel(unsigned OptLevel);
+
+  /// \name Cache
+  /// @{
+
+  /// Provide a path to a directory where native objects are cached. An empty
+  /// path disables caching. The directory can be shared by concurrent links.
+  void setCacheDir(std::string Path) { CacheOptions.Path = std::move(Path); }
+
+  /// Minimum interval between two pruning of the cache directory, in seconds.
+  void setCachePruningInterval(unsigned Interval) {
+    CacheOptions.PruningInterval = Interval;
+  }
+
+  /// Entries that have not been used for \p Expiration seconds are pruned.
+  void setCacheEntryExpiration(unsigned Expiration) {
+    CacheOptions.Expiration = Expiration;
+  }
+
+  /// Maximum total size of the cache directory in bytes, zero for no limit.
+  void setCacheMaxSize(uint64_t Bytes) { CacheOptions.MaxSize = Bytes; }
+
+  /// @}
+
+  /// Set the number of threads used to process the modules. A value of zero
+  /// uses the number of hardware threads available on the host.
+  void setParallelism(unsigned ThreadCount) { Parallelism = ThreadCount; }
+
+  /// Build the combined FunctionInfoIndex out of the summaries of all the
+  /// modules added so far. Modules without a summary are skipped. Returns
+  /// nullptr on error.
+  std::unique_ptr<FunctionInfoIndex> linkCombinedIndex();
+
+  /// Import, optimize and compile every module. On success, the output for
+  /// the I-th module added is available in getProducedBinaries()[I]. Returns
+  /// true on success.
+  bool run();
+
+  /// Return the native objects produced by run(), in module order.
+  std::vector<std::unique_ptr<MemoryBuffer>> &getProducedBinaries() {
+    return ProducedBinaries;
+  }
+
+private:
+  struct ModuleInput {
+    std::string Identifier;
+    StringRef Data;
+    MemoryBufferRef getBuffer() const {
+      return MemoryBufferRef(Data, Identifier);
+    }
+  };
+
+  struct CachingOptions {
+    std::string Path;
+    unsigned PruningInterval = 1200;     // 20 minutes.
+    unsigned Expiration = 7 * 24 * 3600; // One week.
+    uint64_t MaxSize = 0;
+  };
+
+  bool processModule(const ModuleInput &Input, const FunctionInfoIndex &Index,
+                     const StringMap<MemoryBufferRef> &ModuleMap,
+                     std::unique_ptr<MemoryBuffer> &Output,
+                     std::string &ErrMsg);
+  void hashCodeGenOptions(MD5 &Hasher, const TargetMachine &TM);
+  std::string computeLinkCacheKey(const ModuleInput &Input,
+                                  const TargetMachine &TM);
+  std::string computeCacheKey(const ModuleInput &Input,
+                              const FunctionInfoIndex &Index,
+                              const FunctionImporter::ImportListTy &ImportList,
+                              const TargetMachine &TM);
+  std::unique_ptr<TargetMachine> createTargetMachine(StringRef TripleStr,
+                                                     std::string &ErrMsg);
+  void optimizeModule(Module &M, TargetMachine &TM);
+  std::unique_ptr<MemoryBuffer> codegenModule(Module &M, TargetMachine &TM,
+                                              std::string &ErrMsg);
+
+  std::vector<ModuleInput> Modules;
+  std::vector<std::unique_ptr<MemoryBuffer>> ProducedBinaries;
+  /// MD5 of each input module, only computed when caching is enabled.
+  StringMap<std::string> ModuleHashes;
+  /// MD5 of the combined index, only computed when caching is enabled.
+  std::string CombinedIndexHash;
+  CachingOptions CacheOptions;
+  TargetOptions Options;
+  Reloc::Model RelocModel = Reloc::Default;
+  TargetMachine::CodeGenFileType FileType = TargetMachine::CGFT_ObjectFile;
+  std::string MCpu;
+  std::string MAttr;
+  CodeGenOpt::Level CGOptLevel = CodeGenOpt::Default;
+  unsigned OptLevel = 2;
+  unsigned Parallelism = 0;
+};
+}
+#endif
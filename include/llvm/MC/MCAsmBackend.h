@@ -107,6 +107,11 @@ public:
                                             const MCRelaxableFragment *DF,
                                             const MCAsmLayout &Layout) const;
 
+  /// Check whether fixupNeedsRelaxationAdvanced only depends on the value of a
+  /// resolved fixup and has no side effects. If so, the assembler only checks
+  /// a fragment again once the distance to the target of its fixup changed.
+  virtual bool fixupRelaxationOnlyDependsOnValue() const { return false; }
+
   /// Simple predicate for targets where !Resolved implies requiring relaxation
   virtual bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
                                     const MCRelaxableFragment *DF,
@@ -355,6 +355,10 @@ protected:
   /// Compress DWARF debug sections. Defaults to false.
   bool CompressDebugSections;
 
+  /// The number of threads the object writer may use to write the sections.
+  /// Defaults to 1.
+  unsigned ObjectWriterThreads;
+
   /// True if the integrated assembler should interpret 'a >> b' constant
   /// expressions as logical rather than arithmetic.
   bool UseLogicalShr;
@@ -562,6 +566,12 @@ public:
     this->CompressDebugSections = CompressDebugSections;
   }
 
+  unsigned getObjectWriterThreads() const { return ObjectWriterThreads; }
+
+  void setObjectWriterThreads(unsigned ObjectWriterThreads) {
+    this->ObjectWriterThreads = ObjectWriterThreads;
+  }
+
   bool shouldUseLogicalShr() const { return UseLogicalShr; }
 };
 }
@@ -147,6 +147,9 @@ private:
 
   VersionMinInfoType VersionMinInfo;
 
+  /// The stream the relaxation work of each section is reported to, or null.
+  raw_ostream *RelaxationReportOS;
+
 private:
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
@@ -167,22 +170,38 @@ private:
 
   /// Check whether a fixup can be satisfied, or whether it needs to be relaxed
   /// (increased in size, in order to hold its value correctly).
+  ///
+  /// \param Target [out] On return, the relocatable expression the fixup
+  /// evaluates to.
   bool fixupNeedsRelaxation(const MCFixup &Fixup, const MCRelaxableFragment *DF,
-                            const MCAsmLayout &Layout) const;
+                            const MCAsmLayout &Layout, MCValue &Target) const;
 
   /// Check whether the given fragment needs relaxation.
+  ///
+  /// \param Target [out] If the fragment does not need relaxation, this only
+  /// depends on its distance to a fragment of the same section and the backend
+  /// says so through fixupRelaxationOnlyDependsOnValue(), that fragment. Null
+  /// otherwise.
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
-                               const MCAsmLayout &Layout) const;
+                               const MCAsmLayout &Layout,
+                               const MCFragment *&Target) const;
+
+  /// The fragments of a section which may still change size, kept across the
+  /// layout iterations.
+  struct SectionRelaxState;
 
   /// \brief Perform one layout iteration and return true if any offsets
   /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  bool layoutOnce(MCAsmLayout &Layout,
+                  MutableArrayRef<SectionRelaxState> States);
 
   /// \brief Perform one layout iteration of the given section and return true
   /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
+  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                         SectionRelaxState &State);
 
-  bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
+  bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF,
+                        const MCFragment *&Target);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
 
@@ -212,10 +231,15 @@ public:
   /// defining a separate atom.
   bool isSymbolLinkerVisible(const MCSymbol &SD) const;
 
-  /// Emit the section contents using the given object writer.
+  /// Emit the section contents using the object writer of the assembler.
   void writeSectionData(const MCSection *Section,
                         const MCAsmLayout &Layout) const;
 
+  /// Emit the section contents using the given object writer. Different
+  /// sections may be written concurrently with different writers.
+  void writeSectionData(const MCSection *Section, const MCAsmLayout &Layout,
+                        MCObjectWriter &OW) const;
+
   /// Check whether a given symbol has been flagged with .thumb_func.
   bool isThumbFunc(const MCSymbol *Func) const;
 
@@ -284,6 +308,10 @@ public:
   bool getRelaxAll() const { return RelaxAll; }
   void setRelaxAll(bool Value) { RelaxAll = Value; }
 
+  /// Report the layout iterations and relaxation checks of each section with
+  /// relaxable fragments to \p OS once the layout is done. Null disables it.
+  void setRelaxationReport(raw_ostream *OS) { RelaxationReportOS = OS; }
+
   bool isBundlingEnabled() const { return BundleAlignSize != 0; }
 
   unsigned getBundleAlignSize() const { return BundleAlignSize; }
@@ -39,10 +39,12 @@ public:
   const sys::fs::file_status &getStatus() const;
 };
 
+/// Write an archive of NewMembers to ArcName. The symbols of the members that
+/// go in the symbol table are read on up to NumThreads threads.
 std::pair<StringRef, std::error_code>
 writeArchive(StringRef ArcName, std::vector<NewArchiveIterator> &NewMembers,
              bool WriteSymtab, object::Archive::Kind Kind, bool Deterministic,
-             bool Thin);
+             bool Thin, unsigned NumThreads = 1);
 }
 
 #endif
@@ -17,6 +17,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Object/ELF.h"
@@ -196,6 +197,20 @@ protected:
   const Elf_Shdr *DotSymtabSec = nullptr; // Symbol table section.
   ArrayRef<Elf_Word> ShndxTable;
 
+  // The string tables of the symbol tables, looked up once. They stay empty
+  // if the link of their symbol table is invalid.
+  StringRef DotDynSymStrTab;
+  StringRef DotSymtabStrTab;
+
+  /// The sections and the symbols of the symbol table by name. Built by the
+  /// first call to findSection or findSymbol.
+  struct NameIndex {
+    StringMap<const Elf_Shdr *> Sections;
+    StringMap<const Elf_Sym *> Symbols;
+  };
+  mutable std::unique_ptr<NameIndex> Names;
+  const NameIndex &getNameIndex() const;
+
   void moveSymbolNext(DataRefImpl &Symb) const override;
   ErrorOr<StringRef> getSymbolName(DataRefImpl Symb) const override;
   ErrorOr<uint64_t> getSymbolAddress(DataRefImpl Symb) const override;
@@ -310,6 +325,55 @@ public:
     return reinterpret_cast<const Elf_Shdr *>(Sec.p);
   }
 
+  /// \brief The section headers, in the order of the file.
+  ArrayRef<Elf_Shdr> elf_sections() const {
+    return makeArrayRef(EF.section_begin(), EF.section_end());
+  }
+
+  /// \brief The entries of the symbol table, or of the dynamic symbol table
+  /// if \p Dynamic.
+  ArrayRef<Elf_Sym> elf_symbols(bool Dynamic = false) const {
+    const Elf_Shdr *SymTab = Dynamic ? DotDynSymSec : DotSymtabSec;
+    if (!SymTab)
+      return None;
+    return makeArrayRef(EF.symbol_begin(SymTab), EF.symbol_end(SymTab));
+  }
+
+  /// \brief The name of an entry of the symbol table, or of the dynamic
+  /// symbol table if \p Dynamic.
+  ErrorOr<StringRef> getSymbolName(const Elf_Sym &Sym,
+                                   bool Dynamic = false) const {
+    return Sym.getName(Dynamic ? DotDynSymStrTab : DotSymtabStrTab);
+  }
+
+  /// \brief The relocations of a SHT_REL section.
+  ArrayRef<Elf_Rel> getRels(const Elf_Shdr *RelSec) const {
+    assert(RelSec->sh_type == ELF::SHT_REL);
+    return makeArrayRef(EF.rel_begin(RelSec), EF.rel_end(RelSec));
+  }
+
+  /// \brief The relocations of a SHT_RELA section.
+  ArrayRef<Elf_Rela> getRelas(const Elf_Shdr *RelSec) const {
+    assert(RelSec->sh_type == ELF::SHT_RELA);
+    return makeArrayRef(EF.rela_begin(RelSec), EF.rela_end(RelSec));
+  }
+
+  /// \brief Find the first section named \p Name, or return null.
+  ///
+  /// The first call to findSection or findSymbol indexes the sections and
+  /// symbols by name, the later ones are hash lookups. Like the rest of the
+  /// object, the index is not meant to be shared between threads.
+  const Elf_Shdr *findSection(StringRef Name) const {
+    return getNameIndex().Sections.lookup(Name);
+  }
+
+  /// \brief Find the symbol named \p Name in the symbol table, or return
+  /// null. If there are several, this is the first global or weak one, or
+  /// the first local one if there is none. See findSection about the cost.
+  const Elf_Sym *findSymbol(StringRef Name) const {
+    return getNameIndex().Symbols.lookup(Name);
+  }
+
   basic_symbol_iterator symbol_begin_impl() const override;
   basic_symbol_iterator symbol_end_impl() const override;
 
@@ -357,6 +421,10 @@ template <class ELFT>
 ErrorOr<StringRef> ELFObjectFile<ELFT>::getSymbolName(DataRefImpl Sym) const {
   const Elf_Sym *ESym = getSymbol(Sym);
   const Elf_Shdr *SymTableSec = *EF.getSection(Sym.d.a);
+  if (SymTableSec == DotSymtabSec && DotSymtabStrTab.data())
+    return ESym->getName(DotSymtabStrTab);
+  if (SymTableSec == DotDynSymSec && DotDynSymStrTab.data())
+    return ESym->getName(DotDynSymStrTab);
   const Elf_Shdr *StringTableSec = *EF.getSection(SymTableSec->sh_link);
   StringRef SymTable = *EF.getStringTable(StringTableSec);
   return ESym->getName(SymTable);
@@ -772,6 +840,44 @@ ELFObjectFile<ELFT>::ELFObjectFile(MemoryBufferRef Object, std::error_code &EC)
     }
     }
   }
+
+  // Errors are reported when the names are looked up.
+  if (DotSymtabSec) {
+    ErrorOr<StringRef> StrTabOrErr = EF.getStringTableForSymtab(*DotSymtabSec);
+    if (StrTabOrErr)
+      DotSymtabStrTab = *StrTabOrErr;
+  }
+  if (DotDynSymSec) {
+    ErrorOr<StringRef> StrTabOrErr = EF.getStringTableForSymtab(*DotDynSymSec);
+    if (StrTabOrErr)
+      DotDynSymStrTab = *StrTabOrErr;
+  }
+}
+
+template <class ELFT>
+const typename ELFObjectFile<ELFT>::NameIndex &
+ELFObjectFile<ELFT>::getNameIndex() const {
+  if (Names)
+    return *Names;
+  Names.reset(new NameIndex);
+
+  for (const Elf_Shdr &Sec : elf_sections()) {
+    ErrorOr<StringRef> NameOrErr = EF.getSectionName(&Sec);
+    if (NameOrErr && !NameOrErr->empty())
+      Names->Sections.insert(std::make_pair(*NameOrErr, &Sec));
+  }
+
+  for (const Elf_Sym &Sym : elf_symbols()) {
+    ErrorOr<StringRef> NameOrErr = getSymbolName(Sym);
+    if (!NameOrErr || NameOrErr->empty())
+      continue;
+    auto P = Names->Symbols.insert(std::make_pair(*NameOrErr, &Sym));
+    // Let the first global or weak symbol replace the local ones.
+    if (!P.second && P.first->second->getBinding() == ELF::STB_LOCAL &&
+        Sym.getBinding() != ELF::STB_LOCAL)
+      P.first->second = &Sym;
+  }
+  return *Names;
 }
 
 template <class ELFT>
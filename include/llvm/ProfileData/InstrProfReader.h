@@ -25,6 +25,7 @@
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/raw_ostream.h"
 #include <iterator>
+#include <memory>
 
 namespace llvm {
 
@@ -229,6 +230,16 @@ namespace IndexedInstrProf {
 enum class HashT : uint32_t;
 }
 
+/// A view of a function record in an indexed profile. The name and the
+/// counters point straight into the profile buffer, so the view is only valid
+/// while the reader that returned it is alive. Value profile data is not
+/// decoded.
+struct InstrProfRecordRef {
+  StringRef Name;
+  uint64_t Hash;
+  ArrayRef<support::ulittle64_t> Counts;
+};
+
 /// Trait for lookups into the on-disk hash table for the binary instrprof
 /// format.
 class InstrProfLookupTrait {
@@ -274,6 +285,13 @@ public:
                               const unsigned char *const End);
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 
+  /// Find the record with hash \p FuncHash among the records stored for key
+  /// \p K without decoding any of them. Unlike ReadData this does not touch
+  /// the trait's state and so can be used from several threads at once.
+  std::error_code findRecordRef(StringRef K, const unsigned char *D,
+                                offset_type N, uint64_t FuncHash,
+                                InstrProfRecordRef &Record) const;
+
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     ValueProfDataEndianness = Endianness;
@@ -287,6 +305,10 @@ struct InstrProfReaderIndexBase {
   // Read all the profile records with the key equal to FuncName
   virtual std::error_code getRecords(StringRef FuncName,
                                      ArrayRef<InstrProfRecord> &Data) = 0;
+  // Find the profile record with the key equal to FuncName and the given hash
+  // without copying it out of the profile.
+  virtual std::error_code getRecordRef(StringRef FuncName, uint64_t FuncHash,
+                                       InstrProfRecordRef &Record) = 0;
   virtual void advanceToNextKey() = 0;
   virtual bool atEnd() const = 0;
   virtual void setValueProfDataEndianness(support::endianness Endianness) = 0;
@@ -315,6 +337,8 @@ public:
   std::error_code getRecords(ArrayRef<InstrProfRecord> &Data) override;
   std::error_code getRecords(StringRef FuncName,
                              ArrayRef<InstrProfRecord> &Data) override;
+  std::error_code getRecordRef(StringRef FuncName, uint64_t FuncHash,
+                               InstrProfRecordRef &Record) override;
   void advanceToNextKey() override { RecordIterator++; }
   bool atEnd() const override {
     return RecordIterator == HashTable->data_end();
@@ -360,6 +384,13 @@ public:
   ErrorOr<InstrProfRecord> getInstrProfRecord(StringRef FuncName,
                                               uint64_t FuncHash);
 
+  /// Return a view of the record associated with FuncName and FuncHash that
+  /// refers directly into the profile buffer. This neither copies the
+  /// counters nor decodes value profile data, and unlike the other lookup
+  /// methods it may be called from several threads at once.
+  ErrorOr<InstrProfRecordRef> getInstrProfRecordRef(StringRef FuncName,
+                                                    uint64_t FuncHash);
+
   /// Fill Counts with the profile data for the given function name.
   std::error_code getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                                     std::vector<uint64_t> &Counts);
@@ -374,6 +405,18 @@ public:
   static ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
   create(std::unique_ptr<MemoryBuffer> Buffer);
 
+  /// Return the reader for the indexed profile at Path that is shared by
+  /// everything in this process, creating it on first use. The profile is
+  /// mapped and its header read only once, and is read again only if the
+  /// file changes on disk. Readers of files that were changed or removed are
+  /// dropped from the cache by the next call. Shared readers should only be
+  /// queried through getInstrProfRecordRef and getMaximumFunctionCount.
+  ///
+  /// Nothing is shared between processes beyond the page cache, which
+  /// already backs the mapping of every process reading the profile.
+  static ErrorOr<std::shared_ptr<IndexedInstrProfReader>>
+  getShared(StringRef Path);
+
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     Index->setValueProfDataEndianness(Endianness);
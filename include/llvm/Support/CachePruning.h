@@ -0,0 +1,80 @@
+//=- CachePruning.h - Helper to manage the pruning of a cache dir -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements pruning of a directory intended for cache storage,
+// using various policies: a minimum interval between two pruning runs, an
+// expiration delay for the entries, and a maximum total size.
+//
+// The directory may be shared by several processes: entries are only ever
+// removed, never rewritten, so a concurrent reader either opens a complete
+// file or does not find it and regenerates it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CACHE_PRUNING_H
+#define LLVM_SUPPORT_CACHE_PRUNING_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+
+namespace llvm {
+
+/// Handle pruning a directory provided a path and some options to control what
+/// to prune. Only files whose name starts with "llvmcache-" are considered.
+/// Lock files and temporary files being written ("*.lock*" and "*.tmp") are
+/// left alone by the size-based pruning, and only removed once expired.
+class CachePruning {
+public:
+  /// Prepare to prune \p Path.
+  CachePruning(StringRef Path) : Path(Path) {}
+
+  /// Define the pruning interval, in seconds. This is intended to be used to
+  /// avoid scanning the directory too often. It does not impact the decision
+  /// of which file to prune. A value of 0 forces the scan to occur.
+  CachePruning &setPruningInterval(unsigned PruningInterval) {
+    Interval = PruningInterval;
+    return *this;
+  }
+
+  /// Define the expiration for a file, in seconds. When a file hasn't been
+  /// used for \p ExpireAfter seconds, it is removed from the cache. A value
+  /// of 0 disables the expiration-based pruning.
+  CachePruning &setEntryExpiration(unsigned ExpireAfter) {
+    Expiration = ExpireAfter;
+    return *this;
+  }
+
+  /// Define the maximum total size of the cache directory, in bytes. When the
+  /// cache grows bigger, the least recently used entries are removed until it
+  /// fits. A value of 0 disables the size-based pruning.
+  CachePruning &setMaxSize(uint64_t Bytes) {
+    MaxSize = Bytes;
+    return *this;
+  }
+
+  /// Peform pruning using the supplied options, returns true if pruning
+  /// occurred, i.e. if Interval was elapsed.
+  bool prune();
+
+  /// Mark the cache entry at \p EntryPath as used now, so that it is not
+  /// pruned before entries that were used less recently.
+  static void touch(StringRef EntryPath);
+
+private:
+  // Options that matches the setters above.
+  SmallString<128> Path;
+  unsigned Expiration = 0;
+  unsigned Interval = 0;
+  uint64_t MaxSize = 0;
+};
+
+} // namespace llvm
+
+#endif
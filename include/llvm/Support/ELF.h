@@ -1294,6 +1294,14 @@ enum {
   VER_NEED_CURRENT = 1
 };
 
+// Note types of the notes owned by "GNU".
+enum {
+  NT_GNU_ABI_TAG = 1,
+  NT_GNU_HWCAP = 2,
+  NT_GNU_BUILD_ID = 3,
+  NT_GNU_GOLD_VERSION = 4
+};
+
 } // end namespace ELF
 
 } // end namespace llvm
@@ -33,6 +33,7 @@
 #pragma warning(pop)
 #endif
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
@@ -132,6 +133,23 @@ private:
   bool EnableFlag;
 #endif
 };
+
+/// Split [0, \p N) into at most \p MaxBatches contiguous batches of about the
+/// same size, call \p Fn(Batch, Begin, End) for each of them on the threads of
+/// \p Pool, and wait for the pool to be done. Batches are numbered from 0, so
+/// callers can keep state per batch. Batching keeps the number of tasks low
+/// when there are many cheap indices.
+template <typename Function>
+void parallelForBatches(ThreadPool &Pool, size_t N, size_t MaxBatches,
+                        Function Fn) {
+  size_t NumBatches = std::min(N, MaxBatches);
+  for (size_t Batch = 0; Batch != NumBatches; ++Batch) {
+    size_t Begin = N * Batch / NumBatches;
+    size_t End = N * (Batch + 1) / NumBatches;
+    Pool.async([&Fn, Batch, Begin, End] { Fn(Batch, Begin, End); });
+  }
+  Pool.wait();
+}
 }
 
 #endif // LLVM_SUPPORT_THREAD_POOL_H
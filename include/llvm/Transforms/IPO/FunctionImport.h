@@ -12,6 +12,9 @@
 
 #include "llvm/ADT/StringMap.h"
 #include <functional>
+#include <map>
+#include <set>
+#include <string>
 
 namespace llvm {
 class LLVMContext;
@@ -21,11 +24,18 @@ class FunctionInfoIndex;
 /// The function importer is automatically importing function from other modules
 /// based on the provided summary informations.
 class FunctionImporter {
+public:
+  /// The set of functions that were imported, keyed by the identifier of the
+  /// module they were imported from. Ordered, so that it can be used to build
+  /// a stable key, e.g. for caching the result of the ThinLTO backends.
+  typedef std::map<std::string, std::set<std::string>> ImportListTy;
 
+private:
   /// The summaries index used to trigger importing.
   const FunctionInfoIndex &Index;
 
-  /// Factory function to load a Module for a given identifier
+  /// Factory function to load a Module for a given identifier. It returns
+  /// nullptr if the module can't be loaded, nothing is imported from it then.
   std::function<std::unique_ptr<Module>(StringRef Identifier)> ModuleLoader;
 
 public:
@@ -35,8 +45,9 @@ public:
       std::function<std::unique_ptr<Module>(StringRef Identifier)> ModuleLoader)
       : Index(Index), ModuleLoader(ModuleLoader) {}
 
-  /// Import functions in Module \p M based on the summary informations.
-  bool importFunctions(Module &M);
+  /// Import functions in Module \p M based on the summary informations. If
+  /// \p ImportList is non-null, it is filled with the imported functions.
+  bool importFunctions(Module &M, ImportListTy *ImportList = nullptr);
 };
 }
 
@@ -27,6 +27,22 @@ class StringRef;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// By default, local symbols are externalized (with hidden visibility) and
+/// global values are assigned to partitions by the hash of their name.
+///
+/// If \p PreserveLocals is true, local symbols are kept local instead: every
+/// local is placed in the same partition as all the globals referencing it,
+/// comdat members and aliases stay together, and the resulting clusters are
+/// assigned to partitions so as to balance their instruction count. The
+/// assignment is deterministic for a given module.
+///
+/// If \p PreserveOrder is true, locals are kept local as for \p PreserveLocals,
+/// but the clusters are assigned to partitions as contiguous runs in module
+/// order, so that partition I only contains definitions that appear in the
+/// module before those of partition I+1, except for the members of a cluster,
+/// which follow its first member. Linking the partitions in order then lays
+/// out the definitions as if the module had not been split.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
@@ -36,7 +52,8 @@ class StringRef;
 ///   each partition.
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
-    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback);
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback,
+    bool PreserveLocals = false, bool PreserveOrder = false);
 
 } // End llvm namespace
 
@@ -24,12 +24,14 @@
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/DataStream.h"
+#include "llvm/Support/Errc.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -631,6 +633,17 @@ static bool convertToString(ArrayRef<uint64_t> Record, unsigned Idx,
   return false;
 }
 
+/// Decode the alignment \p Exponent of a record into \p Alignment. Returns
+/// true if it is out of range.
+static bool decodeAlignment(uint64_t Exponent, unsigned &Alignment) {
+  // Note: Alignment in bitcode files is incremented by 1, so that zero
+  // can be used for default alignment.
+  if (Exponent > Value::MaxAlignmentExponent + 1)
+    return true;
+  Alignment = (1 << static_cast<unsigned>(Exponent)) >> 1;
+  return false;
+}
+
 static bool hasImplicitComdat(size_t Val) {
   switch (Val) {
   default:
@@ -1318,11 +1331,8 @@ static Attribute::AttrKind getAttrFromCode(uint64_t Code) {
 
 std::error_code BitcodeReader::parseAlignmentValue(uint64_t Exponent,
                                                    unsigned &Alignment) {
-  // Note: Alignment in bitcode files is incremented by 1, so that zero
-  // can be used for default alignment.
-  if (Exponent > Value::MaxAlignmentExponent + 1)
+  if (decodeAlignment(Exponent, Alignment))
     return error("Invalid alignment value");
-  Alignment = (1 << static_cast<unsigned>(Exponent)) >> 1;
   return std::error_code();
 }
 
@@ -6001,3 +6011,363 @@ std::error_code llvm::readFunctionSummary(
   Buf.release(); // The FunctionIndexBitcodeReader owns it now.
   return std::error_code();
 }
+
+namespace {
+/// The records of a global value that readBitcodeSymbols needs to describe
+/// it as a symbol.
+struct GlobalValueRecord {
+  enum KindTy { Function, Variable, Alias } Kind;
+  GlobalValue::LinkageTypes Linkage;
+  GlobalValue::VisibilityTypes Visibility;
+  bool IsDeclaration;
+  unsigned CallingConv;
+  unsigned SectionID;
+  unsigned Alignment;
+  /// One plus the index of the comdat, zero if there is none, or
+  /// ImplicitComdat for old bitcode where the comdat is named after the value.
+  unsigned ComdatID;
+  std::string Name;
+
+  enum : unsigned { ImplicitComdat = ~0U };
+};
+}
+
+// Read the symbol table block that the writer emits for the linker.
+static std::error_code readSymbolTable(BitstreamCursor &Stream,
+                                       std::vector<BitcodeSymbol> &Symbols) {
+  if (Stream.EnterSubBlock(bitc::SYMTAB_BLOCK_ID))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+
+  std::vector<std::string> Comdats;
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: // Default behavior: ignore.
+      break;
+    case bitc::SYMTAB_CODE_COMDAT: { // COMDAT: [namechar x N]
+      std::string Name;
+      if (convertToString(Record, 0, Name))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      Comdats.push_back(std::move(Name));
+      break;
+    }
+    // ENTRY: [linkage, visibility, flags, comdat, commonsize, commonalign,
+    //         namechar x N]
+    case bitc::SYMTAB_CODE_ENTRY: {
+      if (Record.size() < 6 || Record[3] > Comdats.size())
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      BitcodeSymbol S;
+      S.Linkage = getDecodedLinkage(Record[0]);
+      S.Visibility = getDecodedVisibility(Record[1]);
+      S.IsDeclaration = Record[2] & bitc::SYMTAB_FLAG_UNDEFINED;
+      S.IsFormatSpecific = Record[2] & bitc::SYMTAB_FLAG_FORMAT_SPECIFIC;
+      S.CanBeOmittedFromSymbolTable =
+          Record[2] & bitc::SYMTAB_FLAG_CAN_BE_OMITTED;
+      if (Record[3])
+        S.Comdat = Comdats[Record[3] - 1];
+      S.CommonSize = Record[4];
+      S.CommonAlign = Record[5];
+      if (convertToString(Record, 6, S.Name))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      Symbols.push_back(std::move(S));
+      break;
+    }
+    }
+  }
+}
+
+// Read the module-level value symbol table, which names the global values.
+static std::error_code
+readGlobalValueNames(BitstreamCursor &Stream,
+                     std::vector<GlobalValueRecord> &Values) {
+  if (Stream.EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    unsigned NameIdx;
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: // Default behavior: ignore (e.g. VST_CODE_BBENTRY records).
+      continue;
+    case bitc::VST_CODE_ENTRY: // VST_ENTRY: [valueid, namechar x N]
+      NameIdx = 1;
+      break;
+    case bitc::VST_CODE_FNENTRY: // VST_FNENTRY: [valueid, offset, namechar x N]
+      NameIdx = 2;
+      break;
+    }
+    // Only the global values matter, the other entries name constants.
+    if (Record.empty() || Record[0] >= Values.size())
+      continue;
+    std::string &Name = Values[Record[0]].Name;
+    Name.clear();
+    if (convertToString(Record, NameIdx, Name))
+      return make_error_code(BitcodeError::CorruptedBitcode);
+  }
+}
+
+ErrorOr<std::vector<BitcodeSymbol>>
+llvm::readBitcodeSymbols(MemoryBufferRef Buffer, bool *HasSymbolTable) {
+  if (HasSymbolTable)
+    *HasSymbolTable = false;
+  const unsigned char *BufPtr = (const unsigned char *)Buffer.getBufferStart();
+  const unsigned char *BufEnd = BufPtr + Buffer.getBufferSize();
+  if (Buffer.getBufferSize() & 3)
+    return make_error_code(BitcodeError::InvalidBitcodeSignature);
+  if (isBitcodeWrapper(BufPtr, BufEnd))
+    if (SkipBitcodeWrapperHeader(BufPtr, BufEnd, true))
+      return make_error_code(BitcodeError::InvalidBitcodeSignature);
+
+  BitstreamReader StreamFile(BufPtr, BufEnd);
+  BitstreamCursor Stream(StreamFile);
+  if (!hasValidBitcodeHeader(Stream))
+    return make_error_code(BitcodeError::InvalidBitcodeSignature);
+
+  // Find the module block.
+  while (1) {
+    if (Stream.AtEndOfStream())
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    BitstreamEntry Entry =
+        Stream.advance(BitstreamCursor::AF_DontAutoprocessAbbrevs);
+    if (Entry.Kind != BitstreamEntry::SubBlock)
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    if (Entry.ID == bitc::MODULE_BLOCK_ID)
+      break;
+    if (Stream.SkipBlock())
+      return make_error_code(BitcodeError::CorruptedBitcode);
+  }
+  if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+
+  // The global values are the first values of the module, numbered in the
+  // order of their records.
+  std::vector<GlobalValueRecord> Values;
+  std::vector<std::string> SectionTable;
+  std::vector<std::string> ComdatTable;
+  std::string DataLayoutStr;
+  SmallVector<uint64_t, 64> Record;
+  bool Done = false;
+  while (!Done) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    case BitstreamEntry::EndBlock:
+      Done = true;
+      continue;
+    case BitstreamEntry::SubBlock:
+      switch (Entry.ID) {
+      default: // Skip the function bodies and everything else.
+        if (Stream.SkipBlock())
+          return make_error_code(BitcodeError::CorruptedBitcode);
+        break;
+      case bitc::BLOCKINFO_BLOCK_ID:
+        // Need to parse these to get abbrev ids (e.g. for VST)
+        if (Stream.ReadBlockInfoBlock())
+          return make_error_code(BitcodeError::CorruptedBitcode);
+        break;
+      case bitc::VALUE_SYMTAB_BLOCK_ID:
+        if (std::error_code EC = readGlobalValueNames(Stream, Values))
+          return EC;
+        break;
+      case bitc::SYMTAB_BLOCK_ID: {
+        // The symbol table has everything, stop reading the module here.
+        std::vector<BitcodeSymbol> Symbols;
+        if (std::error_code EC = readSymbolTable(Stream, Symbols))
+          return EC;
+        if (HasSymbolTable)
+          *HasSymbolTable = true;
+        return std::move(Symbols);
+      }
+      }
+      continue;
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    switch (BitCode) {
+    default:
+      break;
+    case bitc::MODULE_CODE_DATALAYOUT: // DATALAYOUT: [strchr x N]
+      if (convertToString(Record, 0, DataLayoutStr))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      break;
+    case bitc::MODULE_CODE_ASM: // ASM: [strchr x N]
+      if (!Record.empty())
+        return make_error_code(errc::function_not_supported);
+      break;
+    case bitc::MODULE_CODE_SECTIONNAME: { // SECTIONNAME: [strchr x N]
+      std::string S;
+      if (convertToString(Record, 0, S))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      SectionTable.push_back(S);
+      break;
+    }
+    case bitc::MODULE_CODE_COMDAT: { // COMDAT: [selection_kind, name]
+      if (Record.size() < 2 || Record.size() < 2 + Record[1])
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      std::string Name;
+      for (unsigned i = 0; i != Record[1]; ++i)
+        Name += (char)Record[2 + i];
+      ComdatTable.push_back(std::move(Name));
+      break;
+    }
+    // GLOBALVAR: [pointer type, isconst, initid,
+    //             linkage, alignment, section, visibility, threadlocal,
+    //             unnamed_addr, externally_initialized, dllstorageclass,
+    //             comdat]
+    case bitc::MODULE_CODE_GLOBALVAR: {
+      if (Record.size() < 6)
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      GlobalValueRecord V;
+      V.Kind = GlobalValueRecord::Variable;
+      V.Linkage = getDecodedLinkage(Record[3]);
+      V.Visibility = Record.size() > 6 && !GlobalValue::isLocalLinkage(V.Linkage)
+                         ? getDecodedVisibility(Record[6])
+                         : GlobalValue::DefaultVisibility;
+      V.IsDeclaration = !Record[2];
+      V.CallingConv = CallingConv::C;
+      V.SectionID = Record[5];
+      if (decodeAlignment(Record[4], V.Alignment))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      V.ComdatID = Record.size() > 11 ? Record[11]
+                   : hasImplicitComdat(Record[3])
+                       ? GlobalValueRecord::ImplicitComdat
+                       : 0;
+      Values.push_back(V);
+      break;
+    }
+    // FUNCTION:  [type, callingconv, isproto, linkage, paramattr,
+    //             alignment, section, visibility, gc, unnamed_addr,
+    //             prologuedata, dllstorageclass, comdat, prefixdata]
+    case bitc::MODULE_CODE_FUNCTION: {
+      if (Record.size() < 8)
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      GlobalValueRecord V;
+      V.Kind = GlobalValueRecord::Function;
+      V.Linkage = getDecodedLinkage(Record[3]);
+      V.Visibility = !GlobalValue::isLocalLinkage(V.Linkage)
+                         ? getDecodedVisibility(Record[7])
+                         : GlobalValue::DefaultVisibility;
+      V.IsDeclaration = Record[2];
+      V.CallingConv = Record[1];
+      V.SectionID = Record[6];
+      if (decodeAlignment(Record[5], V.Alignment))
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      V.ComdatID = Record.size() > 12 ? Record[12]
+                   : hasImplicitComdat(Record[3])
+                       ? GlobalValueRecord::ImplicitComdat
+                       : 0;
+      Values.push_back(V);
+      break;
+    }
+    // ALIAS: [alias type, addrspace, aliasee val#, linkage]
+    // ALIAS: [alias type, addrspace, aliasee val#, linkage, visibility, dllstorageclass]
+    case bitc::MODULE_CODE_ALIAS:
+    case bitc::MODULE_CODE_ALIAS_OLD: {
+      unsigned OpNum = BitCode == bitc::MODULE_CODE_ALIAS ? 3 : 2;
+      if (Record.size() < OpNum + 1)
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      GlobalValueRecord V;
+      V.Kind = GlobalValueRecord::Alias;
+      V.Linkage = getDecodedLinkage(Record[OpNum++]);
+      V.Visibility = GlobalValue::DefaultVisibility;
+      if (OpNum != Record.size() && !GlobalValue::isLocalLinkage(V.Linkage))
+        V.Visibility = getDecodedVisibility(Record[OpNum]);
+      V.IsDeclaration = false;
+      V.CallingConv = CallingConv::C;
+      V.SectionID = 0;
+      V.Alignment = 0;
+      // The comdat of an alias is the one of its aliasee, which is only known
+      // with the IR.
+      V.ComdatID = 0;
+      Values.push_back(V);
+      break;
+    }
+    }
+  }
+
+  DataLayout DL(DataLayoutStr);
+  std::vector<BitcodeSymbol> Symbols;
+  Symbols.reserve(Values.size());
+  for (auto Kind : {GlobalValueRecord::Function, GlobalValueRecord::Variable,
+                    GlobalValueRecord::Alias}) {
+    for (const GlobalValueRecord &V : Values) {
+      if (V.Kind != Kind)
+        continue;
+      BitcodeSymbol S;
+      S.Linkage = V.Linkage;
+      S.Visibility = V.Visibility;
+      S.IsDeclaration = V.IsDeclaration ||
+                        V.Linkage == GlobalValue::AvailableExternallyLinkage;
+      S.IsFormatSpecific = V.Linkage == GlobalValue::PrivateLinkage ||
+                           StringRef(V.Name).startswith("llvm.");
+      if (V.ComdatID == GlobalValueRecord::ImplicitComdat)
+        S.Comdat = V.Name;
+      else if (V.ComdatID) {
+        if (V.ComdatID > ComdatTable.size())
+          return make_error_code(BitcodeError::CorruptedBitcode);
+        S.Comdat = ComdatTable[V.ComdatID - 1];
+      }
+      S.CommonSize = 0;
+      S.CommonAlign =
+          V.Linkage == GlobalValue::CommonLinkage ? V.Alignment : 0;
+      S.CanBeOmittedFromSymbolTable = false;
+      if (V.SectionID) {
+        if (V.SectionID - 1 >= SectionTable.size())
+          return make_error_code(BitcodeError::CorruptedBitcode);
+        if (Kind == GlobalValueRecord::Variable &&
+            SectionTable[V.SectionID - 1] == "llvm.metadata")
+          S.IsFormatSpecific = true;
+      }
+
+      // The Mangler needs the Function to mangle the names that use the
+      // Microsoft calling conventions, and numbers the unnamed values.
+      bool HasMSMangling =
+          Kind == GlobalValueRecord::Function &&
+          !StringRef(V.Name).startswith("\1") &&
+          (V.CallingConv == CallingConv::X86_VectorCall ||
+           (DL.hasMicrosoftFastStdCallMangling() &&
+            (V.CallingConv == CallingConv::X86_StdCall ||
+             V.CallingConv == CallingConv::X86_FastCall)));
+      if (!GlobalValue::isLocalLinkage(V.Linkage) &&
+          (HasMSMangling || V.Name.empty()))
+        return make_error_code(errc::function_not_supported);
+      if (!V.Name.empty()) {
+        raw_string_ostream OS(S.Name);
+        Mangler::getNameWithPrefix(OS, V.Name, DL);
+      }
+      Symbols.push_back(std::move(S));
+    }
+  }
+  return std::move(Symbols);
+}
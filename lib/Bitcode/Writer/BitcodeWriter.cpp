@@ -14,6 +14,7 @@
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "ValueEnumerator.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
@@ -25,6 +26,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/UseListOrder.h"
@@ -2889,10 +2891,176 @@ static void WriteIdentificationBlock(const Module *M, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+/// Return true if \p V, the address of a global value or a value derived from
+/// it, is only loaded from, stored to, or called. This accepts the uses that
+/// GlobalStatus::analyzeGlobal accepts without setting IsCompared, except for
+/// dead constants.
+static bool isAddressInsignificant(const Value *V,
+                                   SmallPtrSetImpl<const PHINode *> &PHIs) {
+  for (const Use &U : V->uses()) {
+    const User *UR = U.getUser();
+    if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(UR)) {
+      if (!CE->getType()->isPointerTy() || !isAddressInsignificant(CE, PHIs))
+        return false;
+    } else if (const LoadInst *LI = dyn_cast<LoadInst>(UR)) {
+      if (LI->isVolatile())
+        return false;
+    } else if (const StoreInst *SI = dyn_cast<StoreInst>(UR)) {
+      if (SI->getValueOperand() == V || SI->isVolatile())
+        return false;
+    } else if (isa<BitCastInst>(UR) || isa<GetElementPtrInst>(UR) ||
+               isa<SelectInst>(UR)) {
+      if (!isAddressInsignificant(UR, PHIs))
+        return false;
+    } else if (const PHINode *PN = dyn_cast<PHINode>(UR)) {
+      if (PHIs.insert(PN).second && !isAddressInsignificant(PN, PHIs))
+        return false;
+    } else if (const MemIntrinsic *MI = dyn_cast<MemIntrinsic>(UR)) {
+      if (MI->isVolatile())
+        return false;
+    } else if (ImmutableCallSite CS = ImmutableCallSite(UR)) {
+      if (!CS.isCallee(&U))
+        return false;
+    } else {
+      // Comparisons and anything else that may take the address.
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Return true if the linker may hide \p GV. This is what
+/// canBeOmittedFromSymbolTable in CodeGen computes, which the bitcode writer
+/// cannot depend on.
+static bool canBeOmittedFromSymbolTable(const GlobalValue &GV) {
+  if (!GV.hasLinkOnceODRLinkage())
+    return false;
+  if (GV.hasUnnamedAddr())
+    return true;
+  if (const GlobalVariable *Var = dyn_cast<GlobalVariable>(&GV))
+    if (!Var->isConstant())
+      return false;
+  if (isa<GlobalAlias>(GV) || GV.getParent()->getMaterializer())
+    return false;
+  SmallPtrSet<const PHINode *, 16> PHIs;
+  return isAddressInsignificant(&GV, PHIs);
+}
+
+/// Emit the symbol table block, which describes the global values of the
+/// module the way IRObjectFile presents them as symbols.
+static void WriteSymbolTable(const Module *M, BitstreamWriter &Stream) {
+  // The symbols defined by module-level inline asm can only be found by the
+  // target's asm parser, which the linker has to run on the IR anyway.
+  if (!M->getModuleInlineAsm().empty())
+    return;
+
+  Stream.EnterSubblock(bitc::SYMTAB_BLOCK_ID, 3);
+
+  // 8-bit fixed-width SYMTAB_CODE_COMDAT strings.
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_CODE_COMDAT));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  unsigned ComdatAbbrev = Stream.EmitAbbrev(Abbv);
+
+  // 8-bit fixed-width SYMTAB_CODE_ENTRY strings.
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_CODE_ENTRY));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // linkage
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 2)); // visibility
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 4)); // flags
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // comdat
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // commonsize
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // commonalign
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  unsigned Entry8BitAbbrev = Stream.EmitAbbrev(Abbv);
+
+  // 6-bit char6 SYMTAB_CODE_ENTRY strings.
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_CODE_ENTRY));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // linkage
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 2)); // visibility
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 4)); // flags
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // comdat
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // commonsize
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // commonalign
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+  unsigned Entry6BitAbbrev = Stream.EmitAbbrev(Abbv);
+
+  // Same order as the symbols of an IRObjectFile, which also determines how
+  // the Mangler numbers the unnamed values.
+  std::vector<const GlobalValue *> Values;
+  for (const Function &F : *M)
+    Values.push_back(&F);
+  for (const GlobalVariable &GV : M->globals())
+    Values.push_back(&GV);
+  for (const GlobalAlias &GA : M->aliases())
+    Values.push_back(&GA);
+
+  // COMDAT: [namechar x N]
+  SmallVector<uint64_t, 64> Vals;
+  DenseMap<const Comdat *, unsigned> ComdatIDs;
+  for (const GlobalValue *GV : Values) {
+    const Comdat *C = GV->getComdat();
+    if (!C || !ComdatIDs.insert(std::make_pair(C, ComdatIDs.size() + 1)).second)
+      continue;
+    for (char Chr : C->getName())
+      Vals.push_back((unsigned char)Chr);
+    Stream.EmitRecord(bitc::SYMTAB_CODE_COMDAT, Vals, ComdatAbbrev);
+    Vals.clear();
+  }
+
+  // ENTRY: [linkage, visibility, flags, comdat, commonsize, commonalign,
+  //         namechar x N]
+  const DataLayout &DL = M->getDataLayout();
+  Mangler Mang;
+  SmallString<64> Name;
+  for (const GlobalValue *GV : Values) {
+    Name.clear();
+    raw_svector_ostream OS(Name);
+    Mang.getNameWithPrefix(OS, GV, false);
+
+    unsigned Flags = 0;
+    if (GV->isDeclarationForLinker())
+      Flags |= bitc::SYMTAB_FLAG_UNDEFINED;
+    auto *GVar = dyn_cast<GlobalVariable>(GV);
+    if (GV->hasPrivateLinkage() || GV->getName().startswith("llvm.") ||
+        (GVar && GVar->getSection() == StringRef("llvm.metadata")))
+      Flags |= bitc::SYMTAB_FLAG_FORMAT_SPECIFIC;
+    if (canBeOmittedFromSymbolTable(*GV))
+      Flags |= bitc::SYMTAB_FLAG_CAN_BE_OMITTED;
+
+    Vals.push_back(getEncodedLinkage(*GV));
+    Vals.push_back(GV->hasLocalLinkage() ? 0 : getEncodedVisibility(*GV));
+    Vals.push_back(Flags);
+    Vals.push_back(GV->hasComdat() ? ComdatIDs[GV->getComdat()] : 0);
+    if (GV->hasCommonLinkage()) {
+      Vals.push_back(DL.getTypeAllocSize(GV->getValueType()));
+      Vals.push_back(GVar->getAlignment());
+    } else {
+      Vals.push_back(0);
+      Vals.push_back(0);
+    }
+    for (char Chr : Name)
+      Vals.push_back((unsigned char)Chr);
+
+    unsigned AbbrevToUse = Entry8BitAbbrev;
+    if (getStringEncoding(Name.data(), Name.size()) == SE_Char6)
+      AbbrevToUse = Entry6BitAbbrev;
+    Stream.EmitRecord(bitc::SYMTAB_CODE_ENTRY, Vals, AbbrevToUse);
+    Vals.clear();
+  }
+
+  Stream.ExitBlock();
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream,
                         bool ShouldPreserveUseListOrder,
-                        uint64_t BitcodeStartBit, bool EmitFunctionSummary) {
+                        uint64_t BitcodeStartBit, bool EmitFunctionSummary,
+                        bool EmitSymbolTable) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
 
   SmallVector<unsigned, 1> Vals;
@@ -2900,6 +3068,11 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   Vals.push_back(CurVersion);
   Stream.EmitRecord(bitc::MODULE_CODE_VERSION, Vals);
 
+  // Emit the symbol table first, so that readers looking only for the
+  // symbols can stop right after it.
+  if (EmitSymbolTable)
+    WriteSymbolTable(M, Stream);
+
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(*M, ShouldPreserveUseListOrder);
 
@@ -3038,7 +3211,7 @@ static void WriteBitcodeHeader(BitstreamWriter &Stream) {
 /// stream.
 void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
                               bool ShouldPreserveUseListOrder,
-                              bool EmitFunctionSummary) {
+                              bool EmitFunctionSummary, bool EmitSymbolTable) {
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -3064,7 +3237,7 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
 
     // Emit the module.
     WriteModule(M, Stream, ShouldPreserveUseListOrder, BitcodeStartBit,
-                EmitFunctionSummary);
+                EmitFunctionSummary, EmitSymbolTable);
   }
 
   if (TT.isOSDarwin())
@@ -68,6 +68,8 @@ void LLVMTargetMachine::initAsmInfo() {
   if (Options.CompressDebugSections)
     TmpAsmInfo->setCompressDebugSections(true);
 
+  TmpAsmInfo->setObjectWriterThreads(Options.ObjectWriterThreads);
+
   AsmInfo = TmpAsmInfo;
 }
 
@@ -37,7 +37,8 @@ INITIALIZE_PASS_END(LiveRegMatrix, "liveregmatrix",
                     "Live Register Matrix", false, false)
 
 LiveRegMatrix::LiveRegMatrix() : MachineFunctionPass(ID),
-  UserTag(0), RegMaskTag(0), RegMaskVirtReg(0) {}
+  UserTag(0), RegMaskTag(0), RegMaskVirtReg(0), RegUnitTag(0),
+  RegUnitVirtReg(0) {}
 
 void LiveRegMatrix::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.setPreservesAll();
@@ -55,6 +56,8 @@ bool LiveRegMatrix::runOnMachineFunction(MachineFunction &MF) {
   if (NumRegUnits != Matrix.size())
     Queries.reset(new LiveIntervalUnion::Query[NumRegUnits]);
   Matrix.init(LIUAlloc, NumRegUnits);
+  RegUnitChecked.resize(TRI->getNumRegs());
+  RegUnitInterference.resize(TRI->getNumRegs());
 
   // Make sure no stale queries get reused.
   invalidateVirtRegs();
@@ -158,6 +161,20 @@ bool LiveRegMatrix::checkRegUnitInterference(LiveInterval &VirtReg,
                                              unsigned PhysReg) {
   if (VirtReg.empty())
     return false;
+
+  // Check if the cached information is valid. Fixed interference doesn't
+  // change while VirtReg is being allocated, and the allocators ask for the
+  // same PhysRegs several times when trying assignment, eviction and
+  // recoloring. The overlap check is linear in the size of both live ranges,
+  // so remember the answer until the virtual registers are invalidated.
+  if (RegUnitVirtReg != VirtReg.reg || RegUnitTag != UserTag) {
+    RegUnitVirtReg = VirtReg.reg;
+    RegUnitTag = UserTag;
+    RegUnitChecked.reset();
+  }
+  if (RegUnitChecked.test(PhysReg))
+    return RegUnitInterference.test(PhysReg);
+
   CoalescerPair CP(VirtReg.reg, PhysReg, *TRI);
 
   bool Result = foreachUnit(TRI, VirtReg, PhysReg, [&](unsigned Unit,
@@ -165,6 +182,8 @@ bool LiveRegMatrix::checkRegUnitInterference(LiveInterval &VirtReg,
     const LiveRange &UnitRange = LIS->getRegUnit(Unit);
     return Range.overlaps(UnitRange, CP, *LIS->getSlotIndexes());
   });
+  RegUnitChecked.set(PhysReg);
+  RegUnitInterference[PhysReg] = Result;
   return Result;
 }
 
@@ -27,6 +27,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GraphWriter.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include <queue>
@@ -81,6 +82,13 @@ static cl::opt<bool> EnableMacroFusion("misched-fusion", cl::Hidden,
 static cl::opt<bool> VerifyScheduling("verify-misched", cl::Hidden,
   cl::desc("Verify machine instrs before and after machine scheduling"));
 
+// Building the DAG and picking nodes both get slower than linear with the
+// region size, so huge blocks are cut into several regions.
+static cl::opt<unsigned> MaxRegionInstrs("misched-max-region-instrs",
+  cl::Hidden, cl::init(0),
+  cl::desc("Split scheduling regions larger than this many instructions "
+           "(0 = no limit)"));
+
 // DAG subtrees must have at least this many nodes.
 static const unsigned MinSubtreeSize = 8;
 
@@ -446,6 +454,10 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
       for(;I != MBB->begin(); --I, --RemainingInstrs) {
         if (isSchedBoundary(&*std::prev(I), &*MBB, MF, TII))
           break;
+        // The instruction above a region that is too large becomes the
+        // boundary of the next one, it is left in place.
+        if (MaxRegionInstrs && NumRegionInstrs >= MaxRegionInstrs)
+          break;
         if (!I->isDebugValue())
           ++NumRegionInstrs;
       }
@@ -669,6 +681,8 @@ void ScheduleDAGMI::schedule() {
   // Build the DAG.
   buildSchedGraph(AA);
 
+  NamedRegionTimer T("Scheduling", TimerGroupName, TimePassesIsEnabled);
+
   Topo.InitDAGTopologicalSorting();
 
   postprocessDAG();
@@ -1031,6 +1045,8 @@ void ScheduleDAGMILive::schedule() {
   DEBUG(SchedImpl->dumpPolicy());
   buildDAGWithRegPressure();
 
+  NamedRegionTimer T("Scheduling", TimerGroupName, TimePassesIsEnabled);
+
   Topo.InitDAGTopologicalSorting();
 
   postprocessDAG();
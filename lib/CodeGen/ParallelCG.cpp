@@ -16,9 +16,11 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/thread.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
@@ -44,7 +46,8 @@ llvm::splitCodeGen(std::unique_ptr<Module> M,
                    ArrayRef<llvm::raw_pwrite_stream *> OSs, StringRef CPU,
                    StringRef Features, const TargetOptions &Options,
                    Reloc::Model RM, CodeModel::Model CM, CodeGenOpt::Level OL,
-                   TargetMachine::CodeGenFileType FileType) {
+                   TargetMachine::CodeGenFileType FileType,
+                   bool PreserveOrder) {
   StringRef TripleStr = M->getTargetTriple();
   std::string ErrMsg;
   const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
@@ -57,7 +60,16 @@ llvm::splitCodeGen(std::unique_ptr<Module> M,
     return M;
   }
 
+  // With -time-passes, report the wall time spent generating each partition, so
+  // that an imbalance between the partitions can be spotted.
+  TimerGroup PartitionTimers("Split code generation");
+  std::vector<std::unique_ptr<Timer>> Timers;
+
   std::vector<thread> Threads;
+  // Keep locals in the same partition as their users instead of externalizing
+  // them, and balance the partitions by size: the threads are joined, so the
+  // largest partition bounds the time spent here. With PreserveOrder, the
+  // partitions are also contiguous in module order.
   SplitModule(std::move(M), OSs.size(), [&](std::unique_ptr<Module> MPart) {
     // We want to clone the module in a new context to multi-thread the codegen.
     // We do it by serializing partition modules to bitcode (while still on the
@@ -69,9 +81,17 @@ llvm::splitCodeGen(std::unique_ptr<Module> M,
     WriteBitcodeToFile(MPart.get(), BCOS);
 
     llvm::raw_pwrite_stream *ThreadOS = OSs[Threads.size()];
+    Timer *T = nullptr;
+    if (TimePassesIsEnabled) {
+      Timers.emplace_back(new Timer(
+          "Partition " + std::to_string(Threads.size()), PartitionTimers));
+      T = Timers.back().get();
+    }
     Threads.emplace_back(
-        [TheTarget, CPU, Features, Options, RM, CM, OL, FileType,
-         ThreadOS](const SmallVector<char, 0> &BC) {
+        [TheTarget, CPU, Features, Options, RM, CM, OL, FileType, ThreadOS,
+         T](const SmallVector<char, 0> &BC) {
+          // Each timer is only used by its own thread.
+          TimeRegion TR(T);
           LLVMContext Ctx;
           ErrorOr<std::unique_ptr<Module>> MOrErr =
               parseBitcodeFile(MemoryBufferRef(StringRef(BC.data(), BC.size()),
@@ -87,7 +107,7 @@ llvm::splitCodeGen(std::unique_ptr<Module> M,
         // Pass BC using std::move to ensure that it get moved rather than
         // copied into the thread's context.
         std::move(BC));
-  });
+  }, /*PreserveLocals=*/true, PreserveOrder);
 
   for (thread &T : Threads)
     T.join();
@@ -40,6 +40,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetLowering.h"
@@ -66,6 +67,14 @@ EnableAntiDepBreaking("break-anti-dependencies",
                                "\"critical\", \"all\", or \"none\""),
                       cl::init("none"), cl::Hidden);
 
+// Splitting huge blocks bounds the cost of building the DAG and of the list
+// scheduler, whose available queue can grow with the region.
+static cl::opt<unsigned>
+MaxRegionInstrs("postra-sched-max-region-instrs",
+                cl::desc("Split post-RA scheduling regions larger than this "
+                         "many instructions (0 = no limit)"),
+                cl::init(0), cl::Hidden);
+
 // If DebugDiv > 0 then only schedule MBB with (ID % DebugDiv) == DebugMod
 static cl::opt<int>
 DebugDiv("postra-sched-debugdiv",
@@ -335,8 +344,10 @@ bool PostRAScheduler::runOnMachineFunction(MachineFunction &Fn) {
       --Count;
       // Calls are not scheduling boundaries before register allocation, but
       // post-ra we don't gain anything by scheduling across calls since we
-      // don't need to worry about register pressure.
-      if (MI->isCall() || TII->isSchedulingBoundary(MI, &MBB, Fn)) {
+      // don't need to worry about register pressure. Huge regions are split by
+      // treating MI as a boundary.
+      if (MI->isCall() || TII->isSchedulingBoundary(MI, &MBB, Fn) ||
+          (MaxRegionInstrs && CurrentCount - Count > MaxRegionInstrs)) {
         Scheduler.enterRegion(&MBB, I, Current, CurrentCount - Count);
         Scheduler.setEndIndex(CurrentCount);
         Scheduler.schedule();
@@ -391,6 +402,8 @@ void SchedulePostRATDList::schedule() {
   buildSchedGraph(AA);
 
   if (AntiDepBreak) {
+    NamedRegionTimer T("Anti-Dependence Breaking", TimerGroupName,
+                       TimePassesIsEnabled);
     unsigned Broken =
       AntiDepBreak->BreakAntiDependencies(SUnits, RegionBegin, RegionEnd,
                                           EndIndex, DbgValues);
@@ -417,6 +430,8 @@ void SchedulePostRATDList::schedule() {
     }
   );
 
+  NamedRegionTimer T("Post-RA List Scheduling", TimerGroupName,
+                     TimePassesIsEnabled);
   AvailableQueue.initNodes(SUnits);
   ListScheduleTopDown();
   AvailableQueue.releaseState();
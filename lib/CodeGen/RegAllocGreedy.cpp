@@ -42,6 +42,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
@@ -100,6 +101,18 @@ CSRFirstTimeCost("regalloc-csr-first-time-cost",
               cl::desc("Cost for first time use of callee-saved register."),
               cl::init(0), cl::Hidden);
 
+static cl::opt<bool>
+ReportFunctionStats("regalloc-greedy-report", cl::Hidden,
+                    cl::desc("Print the allocation time and the number of "
+                             "evictions, splits and spills for each "
+                             "function"));
+
+static cl::opt<unsigned> ReportFunctionThreshold(
+    "regalloc-greedy-report-threshold", cl::Hidden,
+    cl::desc("Only report functions taking at least this many milliseconds "
+             "to allocate"),
+    cl::init(0));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -202,7 +215,11 @@ class RAGreedy : public MachineFunctionPass,
     // Cascade - Eviction loop prevention. See canEvictInterference().
     unsigned Cascade;
 
-    RegInfo() : Stage(RS_New), Cascade(0) {}
+    // EvictionDepth - Length of the chain of evictions that led to this live
+    // range being evicted, or 0. Only used for reporting.
+    unsigned EvictionDepth;
+
+    RegInfo() : Stage(RS_New), Cascade(0), EvictionDepth(0) {}
   };
 
   IndexedMap<RegInfo, VirtReg2IndexFunctor> ExtraRegInfo;
@@ -312,6 +329,24 @@ class RAGreedy : public MachineFunctionPass,
   /// Set of broken hints that may be reconciled later because of eviction.
   SmallSetVector<LiveInterval *, 8> SetOfBrokenHints;
 
+  /// Counters for the current function, printed by -regalloc-greedy-report.
+  struct FunctionStats {
+    unsigned NumVirtRegs;
+    unsigned Evictions;
+    unsigned MaxEvictionDepth;
+    unsigned GlobalSplits;
+    unsigned BlockSplits;
+    unsigned InstrSplits;
+    unsigned LocalSplits;
+    unsigned Spills;
+
+    FunctionStats()
+        : NumVirtRegs(0), Evictions(0), MaxEvictionDepth(0), GlobalSplits(0),
+          BlockSplits(0), InstrSplits(0), LocalSplits(0), Spills(0) {}
+  };
+
+  FunctionStats Stats;
+
 public:
   RAGreedy();
 
@@ -415,6 +450,8 @@ private:
   void collectHintInfo(unsigned, HintsInfo &);
 
   bool isUnusedCalleeSavedReg(unsigned PhysReg) const;
+
+  void reportFunctionStats(double Seconds) const;
 };
 } // end anonymous namespace
 
@@ -814,6 +851,8 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
   DEBUG(dbgs() << "evicting " << PrintReg(PhysReg, TRI)
                << " interference: Cascade " << Cascade << '\n');
 
+  unsigned Depth = ExtraRegInfo[VirtReg.reg].EvictionDepth + 1;
+
   // Collect all interfering virtregs first.
   SmallVector<LiveInterval*, 8> Intfs;
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
@@ -834,7 +873,10 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
             VirtReg.isSpillable() < Intf->isSpillable()) &&
            "Cannot decrease cascade number, illegal eviction");
     ExtraRegInfo[Intf->reg].Cascade = Cascade;
+    ExtraRegInfo[Intf->reg].EvictionDepth = Depth;
     ++NumEvicted;
+    ++Stats.Evictions;
+    Stats.MaxEvictionDepth = std::max(Stats.MaxEvictionDepth, Depth);
     NewVRegs.push_back(Intf->reg);
   }
 }
@@ -1295,6 +1337,7 @@ void RAGreedy::splitAroundRegion(LiveRangeEdit &LREdit,
   }
 
   ++NumGlobalSplits;
+  ++Stats.GlobalSplits;
 
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
@@ -1518,6 +1561,7 @@ unsigned RAGreedy::tryBlockSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     return 0;
 
   // We did split for some blocks.
+  ++Stats.BlockSplits;
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
 
@@ -1613,6 +1657,7 @@ RAGreedy::tryInstructionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     return 0;
   }
 
+  ++Stats.InstrSplits;
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
   DebugVars->splitRegister(VirtReg.reg, LREdit.regs(), *LIS);
@@ -1928,6 +1973,7 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     DEBUG(dbgs() << '\n');
   }
   ++NumLocalSplits;
+  ++Stats.LocalSplits;
 
   return 0;
 }
@@ -2545,6 +2591,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
     NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
     LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
     spiller().spill(LRE);
+    ++Stats.Spills;
     setStage(NewVRegs.begin(), NewVRegs.end(), RS_Done);
 
     if (VerifyEnabled)
@@ -2560,6 +2607,10 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   DEBUG(dbgs() << "********** GREEDY REGISTER ALLOCATION **********\n"
                << "********** Function: " << mf.getName() << '\n');
 
+  double StartTime = 0;
+  if (ReportFunctionStats)
+    StartTime = TimeRecord::getCurrentTime(true).getWallTime();
+
   MF = &mf;
   TRI = MF->getSubtarget().getRegisterInfo();
   TII = MF->getSubtarget().getInstrInfo();
@@ -2598,9 +2649,31 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
+  Stats = FunctionStats();
+  Stats.NumVirtRegs = MRI->getNumVirtRegs();
 
   allocatePhysRegs();
   tryHintsRecoloring();
   releaseMemory();
+
+  if (ReportFunctionStats)
+    reportFunctionStats(TimeRecord::getCurrentTime(false).getWallTime() -
+                        StartTime);
   return true;
 }
+
+/// reportFunctionStats - Print one line describing the work done to allocate
+/// the current function. This is meant to find the pathological functions in
+/// a large program, so functions faster than the threshold are skipped.
+void RAGreedy::reportFunctionStats(double Seconds) const {
+  double Millis = Seconds * 1000.0;
+  if (Millis < ReportFunctionThreshold)
+    return;
+  errs() << "greedy: " << MF->getName() << ": " << Stats.NumVirtRegs
+         << " virtregs, " << format("%.3f", Millis) << " ms, "
+         << Stats.Evictions << " evictions (max depth "
+         << Stats.MaxEvictionDepth << "), " << Stats.GlobalSplits
+         << " global splits, " << Stats.BlockSplits << " block splits, "
+         << Stats.InstrSplits << " instr splits, " << Stats.LocalSplits
+         << " local splits, " << Stats.Spills << " spills\n";
+}
@@ -31,6 +31,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -49,6 +50,17 @@ static cl::opt<bool> EnableAASchedMI("enable-aa-sched-mi", cl::Hidden,
 static cl::opt<bool> UseTBAA("use-tbaa-in-sched-mi", cl::Hidden,
     cl::init(true), cl::desc("Enable use of TBAA during MI DAG construction"));
 
+// Every memory operation is checked against the ones below it in the region
+// that are still tracked, which is quadratic in huge straight-line regions.
+static cl::opt<unsigned> MaxTrackedMemOps("sched-max-tracked-mem-ops",
+    cl::Hidden, cl::init(0),
+    cl::desc("Turn a memory operation into a barrier once this many memory "
+             "operations are tracked during MI DAG construction, bounding its "
+             "cost in huge regions (0 = no limit)"));
+
+const char ScheduleDAGInstrs::TimerGroupName[] =
+    "Machine Instruction Scheduling";
+
 ScheduleDAGInstrs::ScheduleDAGInstrs(MachineFunction &mf,
                                      const MachineLoopInfo *mli,
                                      bool RemoveKillFlags)
@@ -634,7 +646,8 @@ static bool MIsNeedChainEdge(AliasAnalysis *AA, const MachineFrameInfo *MFI,
 /// "latest" node that needs a chain edge to SUa.
 static unsigned iterateChainSucc(AliasAnalysis *AA, const MachineFrameInfo *MFI,
                                  const DataLayout &DL, SUnit *SUa, SUnit *SUb,
-                                 SUnit *ExitSU, unsigned *Depth,
+                                 SUnit *ExitSU, const SUnit *BarrierChain,
+                                 unsigned *Depth,
                                  SmallPtrSetImpl<const SUnit *> &Visited) {
   if (!SUa || !SUb || SUb == ExitSU)
     return *Depth;
@@ -651,8 +664,9 @@ static unsigned iterateChainSucc(AliasAnalysis *AA, const MachineFrameInfo *MFI,
   //
   // Independently, if we encounter node that is some sort of global
   // object (like a call) we already have full set of dependencies to it
-  // and we can stop descending.
-  if (SUa->isSucc(SUb) ||
+  // and we can stop descending. The same goes for the current barrier chain,
+  // which may also be a memory operation that was turned into a barrier.
+  if (SUa->isSucc(SUb) || SUb == BarrierChain ||
       isGlobalMemoryObject(AA, SUb->getInstr()))
     return *Depth;
 
@@ -670,7 +684,8 @@ static unsigned iterateChainSucc(AliasAnalysis *AA, const MachineFrameInfo *MFI,
   for (SUnit::const_succ_iterator I = SUb->Succs.begin(), E = SUb->Succs.end();
        I != E; ++I)
     if (I->isNormalMemoryOrBarrier())
-      iterateChainSucc(AA, MFI, DL, SUa, I->getSUnit(), ExitSU, Depth, Visited);
+      iterateChainSucc(AA, MFI, DL, SUa, I->getSUnit(), ExitSU, BarrierChain,
+                       Depth, Visited);
   return *Depth;
 }
 
@@ -680,6 +695,7 @@ static unsigned iterateChainSucc(AliasAnalysis *AA, const MachineFrameInfo *MFI,
 /// by it.
 static void adjustChainDeps(AliasAnalysis *AA, const MachineFrameInfo *MFI,
                             const DataLayout &DL, SUnit *SU, SUnit *ExitSU,
+                            const SUnit *BarrierChain,
                             std::set<SUnit *> &CheckList,
                             unsigned LatencyToLoad) {
   if (!SU)
@@ -703,8 +719,8 @@ static void adjustChainDeps(AliasAnalysis *AA, const MachineFrameInfo *MFI,
     for (SUnit::const_succ_iterator J = (*I)->Succs.begin(),
          JE = (*I)->Succs.end(); J != JE; ++J)
       if (J->isNormalMemoryOrBarrier())
-        iterateChainSucc(AA, MFI, DL, SU, J->getSUnit(), ExitSU, &Depth,
-                         Visited);
+        iterateChainSucc(AA, MFI, DL, SU, J->getSUnit(), ExitSU, BarrierChain,
+                         &Depth, Visited);
   }
 }
 
@@ -815,6 +831,21 @@ void ScheduleDAGInstrs::collectVRegUses(SUnit *SU) {
   }
 }
 
+/// Make SU a barrier for all the memory references tracked in MemRefs.
+static void addBarrierDeps(SUnit *SU,
+                           MapVector<ValueType, std::vector<SUnit *> > &MemRefs,
+                           unsigned Latency) {
+  for (MapVector<ValueType, std::vector<SUnit *> >::iterator
+         I = MemRefs.begin(), E = MemRefs.end(); I != E; ++I)
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+      if (I->second[i] != SU) {
+        SDep Dep(SU, SDep::Barrier);
+        Dep.setLatency(Latency);
+        I->second[i]->addPred(Dep);
+      }
+  MemRefs.clear();
+}
+
 /// If RegPressure is non-null, compute register pressure as a side effect. The
 /// DAG builder is an efficient place to do it because it already visits
 /// operands.
@@ -822,6 +853,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
                                         RegPressureTracker *RPTracker,
                                         PressureDiffs *PDiffs,
                                         bool TrackLaneMasks) {
+  NamedRegionTimer T("DAG Construction", TimerGroupName, TimePassesIsEnabled);
   const TargetSubtargetInfo &ST = MF.getSubtarget();
   bool UseAA = EnableAASchedMI.getNumOccurrences() > 0 ? EnableAASchedMI
                                                        : ST.useAA();
@@ -851,6 +883,10 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
   MapVector<ValueType, std::vector<SUnit *> > AliasMemUses, NonAliasMemUses;
   std::set<SUnit*> RejectMemNodes;
 
+  // Number of memory references that may have been added to the maps above
+  // since they were last cleared by a barrier.
+  unsigned NumTrackedMemOps = 0;
+
   // Remove any stale debug info; sometimes BuildSchedGraph is called again
   // without emitting the info from the previous call.
   DbgValues.clear();
@@ -979,11 +1015,12 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       BarrierChain = SU;
       // This is a barrier event that acts as a pivotal node in the DAG,
       // so it is safe to clear list of exposed nodes.
-      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, RejectMemNodes,
-                      TrueMemOrderLatency);
+      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, BarrierChain,
+                      RejectMemNodes, TrueMemOrderLatency);
       RejectMemNodes.clear();
       NonAliasMemDefs.clear();
       NonAliasMemUses.clear();
+      NumTrackedMemOps = 0;
 
       // fall-through
     new_alias_chain:
@@ -1015,8 +1052,8 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       // This call must come after calls to addChainDependency() since it
       // consumes the 'RejectMemNodes' list that addChainDependency() possibly
       // adds to.
-      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, RejectMemNodes,
-                      TrueMemOrderLatency);
+      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, BarrierChain,
+                      RejectMemNodes, TrueMemOrderLatency);
       PendingLoads.clear();
       AliasMemDefs.clear();
       AliasMemUses.clear();
@@ -1032,7 +1069,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       getUnderlyingObjectsForInstr(MI, MFI, Objs, MF.getDataLayout());
 
       if (Objs.empty()) {
-        // Treat all other stores conservatively.
+        // Treat all other stores conservatively. They are tracked as part of
+        // the alias chain, so they count towards MaxTrackedMemOps too.
+        ++NumTrackedMemOps;
         goto new_alias_chain;
       }
 
@@ -1099,8 +1138,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       // This call must come after calls to addChainDependency() since it
       // consumes the 'RejectMemNodes' list that addChainDependency() possibly
       // adds to.
-      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, RejectMemNodes,
-                      TrueMemOrderLatency);
+      adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU, BarrierChain,
+                      RejectMemNodes, TrueMemOrderLatency);
+      ++NumTrackedMemOps;
     } else if (MI->mayLoad()) {
       bool MayAlias = true;
       if (MI->isInvariantLoad(AA)) {
@@ -1155,11 +1195,45 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
           // consumes the 'RejectMemNodes' list that addChainDependency()
           // possibly adds to.
           adjustChainDeps(AA, MFI, MF.getDataLayout(), SU, &ExitSU,
-                          RejectMemNodes, /*Latency=*/0);
+                          BarrierChain, RejectMemNodes, /*Latency=*/0);
         if (BarrierChain)
           BarrierChain->addPred(SDep(SU, SDep::Barrier));
+        ++NumTrackedMemOps;
       }
     }
+
+    // In a huge region, make SU a barrier for everything tracked below it and
+    // start over with empty maps, like a call would do. Instructions above SU
+    // are then only checked against SU. This loses some freedom to reorder
+    // memory operations across SU, but bounds the number of dependencies
+    // checked per memory operation.
+    if (MaxTrackedMemOps && NumTrackedMemOps >= MaxTrackedMemOps) {
+      DEBUG(dbgs() << "Too many tracked memory operations, SU(" << SU->NodeNum
+                   << ") becomes a barrier\n");
+      addBarrierDeps(SU, AliasMemDefs, 0);
+      addBarrierDeps(SU, NonAliasMemDefs, 0);
+      addBarrierDeps(SU, AliasMemUses, TrueMemOrderLatency);
+      addBarrierDeps(SU, NonAliasMemUses, TrueMemOrderLatency);
+      for (unsigned k = 0, m = PendingLoads.size(); k != m; ++k)
+        if (PendingLoads[k] != SU) {
+          SDep Dep(SU, SDep::Barrier);
+          Dep.setLatency(TrueMemOrderLatency);
+          PendingLoads[k]->addPred(Dep);
+        }
+      PendingLoads.clear();
+      // Nodes whose chain edge was rejected are no longer in the maps, but
+      // instructions above SU may still alias them.
+      for (std::set<SUnit *>::iterator I = RejectMemNodes.begin(),
+             E = RejectMemNodes.end(); I != E; ++I)
+        if (*I != SU)
+          (*I)->addPred(SDep(SU, SDep::Barrier));
+      RejectMemNodes.clear();
+      if (AliasChain && AliasChain != SU)
+        AliasChain->addPred(SDep(SU, SDep::Barrier));
+      AliasChain = nullptr;
+      BarrierChain = SU;
+      NumTrackedMemOps = 0;
+    }
   }
   if (DbgMI)
     FirstDbgValue = DbgMI;
@@ -773,6 +773,8 @@ bool SelectionDAG::RemoveNodeFromCSEMaps(SDNode *N) {
     assert(N->getOpcode() != ISD::DELETED_NODE && "DELETED_NODE in CSEMap!");
     assert(N->getOpcode() != ISD::EntryToken && "EntryToken in CSEMap!");
     Erased = CSEMap.RemoveNode(N);
+    // The node is about to be modified, so its profile may change.
+    N->CSEHash = 0;
     break;
   }
 #ifndef NDEBUG
@@ -17,6 +17,7 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -370,21 +371,28 @@ const DWARFDebugMacro *DWARFContext::getDebugMacro() {
   return Macro.get();
 }
 
+/// Return the offset of the line table of \p U, or -1U if it has none.
+static uint32_t getLineTableOffsetForUnit(DWARFUnit *U) {
+  const auto *UnitDIE = U->getUnitDIE();
+  if (UnitDIE == nullptr)
+    return -1U;
+
+  uint32_t stmtOffset =
+      UnitDIE->getAttributeValueAsSectionOffset(U, DW_AT_stmt_list, -1U);
+  if (stmtOffset == -1U)
+    return -1U;
+  return stmtOffset + U->getLineTableOffset();
+}
+
 const DWARFLineTable *
 DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   if (!Line)
     Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
 
-  const auto *UnitDIE = U->getUnitDIE();
-  if (UnitDIE == nullptr)
-    return nullptr;
-
-  unsigned stmtOffset =
-      UnitDIE->getAttributeValueAsSectionOffset(U, DW_AT_stmt_list, -1U);
+  uint32_t stmtOffset = getLineTableOffsetForUnit(U);
   if (stmtOffset == -1U)
     return nullptr; // No line table for this compile unit.
 
-  stmtOffset += U->getLineTableOffset();
   // See if the line table is cached.
   if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
     return lt;
@@ -395,6 +403,57 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   return Line->getOrParseLineTable(lineData, stmtOffset);
 }
 
+void DWARFContext::parseAllUnits(unsigned NumThreads) {
+  parseCompileUnits();
+  if (!Line)
+    Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
+
+  ThreadPool Pool(NumThreads);
+
+  // Extract the DIEs of each unit, and collect its address ranges unless the
+  // address ranges were already built. A task only touches its own unit.
+  std::vector<DWARFAddressRangesVector> CURanges;
+  if (!Aranges)
+    CURanges.resize(CUs.size());
+  for (unsigned I = 0, E = CUs.size(); I != E; ++I) {
+    DWARFCompileUnit *CU = CUs[I].get();
+    DWARFAddressRangesVector *Ranges =
+        CURanges.empty() ? nullptr : &CURanges[I];
+    Pool.async([CU, Ranges] {
+      CU->getUnitDIE(/*ExtractUnitDIEOnly=*/false);
+      if (Ranges)
+        CU->collectAddressRanges(*Ranges);
+    });
+  }
+  Pool.wait();
+
+  // Create the line tables that are not cached yet, then parse them. The
+  // tables do not move once created, so they can be filled concurrently.
+  const RelocAddrMap *LineRelocs = &getLineSection().Relocs;
+  for (const auto &CU : CUs) {
+    uint32_t Offset = getLineTableOffsetForUnit(CU.get());
+    if (Offset == -1U)
+      continue;
+    DWARFLineTable *LT = Line->createLineTable(Offset);
+    if (!LT)
+      continue;
+    DataExtractor LineData(CU->getLineSection(), isLittleEndian(),
+                           CU->getAddressByteSize());
+    Pool.async([LT, LineData, LineRelocs, Offset] {
+      uint32_t ParseOffset = Offset;
+      LT->parse(LineData, LineRelocs, &ParseOffset);
+    });
+  }
+
+  // Merge the address ranges of all the units into the sorted index while
+  // the line tables are parsed.
+  if (!Aranges) {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generate(this, CURanges);
+  }
+  Pool.wait();
+}
+
 void DWARFContext::parseCompileUnits() {
   CUs.parse(*this, getInfoSection());
 }
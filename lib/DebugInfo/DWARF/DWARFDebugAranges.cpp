@@ -35,7 +35,8 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   }
 }
 
-void DWARFDebugAranges::generate(DWARFContext *CTX) {
+void DWARFDebugAranges::generate(DWARFContext *CTX,
+                                 ArrayRef<DWARFAddressRangesVector> CURanges) {
   clear();
   if (!CTX)
     return;
@@ -47,15 +48,20 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
+  assert((CURanges.empty() || CURanges.size() == CTX->getNumCompileUnits()) &&
+         "Expected the ranges of every compile unit");
+  unsigned Index = 0;
   for (const auto &CU : CTX->compile_units()) {
     uint32_t CUOffset = CU->getOffset();
     if (ParsedCUOffsets.insert(CUOffset).second) {
-      DWARFAddressRangesVector CURanges;
-      CU->collectAddressRanges(CURanges);
-      for (const auto &R : CURanges) {
+      DWARFAddressRangesVector Ranges;
+      if (CURanges.empty())
+        CU->collectAddressRanges(Ranges);
+      for (const auto &R : CURanges.empty() ? Ranges : CURanges[Index]) {
         appendRange(CUOffset, R.first, R.second);
       }
     }
+    ++Index;
   }
 
   construct();
@@ -253,6 +253,13 @@ DWARFDebugLine::getOrParseLineTable(DataExtractor debug_line_data,
   return LT;
 }
 
+DWARFDebugLine::LineTable *
+DWARFDebugLine::createLineTable(uint32_t offset) {
+  std::pair<LineTableIter, bool> pos =
+    LineTableMap.insert(LineTableMapTy::value_type(offset, LineTable()));
+  return pos.second ? &pos.first->second : nullptr;
+}
+
 bool DWARFDebugLine::LineTable::parse(DataExtractor debug_line_data,
                                       const RelocAddrMap *RMap,
                                       uint32_t *offset_ptr) {
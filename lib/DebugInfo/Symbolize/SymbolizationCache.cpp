@@ -0,0 +1,271 @@
+//===-- SymbolizationCache.cpp --------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of SymbolizationCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SymbolizationCache.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace llvm {
+namespace symbolize {
+
+using namespace support;
+
+// The cache file starts with a header, followed by the entries sorted by kind
+// and address, the frames of all the entries, and finally the strings they
+// refer to. The strings are NUL-terminated, and referred to by their offset.
+namespace {
+struct CacheHeader {
+  char Magic[8];
+  ulittle32_t Version;
+  ulittle32_t NumEntries;
+  ulittle32_t NumFrames;
+  ulittle32_t StringsSize;
+};
+
+struct CacheEntry {
+  ulittle32_t Kind;
+  ulittle64_t Address;
+  ulittle32_t FirstFrame;
+  ulittle32_t NumFrames;
+};
+
+struct CacheFrame {
+  ulittle32_t FunctionName;
+  ulittle32_t FileName;
+  ulittle32_t Line;
+  ulittle32_t Column;
+};
+} // end anonymous namespace
+
+static const char CacheMagic[8] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'C'};
+static const uint32_t CacheVersion = 1;
+
+static const CacheHeader &getHeader(const MemoryBuffer &Buffer) {
+  return *reinterpret_cast<const CacheHeader *>(Buffer.getBufferStart());
+}
+
+static const CacheEntry *getEntries(const MemoryBuffer &Buffer) {
+  return reinterpret_cast<const CacheEntry *>(Buffer.getBufferStart() +
+                                              sizeof(CacheHeader));
+}
+
+static const CacheFrame *getFrames(const MemoryBuffer &Buffer) {
+  return reinterpret_cast<const CacheFrame *>(
+      getEntries(Buffer) + getHeader(Buffer).NumEntries);
+}
+
+static const char *getStrings(const MemoryBuffer &Buffer) {
+  return reinterpret_cast<const char *>(getFrames(Buffer) +
+                                        getHeader(Buffer).NumFrames);
+}
+
+static bool isValidCache(const MemoryBuffer &Buffer) {
+  if (Buffer.getBufferSize() < sizeof(CacheHeader))
+    return false;
+  const CacheHeader &Header = getHeader(Buffer);
+  if (memcmp(Header.Magic, CacheMagic, sizeof(CacheMagic)) ||
+      Header.Version != CacheVersion)
+    return false;
+  uint64_t Size = sizeof(CacheHeader) +
+                  uint64_t(Header.NumEntries) * sizeof(CacheEntry) +
+                  uint64_t(Header.NumFrames) * sizeof(CacheFrame) +
+                  Header.StringsSize;
+  if (Size != Buffer.getBufferSize())
+    return false;
+  // Every string, the last one included, must be terminated.
+  return Header.StringsSize == 0 || Buffer.getBufferEnd()[-1] == '\0';
+}
+
+SymbolizationCache::SymbolizationCache(std::string Path)
+    : Path(std::move(Path)) {
+  auto BufferOrErr = MemoryBuffer::getFile(this->Path, /*FileSize=*/-1,
+                                           /*RequiresNullTerminator=*/false);
+  if (BufferOrErr && isValidCache(**BufferOrErr))
+    Buffer = std::move(*BufferOrErr);
+}
+
+bool SymbolizationCache::lookup(EntryKey Key,
+                                SmallVectorImpl<DILineInfo> &Frames) const {
+  auto I = NewEntries.find(Key);
+  if (I != NewEntries.end()) {
+    Frames.append(I->second.begin(), I->second.end());
+    return true;
+  }
+  if (!Buffer)
+    return false;
+
+  const CacheHeader &Header = getHeader(*Buffer);
+  const CacheEntry *Begin = getEntries(*Buffer);
+  const CacheEntry *End = Begin + Header.NumEntries;
+  const CacheEntry *E =
+      std::lower_bound(Begin, End, Key, [](const CacheEntry &E, EntryKey Key) {
+        return std::make_pair(uint32_t(E.Kind), uint64_t(E.Address)) < Key;
+      });
+  if (E == End || E->Kind != Key.first || E->Address != Key.second)
+    return false;
+  if (uint64_t(E->FirstFrame) + E->NumFrames > Header.NumFrames)
+    return false;
+
+  const char *Strings = getStrings(*Buffer);
+  auto getString = [&](uint32_t Offset) {
+    return Offset < Header.StringsSize ? Strings + Offset : "";
+  };
+  const CacheFrame *F = getFrames(*Buffer) + E->FirstFrame;
+  for (const CacheFrame *FE = F + E->NumFrames; F != FE; ++F) {
+    DILineInfo Frame;
+    Frame.FunctionName = getString(F->FunctionName);
+    Frame.FileName = getString(F->FileName);
+    Frame.Line = F->Line;
+    Frame.Column = F->Column;
+    Frames.push_back(std::move(Frame));
+  }
+  return true;
+}
+
+bool SymbolizationCache::lookupCode(uint64_t ModuleOffset,
+                                    DILineInfo &Result) const {
+  SmallVector<DILineInfo, 1> Frames;
+  if (!lookup(EntryKey(CodeEntry, ModuleOffset), Frames) || Frames.size() != 1)
+    return false;
+  Result = std::move(Frames.front());
+  return true;
+}
+
+bool SymbolizationCache::lookupInlinedCode(uint64_t ModuleOffset,
+                                           DIInliningInfo &Result) const {
+  SmallVector<DILineInfo, 4> Frames;
+  if (!lookup(EntryKey(InlinedCodeEntry, ModuleOffset), Frames))
+    return false;
+  Result = DIInliningInfo();
+  for (const DILineInfo &Frame : Frames)
+    Result.addFrame(Frame);
+  return true;
+}
+
+void SymbolizationCache::addCode(uint64_t ModuleOffset,
+                                 const DILineInfo &Info) {
+  NewEntries[EntryKey(CodeEntry, ModuleOffset)].assign(1, Info);
+}
+
+void SymbolizationCache::addInlinedCode(uint64_t ModuleOffset,
+                                        const DIInliningInfo &Info) {
+  std::vector<DILineInfo> &Frames =
+      NewEntries[EntryKey(InlinedCodeEntry, ModuleOffset)];
+  Frames.clear();
+  for (uint32_t I = 0, E = Info.getNumberOfFrames(); I != E; ++I)
+    Frames.push_back(Info.getFrame(I));
+}
+
+std::error_code SymbolizationCache::save() {
+  if (NewEntries.empty())
+    return std::error_code();
+
+  // Merge the entries of the file with the new ones.
+  std::map<EntryKey, std::vector<DILineInfo>> Entries;
+  if (Buffer) {
+    const CacheEntry *Begin = getEntries(*Buffer);
+    const CacheEntry *End = Begin + getHeader(*Buffer).NumEntries;
+    for (const CacheEntry *E = Begin; E != End; ++E) {
+      EntryKey Key(E->Kind, E->Address);
+      SmallVector<DILineInfo, 4> Frames;
+      if (lookup(Key, Frames))
+        Entries[Key].assign(Frames.begin(), Frames.end());
+    }
+  }
+  for (auto &Entry : NewEntries)
+    Entries[Entry.first] = std::move(Entry.second);
+  NewEntries.clear();
+
+  std::vector<CacheEntry> EntryTable;
+  std::vector<CacheFrame> FrameTable;
+  StringMap<uint32_t> StringOffsets;
+  std::string Strings;
+  auto addString = [&](StringRef S) -> uint32_t {
+    auto Ins = StringOffsets.insert(std::make_pair(S, Strings.size()));
+    if (Ins.second) {
+      Strings.append(S.begin(), S.end());
+      Strings.push_back('\0');
+    }
+    return Ins.first->second;
+  };
+  for (const auto &Entry : Entries) {
+    CacheEntry E;
+    E.Kind = Entry.first.first;
+    E.Address = Entry.first.second;
+    E.FirstFrame = FrameTable.size();
+    E.NumFrames = Entry.second.size();
+    EntryTable.push_back(E);
+    for (const DILineInfo &Info : Entry.second) {
+      CacheFrame F;
+      F.FunctionName = addString(Info.FunctionName);
+      F.FileName = addString(Info.FileName);
+      F.Line = Info.Line;
+      F.Column = Info.Column;
+      FrameTable.push_back(F);
+    }
+  }
+
+  CacheHeader Header;
+  memcpy(Header.Magic, CacheMagic, sizeof(CacheMagic));
+  Header.Version = CacheVersion;
+  Header.NumEntries = EntryTable.size();
+  Header.NumFrames = FrameTable.size();
+  Header.StringsSize = Strings.size();
+
+  // Write a new file and move it over the old one, so that readers either
+  // see the old file or the complete new one.
+  if (std::error_code EC =
+          sys::fs::create_directories(sys::path::parent_path(Path)))
+    return EC;
+  int FD;
+  SmallString<128> TempPath;
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(Path + "-%%%%%%.tmp", FD, TempPath))
+    return EC;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    OS.write(reinterpret_cast<const char *>(EntryTable.data()),
+             EntryTable.size() * sizeof(CacheEntry));
+    OS.write(reinterpret_cast<const char *>(FrameTable.data()),
+             FrameTable.size() * sizeof(CacheFrame));
+    OS << Strings;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return make_error_code(errc::io_error);
+    }
+  }
+  if (std::error_code EC = sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return EC;
+  }
+
+  // Keep answering from the file that was just written.
+  Buffer.reset();
+  auto BufferOrErr = MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                           /*RequiresNullTerminator=*/false);
+  if (BufferOrErr && isValidCache(**BufferOrErr))
+    Buffer = std::move(*BufferOrErr);
+  return std::error_code();
+}
+
+}  // namespace symbolize
+}  // namespace llvm
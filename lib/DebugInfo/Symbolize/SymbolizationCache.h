@@ -0,0 +1,65 @@
+//===-- SymbolizationCache.h ------------------------------------ C++ -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the SymbolizationCache class, an on-disk cache of the
+// code lookups done on one module.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
+#define LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
+
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace symbolize {
+
+/// The results of the code lookups done on a module, saved in a file so that
+/// later runs can answer the same lookups without opening the debug info.
+///
+/// The file is mapped in memory and holds the entries sorted by address, so a
+/// lookup is a binary search. The file name is expected to identify both the
+/// module (e.g. by its build ID) and the options the results depend on. New
+/// entries are kept in memory until save() writes a new file, which replaces
+/// the old one atomically: processes sharing the cache never see a partial
+/// file, although concurrent saves may drop each other's new entries.
+class SymbolizationCache {
+public:
+  /// Open the cache stored at \p Path. A missing or invalid file gives an
+  /// empty cache, which is created on the first save().
+  explicit SymbolizationCache(std::string Path);
+
+  bool lookupCode(uint64_t ModuleOffset, DILineInfo &Result) const;
+  bool lookupInlinedCode(uint64_t ModuleOffset, DIInliningInfo &Result) const;
+
+  void addCode(uint64_t ModuleOffset, const DILineInfo &Info);
+  void addInlinedCode(uint64_t ModuleOffset, const DIInliningInfo &Info);
+
+  /// Write the cache file back if entries were added since it was opened.
+  std::error_code save();
+
+private:
+  enum EntryKind { CodeEntry, InlinedCodeEntry };
+  typedef std::pair<unsigned, uint64_t> EntryKey;
+
+  bool lookup(EntryKey Key, SmallVectorImpl<DILineInfo> &Frames) const;
+
+  std::string Path;
+  std::unique_ptr<MemoryBuffer> Buffer;
+  std::map<EntryKey, std::vector<DILineInfo>> NewEntries;
+};
+
+}  // namespace symbolize
+}  // namespace llvm
+
+#endif  // LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
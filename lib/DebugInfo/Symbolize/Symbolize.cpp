@@ -14,8 +14,10 @@
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 
 #include "SymbolizableObjectFile.h"
+#include "SymbolizationCache.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Config/config.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/PDB/PDB.h"
@@ -47,8 +49,21 @@
 namespace llvm {
 namespace symbolize {
 
+LLVMSymbolizer::LLVMSymbolizer(const Options &Opts) : Opts(Opts) {}
+
+LLVMSymbolizer::~LLVMSymbolizer() {
+  flush();
+}
+
 ErrorOr<DILineInfo> LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                                   uint64_t ModuleOffset) {
+  // The cache is keyed by the offset given by the user.
+  SymbolizationCache *Cache = getOrCreateCache(ModuleName);
+  DILineInfo LineInfo;
+  if (Cache && Cache->lookupCode(ModuleOffset, LineInfo))
+    return LineInfo;
+  uint64_t CacheKey = ModuleOffset;
+
   auto InfoOrErr = getOrCreateModuleInfo(ModuleName);
   if (auto EC = InfoOrErr.getError())
     return EC;
@@ -59,16 +74,24 @@ ErrorOr<DILineInfo> LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   if (Opts.RelativeAddresses)
     ModuleOffset += Info->getModulePreferredBase();
 
-  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
-                                            Opts.UseSymbolTable);
+  LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
+                                 Opts.UseSymbolTable);
   if (Opts.Demangle)
     LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  if (Cache)
+    Cache->addCode(CacheKey, LineInfo);
   return LineInfo;
 }
 
 ErrorOr<DIInliningInfo>
 LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
                                      uint64_t ModuleOffset) {
+  SymbolizationCache *Cache = getOrCreateCache(ModuleName);
+  DIInliningInfo InlinedContext;
+  if (Cache && Cache->lookupInlinedCode(ModuleOffset, InlinedContext))
+    return InlinedContext;
+  uint64_t CacheKey = ModuleOffset;
+
   auto InfoOrErr = getOrCreateModuleInfo(ModuleName);
   if (auto EC = InfoOrErr.getError())
     return EC;
@@ -79,7 +102,7 @@ LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
   if (Opts.RelativeAddresses)
     ModuleOffset += Info->getModulePreferredBase();
 
-  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
+  InlinedContext = Info->symbolizeInlinedCode(
       ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
   if (Opts.Demangle) {
     for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
@@ -87,6 +110,8 @@ LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
       Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
     }
   }
+  if (Cache)
+    Cache->addInlinedCode(CacheKey, InlinedContext);
   return InlinedContext;
 }
 
@@ -110,6 +135,11 @@ ErrorOr<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
 }
 
 void LLVMSymbolizer::flush() {
+  // The cache is best effort: failing to save it is not an error.
+  for (auto &Cache : Caches)
+    Cache.second->save();
+  CacheForModule.clear();
+  Caches.clear();
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
@@ -331,17 +361,14 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
   return object_error::arch_not_found;
 }
 
-ErrorOr<SymbolizableModule *>
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
-  const auto &I = Modules.find(ModuleName);
-  if (I != Modules.end()) {
-    auto &InfoOrErr = I->second;
-    if (auto EC = InfoOrErr.getError())
-      return EC;
-    return InfoOrErr->get();
-  }
-  std::string BinaryName = ModuleName;
-  std::string ArchName = Opts.DefaultArch;
+/// Split \p ModuleName into the name of the binary and the name of the
+/// architecture, which may follow the last colon.
+static void getBinaryAndArchName(const std::string &ModuleName,
+                                 const std::string &DefaultArch,
+                                 std::string &BinaryName,
+                                 std::string &ArchName) {
+  BinaryName = ModuleName;
+  ArchName = DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
   // Verify that substring after colon form a valid arch name.
   if (ColonPos != std::string::npos) {
@@ -351,6 +378,19 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       ArchName = ArchStr;
     }
   }
+}
+
+ErrorOr<SymbolizableModule *>
+LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
+  const auto &I = Modules.find(ModuleName);
+  if (I != Modules.end()) {
+    auto &InfoOrErr = I->second;
+    if (auto EC = InfoOrErr.getError())
+      return EC;
+    return InfoOrErr->get();
+  }
+  std::string BinaryName, ArchName;
+  getBinaryAndArchName(ModuleName, Opts.DefaultArch, BinaryName, ArchName);
   auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
   if (auto EC = ObjectsOrErr.getError()) {
     // Failed to find valid object file.
@@ -370,8 +410,12 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
-  if (!Context)
-    Context.reset(new DWARFContextInMemory(*Objects.second));
+  if (!Context) {
+    auto DWARFCtx = llvm::make_unique<DWARFContextInMemory>(*Objects.second);
+    if (Opts.DWARFParseThreads)
+      DWARFCtx->parseAllUnits(Opts.DWARFParseThreads);
+    Context = std::move(DWARFCtx);
+  }
   assert(Context);
   auto InfoOrErr =
       SymbolizableObjectFile::create(Objects.first, std::move(Context));
@@ -383,6 +427,72 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   return InsertResult.first->second->get();
 }
 
+/// Return the build ID of \p Obj: the GNU build ID note of an ELF file, or the
+/// UUID of a Mach-O file. Returns an empty array if there is none.
+static ArrayRef<uint8_t> getBuildID(const ObjectFile *Obj) {
+  if (auto *MachO = dyn_cast<MachOObjectFile>(Obj))
+    return MachO->getUuid();
+  if (!isa<ELFObjectFileBase>(Obj))
+    return None;
+  for (const SectionRef &Section : Obj->sections()) {
+    StringRef Name;
+    if (Section.getName(Name) || Name != ".note.gnu.build-id")
+      continue;
+    StringRef Data;
+    if (Section.getContents(Data))
+      return None;
+    DataExtractor Note(Data, Obj->isLittleEndian(), 0);
+    uint32_t Offset = 0;
+    uint32_t NameSize = Note.getU32(&Offset);
+    uint32_t DescSize = Note.getU32(&Offset);
+    uint32_t Type = Note.getU32(&Offset);
+    Offset += RoundUpToAlignment(NameSize, 4);
+    if (Type != ELF::NT_GNU_BUILD_ID ||
+        !Note.isValidOffsetForDataOfSize(Offset, DescSize))
+      return None;
+    return makeArrayRef(Data.bytes_begin() + Offset, DescSize);
+  }
+  return None;
+}
+
+SymbolizationCache *
+LLVMSymbolizer::getOrCreateCache(const std::string &ModuleName) {
+  if (Opts.CacheDir.empty())
+    return nullptr;
+  const auto &I = CacheForModule.find(ModuleName);
+  if (I != CacheForModule.end())
+    return I->second;
+  SymbolizationCache *&Cache = CacheForModule[ModuleName];
+
+  std::string BinaryName, ArchName;
+  getBinaryAndArchName(ModuleName, Opts.DefaultArch, BinaryName, ArchName);
+  auto ObjOrErr = getOrCreateObject(BinaryName, ArchName);
+  if (!ObjOrErr)
+    return nullptr;
+  ArrayRef<uint8_t> BuildID = getBuildID(ObjOrErr.get());
+  if (BuildID.empty())
+    return nullptr;
+
+  // The cached results depend on the options that change the output, so they
+  // are part of the file name along with the build ID.
+  std::string FileName = "llvmsym-";
+  for (uint8_t Byte : BuildID) {
+    FileName += hexdigit(Byte >> 4, /*LowerCase=*/true);
+    FileName += hexdigit(Byte & 15, /*LowerCase=*/true);
+  }
+  unsigned OptionBits = static_cast<unsigned>(Opts.PrintFunctions) |
+                        Opts.UseSymbolTable << 2 | Opts.Demangle << 3 |
+                        Opts.RelativeAddresses << 4;
+  FileName += "-" + utostr(OptionBits);
+  SmallString<128> CachePath(Opts.CacheDir);
+  sys::path::append(CachePath, FileName);
+  std::unique_ptr<SymbolizationCache> &PathCache = Caches[CachePath.str()];
+  if (!PathCache)
+    PathCache = llvm::make_unique<SymbolizationCache>(CachePath.str().str());
+  Cache = PathCache.get();
+  return Cache;
+}
+
 // Undo these various manglings for Win32 extern "C" functions:
 // cdecl       - _foo
 // stdcall     - _foo@12
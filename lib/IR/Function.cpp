@@ -271,6 +271,10 @@ Function::Function(FunctionType *Ty, LinkageTypes Linkage, const Twine &name,
 }
 
 Function::~Function() {
+  // The arguments, blocks and instructions are all going away: drop their names
+  // in a single pass over the symbol table.
+  SymTab->dropAllNames();
+
   dropAllReferences();    // After this it is safe to delete instructions.
 
   // Delete all of the method arguments and unlink from symbol table...
@@ -320,6 +324,11 @@ void Function::dropAllReferences() {
   for (iterator I = begin(), E = end(); I != E; ++I)
     I->dropAllReferences();
 
+  // Delete the instructions now that none of them has operands left, so that
+  // deleting the blocks below does not walk them again.
+  for (BasicBlock &BB : *this)
+    BB.getInstList().clear();
+
   // Delete all basic blocks. They are now unused, except possibly by
   // blockaddresses, but BasicBlock's destructor takes care of those.
   while (!BasicBlocks.empty())
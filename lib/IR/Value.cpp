@@ -87,10 +87,17 @@ Value::~Value() {
 }
 
 void Value::destroyValueName() {
-  ValueName *Name = getValueName();
-  if (Name)
-    Name->Destroy();
-  setValueName(nullptr);
+  if (!HasName)
+    return;
+
+  // Look the name up once to both destroy it and drop it from the side table:
+  // this is done for every named value when a function is deleted.
+  auto &ValueNames = getContext().pImpl->ValueNames;
+  auto I = ValueNames.find(this);
+  assert(I != ValueNames.end() && "No name entry found!");
+  I->second->Destroy();
+  ValueNames.erase(I);
+  HasName = false;
 }
 
 bool Value::hasNUses(unsigned N) const {
@@ -32,6 +32,13 @@ ValueSymbolTable::~ValueSymbolTable() {
 #endif
 }
 
+void ValueSymbolTable::dropAllNames() {
+  for (auto &Entry : vmap)
+    Entry.getValue()->setValueName(nullptr);
+  // The entries are owned by the values: free them along with the table.
+  vmap.clear();
+}
+
 ValueName *ValueSymbolTable::makeUniqueName(Value *V,
                                             SmallString<256> &UniqueName) {
   unsigned BaseSize = UniqueName.size();
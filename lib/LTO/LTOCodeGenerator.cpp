@@ -120,6 +120,13 @@ void LTOCodeGenerator::setModule(std::unique_ptr<LTOModule> Mod) {
   assert(&Mod->getModule().getContext() == &Context &&
          "Expected module in same context");
 
+  // The module may be lazily loaded from a buffer owned by Mod, which is about
+  // to be destroyed.
+  if (std::error_code EC = Mod->getModule().materializeAll()) {
+    emitError(EC.message());
+    return;
+  }
+
   AsmUndefinedRefs.clear();
 
   MergedModule = Mod->takeModule();
@@ -103,12 +103,16 @@ std::string LTOModule::getProducerString(MemoryBuffer *Buffer) {
 ErrorOr<std::unique_ptr<LTOModule>>
 LTOModule::createFromFile(LLVMContext &Context, const char *path,
                           TargetOptions options) {
+  // Bitcode does not need a null terminator: not requiring one lets large
+  // files always be mapped rather than read.
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFile(path);
+      MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
   if (std::error_code EC = BufferOrErr.getError())
     return EC;
   std::unique_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
-  return makeLTOModule(Buffer->getMemBufferRef(), options, &Context);
+  MemoryBufferRef BufferRef = Buffer->getMemBufferRef();
+  return makeLTOModule(BufferRef, options, &Context, std::move(Buffer));
 }
 
 ErrorOr<std::unique_ptr<LTOModule>>
@@ -126,7 +130,8 @@ LTOModule::createFromOpenFileSlice(LLVMContext &Context, int fd,
   if (std::error_code EC = BufferOrErr.getError())
     return EC;
   std::unique_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
-  return makeLTOModule(Buffer->getMemBufferRef(), options, &Context);
+  MemoryBufferRef BufferRef = Buffer->getMemBufferRef();
+  return makeLTOModule(BufferRef, options, &Context, std::move(Buffer));
 }
 
 ErrorOr<std::unique_ptr<LTOModule>>
@@ -153,7 +158,7 @@ LTOModule::createInContext(const void *mem, size_t length,
 
 static ErrorOr<std::unique_ptr<Module>>
 parseBitcodeFileImpl(MemoryBufferRef Buffer, LLVMContext &Context,
-                     bool ShouldBeLazy) {
+                     bool ShouldBeLazy, bool ShouldLazyLoadMetadata) {
 
   // Find the buffer.
   ErrorOr<MemoryBufferRef> MBOrErr =
@@ -173,15 +178,64 @@ parseBitcodeFileImpl(MemoryBufferRef Buffer, LLVMContext &Context,
   std::unique_ptr<MemoryBuffer> LightweightBuf =
       MemoryBuffer::getMemBuffer(*MBOrErr, false);
   ErrorOr<std::unique_ptr<Module>> M = getLazyBitcodeModule(
-      std::move(LightweightBuf), Context, true /*ShouldLazyLoadMetadata*/);
+      std::move(LightweightBuf), Context, ShouldLazyLoadMetadata);
   if (std::error_code EC = M.getError())
     return EC;
   return std::move(*M);
 }
 
+/// Return true if canBeOmittedFromSymbolTable() needs to see every use of
+/// \p GV, which is not possible while function bodies are not materialized.
+static bool scopeNeedsAllUses(const GlobalValue &GV) {
+  if (GV.isDeclaration() || !GV.hasLinkOnceODRLinkage() ||
+      GV.hasUnnamedAddr() || GV.hasLocalLinkage() ||
+      !GV.hasDefaultVisibility())
+    return false;
+  if (const GlobalVariable *Var = dyn_cast<GlobalVariable>(&GV))
+    return Var->isConstant();
+  return !isa<GlobalAlias>(GV);
+}
+
+/// Add to \p Hideable the global values of \p M that the symbol table block of
+/// \p Buffer allows to be hidden. Return false if \p Buffer has no such block,
+/// or one that does not describe \p M.
+static bool readHideableSymbols(MemoryBufferRef Buffer, const Module &M,
+                                DenseSet<const GlobalValue *> &Hideable) {
+  ErrorOr<MemoryBufferRef> BCOrErr =
+      object::IRObjectFile::findBitcodeInMemBuffer(Buffer);
+  if (!BCOrErr)
+    return false;
+  bool HasSymbolTable;
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      readBitcodeSymbols(*BCOrErr, &HasSymbolTable);
+  if (!SymbolsOrErr || !HasSymbolTable)
+    return false;
+
+  // The block lists the functions, then the variables, then the aliases.
+  std::vector<const GlobalValue *> Values;
+  for (const Function &F : M)
+    Values.push_back(&F);
+  for (const GlobalVariable &GV : M.globals())
+    Values.push_back(&GV);
+  for (const GlobalAlias &GA : M.aliases())
+    Values.push_back(&GA);
+  const std::vector<BitcodeSymbol> &Symbols = *SymbolsOrErr;
+  if (Symbols.size() != Values.size())
+    return false;
+  for (size_t I = 0, E = Values.size(); I != E; ++I)
+    if (Symbols[I].Linkage != Values[I]->getLinkage())
+      return false;
+
+  for (size_t I = 0, E = Values.size(); I != E; ++I)
+    if (Symbols[I].CanBeOmittedFromSymbolTable)
+      Hideable.insert(Values[I]);
+  return true;
+}
+
 ErrorOr<std::unique_ptr<LTOModule>>
 LTOModule::makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
-                         LLVMContext *Context) {
+                         LLVMContext *Context,
+                         std::unique_ptr<MemoryBuffer> OwnedBuffer) {
   std::unique_ptr<LLVMContext> OwnedContext;
   if (!Context) {
     OwnedContext = llvm::make_unique<LLVMContext>();
@@ -189,14 +243,31 @@ LTOModule::makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
   }
 
   // If we own a context, we know this is being used only for symbol
-  // extraction, not linking.  Be lazy in that case.
-  ErrorOr<std::unique_ptr<Module>> MOrErr =
-      parseBitcodeFileImpl(Buffer, *Context,
-                           /* ShouldBeLazy */ static_cast<bool>(OwnedContext));
+  // extraction, not linking.  Be lazy in that case, metadata included.
+  // Otherwise, we can still be lazy about function bodies if we own the
+  // buffer: they are only read when the linker pulls them in. The module-level
+  // metadata is needed for the linker options, and by the linker anyway.
+  ErrorOr<std::unique_ptr<Module>> MOrErr = parseBitcodeFileImpl(
+      Buffer, *Context,
+      /* ShouldBeLazy */ OwnedContext || OwnedBuffer,
+      /* ShouldLazyLoadMetadata */ static_cast<bool>(OwnedContext));
   if (std::error_code EC = MOrErr.getError())
     return EC;
   std::unique_ptr<Module> &M = *MOrErr;
 
+  // Telling whether a linkonce_odr symbol can be hidden requires all its uses.
+  // The symbol table block, when the module has one, records the answer. When
+  // linking, the symbol scopes reported to the linker must be exact, so the
+  // modules that have such symbols and no symbol table block are materialized
+  // upfront.
+  DenseSet<const GlobalValue *> Hideable;
+  if ((OwnedContext || OwnedBuffer) &&
+      (std::any_of(M->begin(), M->end(), scopeNeedsAllUses) ||
+       std::any_of(M->global_begin(), M->global_end(), scopeNeedsAllUses)) &&
+      !readHideableSymbols(Buffer, *M, Hideable) && !OwnedContext)
+    if (std::error_code EC = M->materializeAll())
+      return EC;
+
   std::string TripleStr = M->getTargetTriple();
   if (TripleStr.empty())
     TripleStr = sys::getDefaultTargetTriple();
@@ -235,6 +306,8 @@ LTOModule::makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
     Ret.reset(new LTOModule(std::move(IRObj), target, std::move(OwnedContext)));
   else
     Ret.reset(new LTOModule(std::move(IRObj), target));
+  Ret->OwnedBuffer = std::move(OwnedBuffer);
+  Ret->HideableSymbols = std::move(Hideable);
 
   Ret->parseSymbols();
   Ret->parseMetadata();
@@ -454,7 +527,9 @@ void LTOModule::addDefinedSymbol(const char *Name, const GlobalValue *def,
     attr |= LTO_SYMBOL_SCOPE_HIDDEN;
   else if (def->hasProtectedVisibility())
     attr |= LTO_SYMBOL_SCOPE_PROTECTED;
-  else if (canBeOmittedFromSymbolTable(def))
+  else if ((scopeNeedsAllUses(*def) && !def->getParent()->isMaterialized())
+               ? HideableSymbols.count(def)
+               : canBeOmittedFromSymbolTable(def))
     attr |= LTO_SYMBOL_SCOPE_DEFAULT_CAN_BE_HIDDEN;
   else
     attr |= LTO_SYMBOL_SCOPE_DEFAULT;
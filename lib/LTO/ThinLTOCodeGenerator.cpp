@@ -0,0 +1,498 @@
+//===-ThinLTOCodeGenerator.cpp - LLVM Link Time Optimizer -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the Thin Link Time Optimization library. This library
+// is intended to be used by linker to optimize code at link time, one module
+// at a time and in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LTO/ThinLTOCodeGenerator.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Object/FunctionIndexObjectFile.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/ObjCARC.h"
+
+using namespace llvm;
+
+namespace {
+/// Entry in the on-disk cache of native objects, named after the hash key.
+/// Entries are written to a temporary file first and renamed into place, so
+/// a concurrent reader never observes a partial entry.
+class ModuleCacheEntry {
+  SmallString<128> EntryPath;
+
+public:
+  ModuleCacheEntry(StringRef CachePath, StringRef Key) {
+    sys::path::append(EntryPath, CachePath, "llvmcache-" + Key);
+  }
+
+  StringRef getEntryPath() const { return EntryPath; }
+
+  /// Return the cached object, or nullptr on a cache miss.
+  std::unique_ptr<MemoryBuffer> tryLoadingBuffer() {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(EntryPath);
+    if (!BufferOrErr)
+      return nullptr;
+    CachePruning::touch(EntryPath);
+    return std::move(*BufferOrErr);
+  }
+
+  /// Store \p Buffer in the cache. Failures are ignored: the cache is only an
+  /// optimization.
+  void write(const MemoryBuffer &Buffer) {
+    int FD;
+    SmallString<128> TempPath;
+    if (sys::fs::createUniqueFile(EntryPath + "-%%%%%%.tmp", FD, TempPath))
+      return;
+    {
+      raw_fd_ostream OS(FD, /* shouldClose */ true);
+      OS << Buffer.getBuffer();
+      OS.close();
+      if (OS.has_error()) {
+        OS.clear_error();
+        sys::fs::remove(TempPath);
+        return;
+      }
+    }
+    if (sys::fs::rename(TempPath, EntryPath))
+      sys::fs::remove(TempPath);
+  }
+
+  /// Store the same object as the existing entry \p Other, which holds
+  /// \p Buffer. The entry is hard linked to \p Other when possible, so that
+  /// the object is only stored once, and written from \p Buffer otherwise.
+  void writeLinked(const ModuleCacheEntry &Other, const MemoryBuffer &Buffer) {
+    // Reserve a unique name to link under, then rename the link into place.
+    int FD;
+    SmallString<128> TempPath;
+    if (sys::fs::createUniqueFile(EntryPath + "-%%%%%%.tmp", FD, TempPath))
+      return;
+    sys::Process::SafelyCloseFileDescriptor(FD);
+    sys::fs::remove(TempPath);
+    if (!sys::fs::create_hard_link(Other.getEntryPath(), TempPath)) {
+      if (sys::fs::rename(TempPath, EntryPath))
+        sys::fs::remove(TempPath);
+      return;
+    }
+    write(Buffer);
+  }
+};
+}
+
+static std::string finalizeHash(MD5 &Hasher) {
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Str;
+  MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+static std::string hashBuffer(StringRef Buffer) {
+  MD5 Hasher;
+  Hasher.update(Buffer);
+  return finalizeHash(Hasher);
+}
+
+ThinLTOCodeGenerator::ThinLTOCodeGenerator() {}
+
+ThinLTOCodeGenerator::~ThinLTOCodeGenerator() {}
+
+void ThinLTOCodeGenerator::addModule(StringRef Identifier, StringRef Data) {
+  Modules.push_back({Identifier.str(), Data});
+}
+
+void ThinLTOCodeGenerator::setOptLevel(unsigned Level) {
+  OptLevel = Level;
+  switch (OptLevel) {
+  case 0:
+    CGOptLevel = CodeGenOpt::None;
+    break;
+  case 1:
+    CGOptLevel = CodeGenOpt::Less;
+    break;
+  case 2:
+    CGOptLevel = CodeGenOpt::Default;
+    break;
+  case 3:
+    CGOptLevel = CodeGenOpt::Aggressive;
+    break;
+  }
+}
+
+static void diagnosticHandler(const DiagnosticInfo &DI) {
+  DiagnosticPrinterRawOStream DP(errs());
+  DI.print(DP);
+  errs() << '\n';
+}
+
+std::unique_ptr<FunctionInfoIndex> ThinLTOCodeGenerator::linkCombinedIndex() {
+  auto CombinedIndex = llvm::make_unique<FunctionInfoIndex>();
+  uint64_t NextModuleId = 0;
+  for (auto &Input : Modules) {
+    if (!object::FunctionIndexObjectFile::hasFunctionSummaryInMemBuffer(
+            Input.getBuffer(), diagnosticHandler))
+      continue;
+    ErrorOr<std::unique_ptr<object::FunctionIndexObjectFile>> ObjOrErr =
+        object::FunctionIndexObjectFile::create(Input.getBuffer(),
+                                                diagnosticHandler);
+    if (std::error_code EC = ObjOrErr.getError()) {
+      errs() << "error: can't create FunctionIndexObjectFile for buffer '"
+             << Input.Identifier << "': " << EC.message() << "\n";
+      return nullptr;
+    }
+    CombinedIndex->mergeFrom((*ObjOrErr)->takeIndex(), ++NextModuleId);
+  }
+  return CombinedIndex;
+}
+
+std::unique_ptr<TargetMachine>
+ThinLTOCodeGenerator::createTargetMachine(StringRef TripleStr,
+                                          std::string &ErrMsg) {
+  Triple TheTriple(TripleStr);
+
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
+  if (!TheTarget)
+    return nullptr;
+
+  SubtargetFeatures Features(MAttr);
+  Features.getDefaultSubtargetFeatures(TheTriple);
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      TripleStr, MCpu, Features.getString(), Options, RelocModel,
+      CodeModel::Default, CGOptLevel));
+}
+
+/// Run the per-module optimization pipeline. Internalization is not safe here
+/// since the other modules are compiled separately, so the regular (non-LTO)
+/// module pipeline is used.
+void ThinLTOCodeGenerator::optimizeModule(Module &M, TargetMachine &TM) {
+  M.setDataLayout(TM.createDataLayout());
+
+  legacy::PassManager PM;
+  PM.add(createTargetTransformInfoWrapperPass(TM.getTargetIRAnalysis()));
+
+  PassManagerBuilder PMB;
+  if (OptLevel > 1)
+    PMB.Inliner = createFunctionInliningPass();
+  PMB.LibraryInfo = new TargetLibraryInfoImpl(TM.getTargetTriple());
+  PMB.OptLevel = OptLevel;
+  PMB.LoopVectorize = OptLevel > 1;
+  PMB.SLPVectorize = OptLevel > 1;
+  PMB.VerifyInput = true;
+  PMB.VerifyOutput = true;
+  PMB.populateModulePassManager(PM);
+
+  // If the bitcode files contain ARC code and were compiled with optimization,
+  // the ObjCARCContractPass must be run, so do it unconditionally here.
+  PM.add(createObjCARCContractPass());
+
+  PM.run(M);
+}
+
+std::unique_ptr<MemoryBuffer>
+ThinLTOCodeGenerator::codegenModule(Module &M, TargetMachine &TM,
+                                    std::string &ErrMsg) {
+  SmallVector<char, 128> OutputBuffer;
+  {
+    raw_svector_ostream OS(OutputBuffer);
+    legacy::PassManager PM;
+    if (TM.addPassesToEmitFile(PM, OS, FileType)) {
+      ErrMsg = "target file type not supported";
+      return nullptr;
+    }
+    PM.run(M);
+  }
+  return MemoryBuffer::getMemBufferCopy(
+      StringRef(OutputBuffer.data(), OutputBuffer.size()),
+      M.getModuleIdentifier());
+}
+
+/// Hash the optimization and code generation options, and the target.
+void ThinLTOCodeGenerator::hashCodeGenOptions(MD5 &Hasher,
+                                              const TargetMachine &TM) {
+  // A different compiler may produce a different object.
+  Hasher.update(LLVM_VERSION_STRING);
+
+  Hasher.update(TM.getTargetTriple().str());
+  Hasher.update(TM.getTargetCPU());
+  Hasher.update(TM.getTargetFeatureString());
+
+  const TargetOptions &TO = TM.Options;
+  uint32_t Opts[] = {OptLevel,
+                     CGOptLevel,
+                     RelocModel,
+                     FileType,
+                     TO.UnsafeFPMath,
+                     TO.NoInfsFPMath,
+                     TO.NoNaNsFPMath,
+                     TO.LessPreciseFPMADOption,
+                     TO.HonorSignDependentRoundingFPMathOption,
+                     TO.NoZerosInBSS,
+                     TO.GuaranteedTailCallOpt,
+                     TO.StackAlignmentOverride,
+                     TO.PositionIndependentExecutable,
+                     TO.UseInitArray,
+                     TO.FunctionSections,
+                     TO.DataSections,
+                     TO.UniqueSectionNames,
+                     TO.TrapUnreachable,
+                     TO.EmulatedTLS,
+                     TO.FloatABIType,
+                     TO.AllowFPOpFusion,
+                     TO.ThreadModel,
+                     static_cast<uint32_t>(TO.DebuggerTuning)};
+  Hasher.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Opts),
+                                  sizeof(Opts)));
+}
+
+/// Compute the key of the entry looked up before \p Input is even parsed. It
+/// covers the module, the combined index and the options. The combined index
+/// depends on the content and the order of all the modules of the link, so
+/// this entry is only hit when the very same set of modules is linked again.
+std::string ThinLTOCodeGenerator::computeLinkCacheKey(const ModuleInput &Input,
+                                                      const TargetMachine &TM) {
+  MD5 Hasher;
+  Hasher.update(Input.Identifier);
+  Hasher.update(ModuleHashes.lookup(Input.Identifier));
+  Hasher.update(CombinedIndexHash);
+  hashCodeGenOptions(Hasher, TM);
+  return finalizeHash(Hasher);
+}
+
+/// Compute the key of the entry looked up once the functions to import into
+/// \p Input are known. It covers everything that affects the produced object:
+/// the module itself, the functions imported into it along with the content
+/// of the modules they come from, the IDs that the combined index assigns to
+/// these modules (they are part of the names of promoted locals), and the
+/// options. It does not depend on the modules that \p Input does not import
+/// from, so the object can be reused when only those change.
+std::string ThinLTOCodeGenerator::computeCacheKey(
+    const ModuleInput &Input, const FunctionInfoIndex &Index,
+    const FunctionImporter::ImportListTy &ImportList,
+    const TargetMachine &TM) {
+  MD5 Hasher;
+  Hasher.update(ModuleHashes.lookup(Input.Identifier));
+  Hasher.update(utostr(Index.getModuleId(Input.Identifier)));
+
+  for (auto &Entry : ImportList) {
+    Hasher.update(Entry.first);
+    Hasher.update(ModuleHashes.lookup(Entry.first));
+    Hasher.update(utostr(Index.getModuleId(Entry.first)));
+    for (auto &Name : Entry.second) {
+      // Separate the names, so that {"ab"} and {"a", "b"} hash differently.
+      Hasher.update(StringRef("\0", 1));
+      Hasher.update(Name);
+    }
+  }
+
+  hashCodeGenOptions(Hasher, TM);
+  return finalizeHash(Hasher);
+}
+
+/// Import, optimize and compile a single module in its own context. This runs
+/// on a pool thread: it must not touch any state shared with the other
+/// workers apart from the read-only combined index and input buffers.
+bool ThinLTOCodeGenerator::processModule(
+    const ModuleInput &Input, const FunctionInfoIndex &Index,
+    const StringMap<MemoryBufferRef> &ModuleMap,
+    std::unique_ptr<MemoryBuffer> &Output, std::string &ErrMsg) {
+  LLVMContext Context;
+
+  // The target is read from the bitcode without parsing the module, so that
+  // a cached object can be found before doing any real work.
+  std::string TripleStr = getBitcodeTargetTriple(Input.getBuffer(), Context);
+  if (TripleStr.empty())
+    TripleStr = sys::getDefaultTargetTriple();
+  std::unique_ptr<TargetMachine> TM = createTargetMachine(TripleStr, ErrMsg);
+  if (!TM)
+    return false;
+
+  std::unique_ptr<ModuleCacheEntry> LinkCacheEntry;
+  if (!CacheOptions.Path.empty()) {
+    LinkCacheEntry = llvm::make_unique<ModuleCacheEntry>(
+        CacheOptions.Path, computeLinkCacheKey(Input, *TM));
+    if ((Output = LinkCacheEntry->tryLoadingBuffer()))
+      return true;
+  }
+
+  ErrorOr<std::unique_ptr<Module>> ModuleOrErr =
+      parseBitcodeFile(Input.getBuffer(), Context);
+  if (std::error_code EC = ModuleOrErr.getError()) {
+    ErrMsg = EC.message();
+    return false;
+  }
+  Module &TheModule = **ModuleOrErr;
+  if (TheModule.getTargetTriple().empty())
+    TheModule.setTargetTriple(TripleStr);
+
+  // Promote to global scope and rename any local values that are potentially
+  // exported to other modules.
+  if (renameModuleForThinLTO(TheModule, &Index)) {
+    ErrMsg = "error renaming module";
+    return false;
+  }
+
+  // Import from the other modules, lazily loaded in the worker context. Only
+  // modules that are part of this link can be imported from. A module that
+  // can't be loaded fails this backend, the error is reported by run().
+  std::string ImportErrMsg;
+  auto ModuleLoader = [&](StringRef Identifier) -> std::unique_ptr<Module> {
+    auto I = ModuleMap.find(Identifier);
+    if (I == ModuleMap.end()) {
+      ImportErrMsg = ("can't find module '" + Identifier + "' to import from")
+                         .str();
+      return nullptr;
+    }
+    ErrorOr<std::unique_ptr<Module>> SrcOrErr = getLazyBitcodeModule(
+        MemoryBuffer::getMemBuffer(I->second, false), Context,
+        /* ShouldLazyLoadMetadata = */ true);
+    if (std::error_code EC = SrcOrErr.getError()) {
+      ImportErrMsg =
+          ("can't load module '" + Identifier + "': " + EC.message()).str();
+      return nullptr;
+    }
+    return std::move(*SrcOrErr);
+  };
+  FunctionImporter Importer(Index, ModuleLoader);
+  FunctionImporter::ImportListTy ImportList;
+  Importer.importFunctions(TheModule, &ImportList);
+  if (!ImportErrMsg.empty()) {
+    ErrMsg = std::move(ImportErrMsg);
+    return false;
+  }
+
+  if (CacheOptions.Path.empty()) {
+    optimizeModule(TheModule, *TM);
+    Output = codegenModule(TheModule, *TM, ErrMsg);
+    return Output != nullptr;
+  }
+
+  // The link entry missed: look for the object under the key that only
+  // depends on the modules imported from. Whatever the outcome, the link
+  // entry is then made to point at the same object.
+  ModuleCacheEntry CacheEntry(CacheOptions.Path,
+                              computeCacheKey(Input, Index, ImportList, *TM));
+  if ((Output = CacheEntry.tryLoadingBuffer())) {
+    LinkCacheEntry->writeLinked(CacheEntry, *Output);
+    return true;
+  }
+
+  // Another link may be producing the same entry: wait for it rather than
+  // duplicating the work. If the lock can't be taken, or the other process
+  // did not produce the entry, compile anyway.
+  LockFileManager Lock(CacheEntry.getEntryPath());
+  if (Lock.getState() == LockFileManager::LFS_Shared) {
+    Lock.waitForUnlock();
+    if ((Output = CacheEntry.tryLoadingBuffer())) {
+      LinkCacheEntry->writeLinked(CacheEntry, *Output);
+      return true;
+    }
+  }
+
+  optimizeModule(TheModule, *TM);
+  Output = codegenModule(TheModule, *TM, ErrMsg);
+  if (!Output)
+    return false;
+  CacheEntry.write(*Output);
+  LinkCacheEntry->writeLinked(CacheEntry, *Output);
+  return true;
+}
+
+bool ThinLTOCodeGenerator::run() {
+  std::unique_ptr<FunctionInfoIndex> Index = linkCombinedIndex();
+  if (!Index)
+    return false;
+
+  ProducedBinaries.clear();
+  ProducedBinaries.resize(Modules.size());
+  std::vector<std::string> Errors(Modules.size());
+  std::vector<char> Succeeded(Modules.size(), false);
+
+  // Map used by every backend to find the modules to import from.
+  StringMap<MemoryBufferRef> ModuleMap;
+  for (auto &M : Modules)
+    ModuleMap[M.Identifier] = M.getBuffer();
+
+  // Every task only writes to the slots of its own module, so no locking is
+  // needed to collect the results.
+  {
+    std::unique_ptr<ThreadPool> Pool =
+        Parallelism ? llvm::make_unique<ThreadPool>(Parallelism)
+                    : llvm::make_unique<ThreadPool>();
+
+    // The cache keys of a module depend on the hash of the modules it imports
+    // from and on the combined index, compute them all upfront. The combined
+    // index is entirely determined by the modules and their order, so hashing
+    // them hashes the index.
+    if (!CacheOptions.Path.empty()) {
+      sys::fs::create_directories(CacheOptions.Path);
+      std::vector<std::string> Hashes(Modules.size());
+      for (unsigned I = 0, E = Modules.size(); I != E; ++I)
+        Pool->async([&, I]() { Hashes[I] = hashBuffer(Modules[I].Data); });
+      Pool->wait();
+      MD5 IndexHasher;
+      for (unsigned I = 0, E = Modules.size(); I != E; ++I) {
+        IndexHasher.update(Modules[I].Identifier);
+        IndexHasher.update(StringRef("\0", 1));
+        IndexHasher.update(Hashes[I]);
+        ModuleHashes[Modules[I].Identifier] = std::move(Hashes[I]);
+      }
+      CombinedIndexHash = finalizeHash(IndexHasher);
+    }
+
+    for (unsigned I = 0, E = Modules.size(); I != E; ++I)
+      Pool->async([&, I]() {
+        Succeeded[I] = processModule(Modules[I], *Index, ModuleMap,
+                                     ProducedBinaries[I], Errors[I]);
+      });
+    Pool->wait();
+  }
+
+  if (!CacheOptions.Path.empty())
+    CachePruning(CacheOptions.Path)
+        .setPruningInterval(CacheOptions.PruningInterval)
+        .setEntryExpiration(CacheOptions.Expiration)
+        .setMaxSize(CacheOptions.MaxSize)
+        .prune();
+
+  bool Success = true;
+  for (unsigned I = 0, E = Modules.size(); I != E; ++I) {
+    if (Succeeded[I])
+      continue;
+    errs() << "error: ThinLTO backend failed for '" << Modules[I].Identifier
+           << "': " << Errors[I] << "\n";
+    Success = false;
+  }
+  return Success;
+}
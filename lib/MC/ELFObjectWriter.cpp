@@ -34,6 +34,7 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/ThreadPool.h"
 #include <vector>
 using namespace llvm;
 
@@ -69,6 +70,34 @@ public:
   ArrayRef<uint32_t> getShndxIndexes() const { return ShndxIndexes; }
 };
 
+/// A writer only used for its binary output functions, to write the contents
+/// of a section to a separate stream.
+class SectionDataWriter : public MCObjectWriter {
+public:
+  SectionDataWriter(raw_pwrite_stream &OS, bool IsLittleEndian)
+      : MCObjectWriter(OS, IsLittleEndian) {}
+
+  void executePostLayoutBinding(MCAssembler &Asm,
+                                const MCAsmLayout &Layout) override {
+    llvm_unreachable("Not an object writer");
+  }
+  void recordRelocation(MCAssembler &Asm, const MCAsmLayout &Layout,
+                        const MCFragment *Fragment, const MCFixup &Fixup,
+                        MCValue Target, bool &IsPCRel,
+                        uint64_t &FixedValue) override {
+    llvm_unreachable("Not an object writer");
+  }
+  void writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) override {
+    llvm_unreachable("Not an object writer");
+  }
+};
+
+/// The contents of a section, written ahead of the object file.
+struct RenderedSection {
+  SmallVector<char, 0> Contents;
+  bool Compressed = false;
+};
+
 class ELFObjectWriter : public MCObjectWriter {
     static bool isFixupKindPCRel(const MCAssembler &Asm, unsigned Kind);
     static uint64_t SymbolValue(const MCSymbol &Sym, const MCAsmLayout &Layout);
@@ -158,11 +187,13 @@ class ELFObjectWriter : public MCObjectWriter {
         write32(W);
     }
 
-    template <typename T> void write(T Val) {
+    template <typename T> void write(T Val) { write(getStream(), Val); }
+
+    template <typename T> void write(raw_ostream &OS, T Val) const {
       if (IsLittleEndian)
-        support::endian::Writer<support::little>(getStream()).write(Val);
+        support::endian::Writer<support::little>(OS).write(Val);
       else
-        support::endian::Writer<support::big>(getStream()).write(Val);
+        support::endian::Writer<support::big>(OS).write(Val);
     }
 
     void writeHeader(const MCAssembler &Asm);
@@ -212,12 +243,19 @@ class ELFObjectWriter : public MCObjectWriter {
     void writeSectionData(const MCAssembler &Asm, MCSection &Sec,
                           const MCAsmLayout &Layout);
 
+    /// Write the contents of \p Sec to \p Data rather than to the object
+    /// file. Different sections may be rendered concurrently.
+    void renderSectionData(const MCAssembler &Asm, const MCSectionELF &Sec,
+                           const MCAsmLayout &Layout,
+                           RenderedSection &Data) const;
+
     void WriteSecHdrEntry(uint32_t Name, uint32_t Type, uint64_t Flags,
                           uint64_t Address, uint64_t Offset, uint64_t Size,
                           uint32_t Link, uint32_t Info, uint64_t Alignment,
                           uint64_t EntrySize);
 
-    void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec);
+    void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec,
+                          raw_ostream &OS);
 
     bool isSymbolRefDifferenceFullyResolvedImpl(const MCAssembler &Asm,
                                                 const MCSymbol &SymA,
@@ -989,16 +1027,38 @@ prependCompressionHeader(uint64_t Size,
   return true;
 }
 
+// Compressing debug_frame requires handling alignment fragments which is
+// more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
+// for writing to arbitrary buffers) for little benefit.
+static bool shouldCompressSection(const MCAssembler &Asm,
+                                  const MCSectionELF &Section) {
+  StringRef SectionName = Section.getSectionName();
+  return Asm.getContext().getAsmInfo()->compressDebugSections() &&
+         SectionName.startswith(".debug_") && SectionName != ".debug_frame";
+}
+
+// Compress the contents of a debug section, header included. Return false if
+// the section should be left uncompressed.
+static bool compressSectionData(ArrayRef<char> UncompressedData,
+                                SmallVectorImpl<char> &CompressedContents) {
+  zlib::Status Success = zlib::compress(
+      StringRef(UncompressedData.data(), UncompressedData.size()),
+      CompressedContents);
+  if (Success != zlib::StatusOK)
+    return false;
+  return prependCompressionHeader(UncompressedData.size(), CompressedContents);
+}
+
+static void renameCompressedSection(MCContext &Ctx, MCSectionELF &Section) {
+  StringRef SectionName = Section.getSectionName();
+  Ctx.renameELFSection(&Section, (".z" + SectionName.drop_front(1)).str());
+}
+
 void ELFObjectWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
                                        const MCAsmLayout &Layout) {
   MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
-  StringRef SectionName = Section.getSectionName();
 
-  // Compressing debug_frame requires handling alignment fragments which is
-  // more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
-  // for writing to arbitrary buffers) for little benefit.
-  if (!Asm.getContext().getAsmInfo()->compressDebugSections() ||
-      !SectionName.startswith(".debug_") || SectionName == ".debug_frame") {
+  if (!shouldCompressSection(Asm, Section)) {
     Asm.writeSectionData(&Section, Layout);
     return;
   }
@@ -1011,21 +1071,30 @@ void ELFObjectWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
   setStream(OldStream);
 
   SmallVector<char, 128> CompressedContents;
-  zlib::Status Success = zlib::compress(
-      StringRef(UncompressedData.data(), UncompressedData.size()),
-      CompressedContents);
-  if (Success != zlib::StatusOK) {
+  if (!compressSectionData(UncompressedData, CompressedContents)) {
     getStream() << UncompressedData;
     return;
   }
+  renameCompressedSection(Asm.getContext(), Section);
+  getStream() << CompressedContents;
+}
 
-  if (!prependCompressionHeader(UncompressedData.size(), CompressedContents)) {
-    getStream() << UncompressedData;
+void ELFObjectWriter::renderSectionData(const MCAssembler &Asm,
+                                        const MCSectionELF &Section,
+                                        const MCAsmLayout &Layout,
+                                        RenderedSection &Data) const {
+  raw_svector_ostream VecOS(Data.Contents);
+  SectionDataWriter Writer(VecOS, isLittleEndian());
+  Asm.writeSectionData(&Section, Layout, Writer);
+
+  // The section is renamed by the caller, which owns the context.
+  if (!shouldCompressSection(Asm, Section))
     return;
-  }
-  Asm.getContext().renameELFSection(&Section,
-                                    (".z" + SectionName.drop_front(1)).str());
-  getStream() << CompressedContents;
+  SmallVector<char, 0> CompressedContents;
+  if (!compressSectionData(Data.Contents, CompressedContents))
+    return;
+  Data.Contents = std::move(CompressedContents);
+  Data.Compressed = true;
 }
 
 void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
@@ -1047,7 +1116,8 @@ void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
 }
 
 void ELFObjectWriter::writeRelocations(const MCAssembler &Asm,
-                                       const MCSectionELF &Sec) {
+                                       const MCSectionELF &Sec,
+                                       raw_ostream &OS) {
   std::vector<ELFRelocationEntry> &Relocs = Relocations[&Sec];
 
   // We record relocations by pushing to the end of a vector. Reverse the vector
@@ -1064,30 +1134,30 @@ void ELFObjectWriter::writeRelocations(const MCAssembler &Asm,
     unsigned Index = Entry.Symbol ? Entry.Symbol->getIndex() : 0;
 
     if (is64Bit()) {
-      write(Entry.Offset);
+      write(OS, Entry.Offset);
       if (TargetObjectWriter->isN64()) {
-        write(uint32_t(Index));
+        write(OS, uint32_t(Index));
 
-        write(TargetObjectWriter->getRSsym(Entry.Type));
-        write(TargetObjectWriter->getRType3(Entry.Type));
-        write(TargetObjectWriter->getRType2(Entry.Type));
-        write(TargetObjectWriter->getRType(Entry.Type));
+        write(OS, TargetObjectWriter->getRSsym(Entry.Type));
+        write(OS, TargetObjectWriter->getRType3(Entry.Type));
+        write(OS, TargetObjectWriter->getRType2(Entry.Type));
+        write(OS, TargetObjectWriter->getRType(Entry.Type));
       } else {
         struct ELF::Elf64_Rela ERE64;
         ERE64.setSymbolAndType(Index, Entry.Type);
-        write(ERE64.r_info);
+        write(OS, ERE64.r_info);
       }
       if (hasRelocationAddend())
-        write(Entry.Addend);
+        write(OS, Entry.Addend);
     } else {
-      write(uint32_t(Entry.Offset));
+      write(OS, uint32_t(Entry.Offset));
 
       struct ELF::Elf32_Rela ERE32;
       ERE32.setSymbolAndType(Index, Entry.Type);
-      write(ERE32.r_info);
+      write(OS, ERE32.r_info);
 
       if (hasRelocationAddend())
-        write(uint32_t(Entry.Addend));
+        write(OS, uint32_t(Entry.Addend));
     }
   }
 }
@@ -1190,6 +1260,26 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
 
   std::map<const MCSymbol *, std::vector<const MCSectionELF *>> GroupMembers;
 
+  // With several threads, the contents of the sections and of the relocation
+  // sections are written to separate buffers concurrently, and only copied to
+  // the stream in order. Each task only touches its own section.
+  std::unique_ptr<ThreadPool> Pool;
+  std::vector<RenderedSection> SectionData;
+  unsigned NumThreads = Ctx.getAsmInfo()->getObjectWriterThreads();
+  if (NumThreads > 1) {
+    Pool = llvm::make_unique<ThreadPool>(NumThreads);
+    std::vector<const MCSectionELF *> Sections;
+    for (const MCSection &Sec : Asm)
+      Sections.push_back(static_cast<const MCSectionELF *>(&Sec));
+    SectionData.resize(Sections.size());
+    parallelForBatches(*Pool, Sections.size(), NumThreads * 4,
+                       [&](size_t, size_t Begin, size_t End) {
+                         for (size_t I = Begin; I != End; ++I)
+                           renderSectionData(Asm, *Sections[I], Layout,
+                                             SectionData[I]);
+                       });
+  }
+
   // Write out the ELF header ...
   writeHeader(Asm);
 
@@ -1197,6 +1287,7 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
   SectionOffsetsTy SectionOffsets;
   std::vector<MCSectionELF *> Groups;
   std::vector<MCSectionELF *> Relocations;
+  unsigned SectionDataIndex = 0;
   for (MCSection &Sec : Asm) {
     MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
 
@@ -1206,7 +1297,14 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
     uint64_t SecStart = getStream().tell();
 
     const MCSymbolELF *SignatureSymbol = Section.getGroup();
-    writeSectionData(Asm, Section, Layout);
+    if (SectionData.empty()) {
+      writeSectionData(Asm, Section, Layout);
+    } else {
+      RenderedSection &Data = SectionData[SectionDataIndex++];
+      if (Data.Compressed)
+        renameCompressedSection(Ctx, Section);
+      getStream() << Data.Contents;
+    }
 
     uint64_t SecEnd = getStream().tell();
     SectionOffsets[&Section] = std::make_pair(SecStart, SecEnd);
@@ -1257,13 +1355,32 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
   // Compute symbol table information.
   computeSymbolTable(Asm, Layout, SectionIndexMap, RevGroupMap, SectionOffsets);
 
-  for (MCSectionELF *RelSection : Relocations) {
+  // The relocations refer to the symbol indices, which are now known.
+  std::vector<SmallVector<char, 0>> RelocationData;
+  if (Pool) {
+    RelocationData.resize(Relocations.size());
+    parallelForBatches(*Pool, Relocations.size(), NumThreads * 4,
+                       [&](size_t, size_t Begin, size_t End) {
+                         for (size_t I = Begin; I != End; ++I) {
+                           const MCSectionELF &Sec =
+                               *Relocations[I]->getAssociatedSection();
+                           raw_svector_ostream OS(RelocationData[I]);
+                           writeRelocations(Asm, Sec, OS);
+                         }
+                       });
+  }
+
+  for (unsigned I = 0, E = Relocations.size(); I != E; ++I) {
+    MCSectionELF *RelSection = Relocations[I];
     align(RelSection->getAlignment());
 
     // Remember the offset into the file for this section.
     uint64_t SecStart = getStream().tell();
 
-    writeRelocations(Asm, *RelSection->getAssociatedSection());
+    if (RelocationData.empty())
+      writeRelocations(Asm, *RelSection->getAssociatedSection(), getStream());
+    else
+      getStream() << RelocationData[I];
 
     uint64_t SecEnd = getStream().tell();
     SectionOffsets[RelSection] = std::make_pair(SecStart, SecEnd);
@@ -108,6 +108,7 @@ MCAsmInfo::MCAsmInfo() {
   UseIntegratedAssembler = false;
 
   CompressDebugSections = false;
+  ObjectWriterThreads = 1;
 }
 
 MCAsmInfo::~MCAsmInfo() {
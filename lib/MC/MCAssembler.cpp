@@ -21,7 +21,9 @@
 #include "llvm/MC/MCFixupKindInfo.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSection.h"
+#include "llvm/MC/MCSectionCOFF.h"
 #include "llvm/MC/MCSectionELF.h"
+#include "llvm/MC/MCSectionMachO.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/Support/Debug.h"
@@ -54,6 +56,11 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(SectionRelaxationSteps,
+          "Number of layout and relaxation steps of a single section");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
+STATISTIC(SkippedRelaxationChecks,
+          "Number of relaxation checks skipped for an unchanged distance");
 }
 }
 
@@ -68,7 +75,8 @@ MCAssembler::MCAssembler(MCContext &Context_, MCAsmBackend &Backend_,
                          MCCodeEmitter &Emitter_, MCObjectWriter &Writer_)
     : Context(Context_), Backend(Backend_), Emitter(Emitter_), Writer(Writer_),
       BundleAlignSize(0), RelaxAll(false), SubsectionsViaSymbols(false),
-      IncrementalLinkerCompatible(false), ELFHeaderEFlags(0) {
+      IncrementalLinkerCompatible(false), ELFHeaderEFlags(0),
+      RelaxationReportOS(nullptr) {
   VersionMinInfo.Major = 0; // Major version == 0 for "none specified"
 }
 
@@ -414,8 +422,7 @@ void MCAssembler::writeFragmentPadding(const MCFragment &F, uint64_t FSize,
 
 /// \brief Write the fragment \p F to the output file.
 static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
-                          const MCFragment &F) {
-  MCObjectWriter *OW = &Asm.getWriter();
+                          const MCFragment &F, MCObjectWriter *OW) {
 
   // FIXME: Embed in fragments instead?
   uint64_t FragmentSize = Asm.computeFragmentSize(Layout, F);
@@ -545,6 +552,12 @@ static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
 
 void MCAssembler::writeSectionData(const MCSection *Sec,
                                    const MCAsmLayout &Layout) const {
+  writeSectionData(Sec, Layout, getWriter());
+}
+
+void MCAssembler::writeSectionData(const MCSection *Sec,
+                                   const MCAsmLayout &Layout,
+                                   MCObjectWriter &OW) const {
   // Ignore virtual sections.
   if (Sec->isVirtualSection()) {
     assert(Layout.getSectionFileSize(Sec) == 0 && "Invalid size for section!");
@@ -588,14 +601,13 @@ void MCAssembler::writeSectionData(const MCSection *Sec,
     return;
   }
 
-  uint64_t Start = getWriter().getStream().tell();
+  uint64_t Start = OW.getStream().tell();
   (void)Start;
 
   for (const MCFragment &F : *Sec)
-    writeFragment(*this, Layout, F);
+    writeFragment(*this, Layout, F, &OW);
 
-  assert(getWriter().getStream().tell() - Start ==
-         Layout.getSectionAddressSize(Sec));
+  assert(OW.getStream().tell() - Start == Layout.getSectionAddressSize(Sec));
 }
 
 std::pair<uint64_t, bool> MCAssembler::handleFixup(const MCAsmLayout &Layout,
@@ -616,6 +628,38 @@ std::pair<uint64_t, bool> MCAssembler::handleFixup(const MCAsmLayout &Layout,
   return std::make_pair(FixedValue, IsPCRel);
 }
 
+/// A relaxable fragment with a single PC-relative fixup to a label of the same
+/// section only needs to be checked again once its distance to the label
+/// changed, so such fragments remember the distance they were checked for.
+/// Fragments which can no longer change size are dropped from the list.
+struct MCAssembler::SectionRelaxState {
+  struct Candidate {
+    MCFragment *F;
+    /// The fragment of the label F refers to, or null if F must be checked on
+    /// every iteration.
+    const MCFragment *Target;
+    /// The distance from F to Target when F was last checked.
+    uint64_t Distance;
+  };
+
+  std::vector<Candidate> Candidates;
+  bool Initialized = false;
+  unsigned Iterations = 0;
+  unsigned Checks = 0;
+  unsigned SkippedChecks = 0;
+  unsigned Relaxed = 0;
+};
+
+static StringRef getSectionName(const MCSection &Sec) {
+  if (const auto *ELFSec = dyn_cast<MCSectionELF>(&Sec))
+    return ELFSec->getSectionName();
+  if (const auto *MachOSec = dyn_cast<MCSectionMachO>(&Sec))
+    return MachOSec->getSectionName();
+  if (const auto *COFFSec = dyn_cast<MCSectionCOFF>(&Sec))
+    return COFFSec->getSectionName();
+  return StringRef();
+}
+
 void MCAssembler::layout(MCAsmLayout &Layout) {
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - pre-layout\n--\n";
@@ -643,9 +687,23 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  std::vector<SectionRelaxState> States(size());
+  while (layoutOnce(Layout, States))
     continue;
 
+  if (RelaxationReportOS) {
+    for (MCSection &Sec : *this) {
+      const SectionRelaxState &State = States[Sec.getOrdinal()];
+      if (!State.Checks && !State.SkippedChecks)
+        continue;
+      *RelaxationReportOS << "section #" << Sec.getOrdinal() << " ("
+                          << getSectionName(Sec) << "): " << State.Iterations
+                          << " iterations, " << State.Checks << " checks, "
+                          << State.SkippedChecks << " skipped, "
+                          << State.Relaxed << " relaxed\n";
+    }
+  }
+
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - post-relaxation\n--\n";
       dump(); });
@@ -708,32 +766,60 @@ void MCAssembler::Finish() {
 
 bool MCAssembler::fixupNeedsRelaxation(const MCFixup &Fixup,
                                        const MCRelaxableFragment *DF,
-                                       const MCAsmLayout &Layout) const {
-  MCValue Target;
+                                       const MCAsmLayout &Layout,
+                                       MCValue &Target) const {
   uint64_t Value;
   bool Resolved = evaluateFixup(Layout, Fixup, DF, Target, Value);
   return getBackend().fixupNeedsRelaxationAdvanced(Fixup, Resolved, Value, DF,
                                                    Layout);
 }
 
+/// Return the fragment of the label a fixup of \p F refers to, if the value
+/// of the fixup only depends on the distance from \p F to that fragment.
+static const MCFragment *getPCRelTargetFragment(const MCAsmBackend &Backend,
+                                                const MCFixup &Fixup,
+                                                const MCValue &Target,
+                                                const MCFragment &F) {
+  // A PC aligned down depends on the offset of F, not only on the distance.
+  unsigned Flags = Backend.getFixupKindInfo(Fixup.getKind()).Flags;
+  if (!(Flags & MCFixupKindInfo::FKF_IsPCRel) ||
+      (Flags & MCFixupKindInfo::FKF_IsAlignedDownTo32Bits))
+    return nullptr;
+  if (!Target.getSymA() || Target.getSymB())
+    return nullptr;
+  const MCSymbol &Sym = Target.getSymA()->getSymbol();
+  if (Sym.isVariable() || !Sym.isInSection(false) ||
+      &Sym.getSection(false) != F.getParent())
+    return nullptr;
+  return Sym.getFragment(false);
+}
+
 bool MCAssembler::fragmentNeedsRelaxation(const MCRelaxableFragment *F,
-                                          const MCAsmLayout &Layout) const {
+                                          const MCAsmLayout &Layout,
+                                          const MCFragment *&TargetFrag) const {
+  TargetFrag = nullptr;
+
   // If this inst doesn't ever need relaxation, ignore it. This occurs when we
   // are intentionally pushing out inst fragments, or because we relaxed a
   // previous instruction to one that doesn't need relaxation.
   if (!getBackend().mayNeedRelaxation(F->getInst()))
     return false;
 
-  for (const MCFixup &Fixup : F->getFixups())
-    if (fixupNeedsRelaxation(Fixup, F, Layout))
+  ArrayRef<MCFixup> Fixups = F->getFixups();
+  for (const MCFixup &Fixup : Fixups) {
+    MCValue Target;
+    if (fixupNeedsRelaxation(Fixup, F, Layout, Target))
       return true;
+    if (Fixups.size() == 1 && getBackend().fixupRelaxationOnlyDependsOnValue())
+      TargetFrag = getPCRelTargetFragment(getBackend(), Fixup, Target, *F);
+  }
 
   return false;
 }
 
-bool MCAssembler::relaxInstruction(MCAsmLayout &Layout,
-                                   MCRelaxableFragment &F) {
-  if (!fragmentNeedsRelaxation(&F, Layout))
+bool MCAssembler::relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &F,
+                                   const MCFragment *&Target) {
+  if (!fragmentNeedsRelaxation(&F, Layout, Target))
     return false;
 
   ++stats::RelaxedInstructions;
@@ -812,41 +898,92 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                                    SectionRelaxState &State) {
+  if (!State.Initialized) {
+    State.Initialized = true;
+    for (MCFragment &F : Sec) {
+      switch (F.getKind()) {
+      default:
+        break;
+      case MCFragment::FT_Relaxable:
+        assert(!getRelaxAll() &&
+               "Did not expect a MCRelaxableFragment in RelaxAll mode");
+        if (!getBackend().mayNeedRelaxation(
+                cast<MCRelaxableFragment>(F).getInst()))
+          break;
+      // Fall through.
+      case MCFragment::FT_Dwarf:
+      case MCFragment::FT_DwarfFrame:
+      case MCFragment::FT_LEB:
+        State.Candidates.push_back({&F, nullptr, 0});
+        break;
+      }
+    }
+  }
+  ++State.Iterations;
+  ++stats::SectionRelaxationSteps;
+
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = nullptr;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
+  // Attempt to relax all the fragments which may still change size.
+  auto Out = State.Candidates.begin();
+  for (SectionRelaxState::Candidate C : State.Candidates) {
     bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    bool IsFinal = false;
+    switch (C.F->getKind()) {
     default:
+      llvm_unreachable("Unexpected relaxation candidate");
+    case MCFragment::FT_Relaxable: {
+      auto &RF = cast<MCRelaxableFragment>(*C.F);
+      if (C.Target && Layout.getFragmentOffset(C.Target) -
+                              Layout.getFragmentOffset(&RF) == C.Distance) {
+        ++stats::SkippedRelaxationChecks;
+        ++State.SkippedChecks;
+        break;
+      }
+      ++stats::RelaxationChecks;
+      ++State.Checks;
+      RelaxedFrag = relaxInstruction(Layout, RF, C.Target);
+      if (RelaxedFrag)
+        IsFinal = !getBackend().mayNeedRelaxation(RF.getInst());
+      else if (C.Target)
+        C.Distance = Layout.getFragmentOffset(C.Target) -
+                     Layout.getFragmentOffset(&RF);
       break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
+    }
     case MCFragment::FT_Dwarf:
+      ++stats::RelaxationChecks;
+      ++State.Checks;
       RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+                                       *cast<MCDwarfLineAddrFragment>(C.F));
       break;
     case MCFragment::FT_DwarfFrame:
+      ++stats::RelaxationChecks;
+      ++State.Checks;
       RelaxedFrag =
         relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+                                    *cast<MCDwarfCallFrameFragment>(C.F));
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      ++stats::RelaxationChecks;
+      ++State.Checks;
+      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(C.F));
       break;
     }
+    if (RelaxedFrag)
+      ++State.Relaxed;
     if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = &*I;
+      FirstRelaxedFragment = C.F;
+    if (!IsFinal)
+      *Out++ = C;
   }
+  State.Candidates.erase(Out, State.Candidates.end());
+
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
@@ -854,13 +991,15 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
   return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             MutableArrayRef<SectionRelaxState> States) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSection &Sec = *it;
-    while (layoutSectionOnce(Layout, Sec))
+    SectionRelaxState &State = States[Sec.getOrdinal()];
+    while (layoutSectionOnce(Layout, Sec, State))
       WasRelaxed = true;
   }
 
@@ -14,6 +14,7 @@
 #include "llvm/Object/ArchiveWriter.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/ObjectFile.h"
@@ -23,8 +24,10 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include <cstring>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -76,19 +79,29 @@ NewArchiveIterator::getFD(sys::fs::file_status &NewStatus) const {
 }
 
 template <typename T>
-static void printWithSpacePadding(raw_fd_ostream &OS, T Data, unsigned Size,
+static void printWithSpacePadding(raw_ostream &OS, T Data, unsigned Size,
                                   bool MayTruncate = false) {
-  uint64_t OldPos = OS.tell();
-  OS << Data;
-  unsigned SizeSoFar = OS.tell() - OldPos;
-  if (Size > SizeSoFar) {
-    OS.indent(Size - SizeSoFar);
-  } else if (Size < SizeSoFar) {
+  SmallString<32> Buf;
+  raw_svector_ostream BufOS(Buf);
+  BufOS << Data;
+  if (Buf.size() > Size) {
     assert(MayTruncate && "Data doesn't fit in Size");
     // Some of the data this is used for (like UID) can be larger than the
     // space available in the archive format. Truncate in that case.
-    OS.seek(OldPos + Size);
+    Buf.resize(Size);
   }
+  OS << Buf;
+  OS.indent(Size - Buf.size());
+}
+
+// Overwrite a field that was already written to Out at Offset.
+template <typename T>
+static void patchWithSpacePadding(raw_pwrite_stream &Out, uint64_t Offset,
+                                  T Data, unsigned Size) {
+  SmallString<32> Buf;
+  raw_svector_ostream BufOS(Buf);
+  printWithSpacePadding(BufOS, Data, Size);
+  Out.pwrite(Buf.data(), Buf.size(), Offset);
 }
 
 static void print32(raw_ostream &Out, object::Archive::Kind Kind,
@@ -99,7 +112,14 @@ static void print32(raw_ostream &Out, object::Archive::Kind Kind,
     support::endian::Writer<support::little>(Out).write(Val);
 }
 
-static void printRestOfMemberHeader(raw_fd_ostream &Out,
+static void write32(char *Buf, object::Archive::Kind Kind, uint32_t Val) {
+  if (Kind == object::Archive::K_GNU)
+    support::endian::write32be(Buf, Val);
+  else
+    support::endian::write32le(Buf, Val);
+}
+
+static void printRestOfMemberHeader(raw_ostream &Out,
                                     const sys::TimeValue &ModTime, unsigned UID,
                                     unsigned GID, unsigned Perms,
                                     unsigned Size) {
@@ -111,7 +131,7 @@ static void printRestOfMemberHeader(raw_fd_ostream &Out,
   Out << "`\n";
 }
 
-static void printGNUSmallMemberHeader(raw_fd_ostream &Out, StringRef Name,
+static void printGNUSmallMemberHeader(raw_ostream &Out, StringRef Name,
                                       const sys::TimeValue &ModTime,
                                       unsigned UID, unsigned GID,
                                       unsigned Perms, unsigned Size) {
@@ -119,10 +139,12 @@ static void printGNUSmallMemberHeader(raw_fd_ostream &Out, StringRef Name,
   printRestOfMemberHeader(Out, ModTime, UID, GID, Perms, Size);
 }
 
-static void printBSDMemberHeader(raw_fd_ostream &Out, StringRef Name,
-                                 const sys::TimeValue &ModTime, unsigned UID,
-                                 unsigned GID, unsigned Perms, unsigned Size) {
-  uint64_t PosAfterHeader = Out.tell() + 60 + Name.size();
+// Pos is the offset of the header in the archive.
+static void printBSDMemberHeader(raw_ostream &Out, uint64_t Pos,
+                                 StringRef Name, const sys::TimeValue &ModTime,
+                                 unsigned UID, unsigned GID, unsigned Perms,
+                                 unsigned Size) {
+  uint64_t PosAfterHeader = Pos + 60 + Name.size();
   // Pad so that even 64 bit object files are aligned.
   unsigned Pad = OffsetToAlignment(PosAfterHeader, 8);
   unsigned NameWithPadding = Name.size() + Pad;
@@ -130,7 +152,6 @@ static void printBSDMemberHeader(raw_fd_ostream &Out, StringRef Name,
   printRestOfMemberHeader(Out, ModTime, UID, GID, Perms,
                           NameWithPadding + Size);
   Out << Name;
-  assert(PosAfterHeader == Out.tell());
   while (Pad--)
     Out.write(uint8_t(0));
 }
@@ -140,13 +161,13 @@ static bool useStringTable(bool Thin, StringRef Name) {
 }
 
 static void
-printMemberHeader(raw_fd_ostream &Out, object::Archive::Kind Kind, bool Thin,
-                  StringRef Name,
+printMemberHeader(raw_ostream &Out, uint64_t Pos, object::Archive::Kind Kind,
+                  bool Thin, StringRef Name,
                   std::vector<unsigned>::iterator &StringMapIndexIter,
                   const sys::TimeValue &ModTime, unsigned UID, unsigned GID,
                   unsigned Perms, unsigned Size) {
   if (Kind == object::Archive::K_BSD)
-    return printBSDMemberHeader(Out, Name, ModTime, UID, GID, Perms, Size);
+    return printBSDMemberHeader(Out, Pos, Name, ModTime, UID, GID, Perms, Size);
   if (!useStringTable(Thin, Name))
     return printGNUSmallMemberHeader(Out, Name, ModTime, UID, GID, Perms, Size);
   Out << '/';
@@ -177,7 +198,7 @@ static std::string computeRelativePath(StringRef From, StringRef To) {
   return Relative.str();
 }
 
-static void writeStringTable(raw_fd_ostream &Out, StringRef ArcName,
+static void writeStringTable(raw_svector_ostream &Out, StringRef ArcName,
                              ArrayRef<NewArchiveIterator> Members,
                              std::vector<unsigned> &StringMapIndexes,
                              bool Thin) {
@@ -205,9 +226,7 @@ static void writeStringTable(raw_fd_ostream &Out, StringRef ArcName,
   if (Out.tell() % 2)
     Out << '\n';
   int Pos = Out.tell();
-  Out.seek(StartOffset - 12);
-  printWithSpacePadding(Out, Pos - StartOffset, 10);
-  Out.seek(Pos);
+  patchWithSpacePadding(Out, StartOffset - 12, Pos - StartOffset, 10);
 }
 
 static sys::TimeValue now(bool Deterministic) {
@@ -218,49 +237,137 @@ static sys::TimeValue now(bool Deterministic) {
   return TV;
 }
 
+namespace {
+/// The symbols of an archive member that go in the symbol table.
+struct MemberSymbols {
+  /// False if the member is not an object file, in which case it has no
+  /// symbols.
+  bool IsSymbolic = false;
+  /// The names of the symbols, each followed by a NUL.
+  std::string Names;
+  unsigned NumSymbols = 0;
+  std::error_code EC;
+};
+}
+
+static bool isArchiveSymbol(uint32_t Symflags) {
+  if (Symflags & object::SymbolRef::SF_FormatSpecific)
+    return false;
+  if (!(Symflags & object::SymbolRef::SF_Global))
+    return false;
+  if (Symflags & object::SymbolRef::SF_Undefined)
+    return false;
+  return true;
+}
+
+// Read the symbols of a member that go in the symbol table. The symbols of
+// bitcode are read from the records of the module when possible, which is
+// much cheaper than creating its IR. Context is created the first time IR
+// is needed and reused for the next members.
+static MemberSymbols readMemberSymbols(MemoryBufferRef MemberBuffer,
+                                       std::unique_ptr<LLVMContext> &Context) {
+  MemberSymbols Result;
+  if (sys::fs::identify_magic(MemberBuffer.getBuffer()) ==
+      sys::fs::file_magic::bitcode) {
+    ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+        readBitcodeSymbols(MemberBuffer);
+    if (SymbolsOrErr) {
+      Result.IsSymbolic = true;
+      for (const BitcodeSymbol &S : *SymbolsOrErr) {
+        if (S.IsFormatSpecific || S.IsDeclaration ||
+            GlobalValue::isLocalLinkage(S.Linkage))
+          continue;
+        Result.Names += S.Name;
+        Result.Names += '\0';
+        ++Result.NumSymbols;
+      }
+      return Result;
+    }
+    // Otherwise, let IRObjectFile read the module and its inline asm.
+  }
+
+  if (!Context)
+    Context.reset(new LLVMContext);
+  ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
+      object::SymbolicFile::createSymbolicFile(
+          MemberBuffer, sys::fs::file_magic::unknown, Context.get());
+  if (!ObjOrErr)
+    return Result;  // FIXME: check only for "not an object file" errors.
+  object::SymbolicFile &Obj = *ObjOrErr.get();
+
+  Result.IsSymbolic = true;
+  raw_string_ostream NameOS(Result.Names);
+  for (const object::BasicSymbolRef &S : Obj.symbols()) {
+    if (!isArchiveSymbol(S.getFlags()))
+      continue;
+    if (auto EC = S.printName(NameOS)) {
+      Result.EC = EC;
+      break;
+    }
+    NameOS << '\0';
+    ++Result.NumSymbols;
+  }
+  NameOS.flush();
+  return Result;
+}
+
+// Read the symbols of all the members, on NumThreads threads. Each batch of
+// members has an LLVMContext of its own.
+static std::vector<MemberSymbols>
+readAllMemberSymbols(ArrayRef<MemoryBufferRef> Buffers, unsigned NumThreads) {
+  std::vector<MemberSymbols> Symbols(Buffers.size());
+  auto ReadBatch = [&](size_t Begin, size_t End) {
+    std::unique_ptr<LLVMContext> Context;
+    for (size_t I = Begin; I != End; ++I)
+      Symbols[I] = readMemberSymbols(Buffers[I], Context);
+  };
+
+  if (NumThreads <= 1 || Buffers.size() <= 1) {
+    ReadBatch(0, Buffers.size());
+    return Symbols;
+  }
+
+  ThreadPool Pool(NumThreads);
+  parallelForBatches(Pool, Buffers.size(), NumThreads * 4,
+                     [&](size_t, size_t Begin, size_t End) {
+                       ReadBatch(Begin, End);
+                     });
+  return Symbols;
+}
+
 // Returns the offset of the first reference to a member offset.
 static ErrorOr<unsigned>
-writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
-                 ArrayRef<NewArchiveIterator> Members,
-                 ArrayRef<MemoryBufferRef> Buffers,
+writeSymbolTable(raw_svector_ostream &Out, object::Archive::Kind Kind,
+                 ArrayRef<MemberSymbols> Members,
                  std::vector<unsigned> &MemberOffsetRefs, bool Deterministic) {
   unsigned HeaderStartOffset = 0;
   unsigned BodyStartOffset = 0;
   SmallString<128> NameBuf;
   raw_svector_ostream NameOS(NameBuf);
-  LLVMContext Context;
   for (unsigned MemberNum = 0, N = Members.size(); MemberNum < N; ++MemberNum) {
-    MemoryBufferRef MemberBuffer = Buffers[MemberNum];
-    ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
-        object::SymbolicFile::createSymbolicFile(
-            MemberBuffer, sys::fs::file_magic::unknown, &Context);
-    if (!ObjOrErr)
-      continue;  // FIXME: check only for "not an object file" errors.
-    object::SymbolicFile &Obj = *ObjOrErr.get();
+    const MemberSymbols &Symbols = Members[MemberNum];
+    if (!Symbols.IsSymbolic)
+      continue;
+    if (Symbols.EC)
+      return Symbols.EC;
 
     if (!HeaderStartOffset) {
       HeaderStartOffset = Out.tell();
       if (Kind == object::Archive::K_GNU)
         printGNUSmallMemberHeader(Out, "", now(Deterministic), 0, 0, 0, 0);
       else
-        printBSDMemberHeader(Out, "__.SYMDEF", now(Deterministic), 0, 0, 0, 0);
+        printBSDMemberHeader(Out, Out.tell(), "__.SYMDEF", now(Deterministic),
+                             0, 0, 0, 0);
       BodyStartOffset = Out.tell();
       print32(Out, Kind, 0); // number of entries or bytes
     }
 
-    for (const object::BasicSymbolRef &S : Obj.symbols()) {
-      uint32_t Symflags = S.getFlags();
-      if (Symflags & object::SymbolRef::SF_FormatSpecific)
-        continue;
-      if (!(Symflags & object::SymbolRef::SF_Global))
-        continue;
-      if (Symflags & object::SymbolRef::SF_Undefined)
-        continue;
-
+    StringRef Names = Symbols.Names;
+    for (unsigned I = 0; I != Symbols.NumSymbols; ++I) {
       unsigned NameOffset = NameOS.tell();
-      if (auto EC = S.printName(NameOS))
-        return EC;
-      NameOS << '\0';
+      StringRef Name = Names.data();
+      NameOS << Name << '\0';
+      Names = Names.drop_front(Name.size() + 1);
       MemberOffsetRefs.push_back(MemberNum);
       if (Kind == object::Archive::K_BSD)
         print32(Out, Kind, NameOffset);
@@ -285,18 +392,18 @@ writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
   // Patch up the size of the symbol table now that we know how big it is.
   unsigned Pos = Out.tell();
   const unsigned MemberHeaderSize = 60;
-  Out.seek(HeaderStartOffset + 48); // offset of the size field.
-  printWithSpacePadding(Out, Pos - MemberHeaderSize - HeaderStartOffset, 10);
+  patchWithSpacePadding(Out, HeaderStartOffset + 48, // offset of the size field.
+                        Pos - MemberHeaderSize - HeaderStartOffset, 10);
 
   // Patch up the number of symbols.
-  Out.seek(BodyStartOffset);
   unsigned NumSyms = MemberOffsetRefs.size();
+  char Buf[4];
   if (Kind == object::Archive::K_GNU)
-    print32(Out, Kind, NumSyms);
+    write32(Buf, Kind, NumSyms);
   else
-    print32(Out, Kind, NumSyms * 8);
+    write32(Buf, Kind, NumSyms * 8);
+  Out.pwrite(Buf, sizeof(Buf), BodyStartOffset);
 
-  Out.seek(Pos);
   return BodyStartOffset + 4;
 }
 
@@ -304,15 +411,11 @@ std::pair<StringRef, std::error_code>
 llvm::writeArchive(StringRef ArcName,
                    std::vector<NewArchiveIterator> &NewMembers,
                    bool WriteSymtab, object::Archive::Kind Kind,
-                   bool Deterministic, bool Thin) {
-  SmallString<128> TmpArchive;
-  int TmpArchiveFD;
-  if (auto EC = sys::fs::createUniqueFile(ArcName + ".temp-archive-%%%%%%%.a",
-                                          TmpArchiveFD, TmpArchive))
-    return std::make_pair(ArcName, EC);
-
-  tool_output_file Output(TmpArchive, TmpArchiveFD);
-  raw_fd_ostream &Out = Output.os();
+                   bool Deterministic, bool Thin, unsigned NumThreads) {
+  // Everything but the contents of the members is rendered to memory first,
+  // so that the size of the archive is known before it is written.
+  SmallString<0> Head;
+  raw_svector_ostream Out(Head);
   if (Thin)
     Out << "!<thin>\n";
   else
@@ -360,8 +463,10 @@ llvm::writeArchive(StringRef ArcName,
 
   unsigned MemberReferenceOffset = 0;
   if (WriteSymtab) {
+    std::vector<MemberSymbols> Symbols =
+        readAllMemberSymbols(Members, NumThreads);
     ErrorOr<unsigned> MemberReferenceOffsetOrErr = writeSymbolTable(
-        Out, Kind, NewMembers, Members, MemberOffsetRefs, Deterministic);
+        Out, Kind, Symbols, MemberOffsetRefs, Deterministic);
     if (auto EC = MemberReferenceOffsetOrErr.getError())
       return std::make_pair(ArcName, EC);
     MemberReferenceOffset = MemberReferenceOffsetOrErr.get();
@@ -371,14 +476,17 @@ llvm::writeArchive(StringRef ArcName,
   if (Kind != object::Archive::K_BSD)
     writeStringTable(Out, ArcName, NewMembers, StringMapIndexes, Thin);
 
+  // Lay the members out after the symbol and string tables.
   unsigned MemberNum = 0;
   unsigned NewMemberNum = 0;
   std::vector<unsigned>::iterator StringMapIndexIter = StringMapIndexes.begin();
   std::vector<unsigned> MemberOffset;
+  std::vector<std::string> MemberHeaders(NewMembers.size());
+  uint64_t Pos = Head.size();
   for (const NewArchiveIterator &I : NewMembers) {
-    MemoryBufferRef File = Members[MemberNum++];
+    MemoryBufferRef File = Members[MemberNum];
+    raw_string_ostream HeaderOS(MemberHeaders[MemberNum++]);
 
-    unsigned Pos = Out.tell();
     MemberOffset.push_back(Pos);
 
     sys::TimeValue ModTime;
@@ -407,38 +515,66 @@ llvm::writeArchive(StringRef ArcName,
     if (I.isNewMember()) {
       StringRef FileName = I.getNew();
       const sys::fs::file_status &Status = NewMemberStatus[NewMemberNum++];
-      printMemberHeader(Out, Kind, Thin, sys::path::filename(FileName),
-                        StringMapIndexIter, ModTime, UID, GID, Perms,
-                        Status.getSize());
+      printMemberHeader(HeaderOS, Pos, Kind, Thin,
+                        sys::path::filename(FileName), StringMapIndexIter,
+                        ModTime, UID, GID, Perms, Status.getSize());
     } else {
       const object::Archive::Child &OldMember = I.getOld();
       ErrorOr<uint32_t> Size = OldMember.getSize();
       if (std::error_code EC = Size.getError())
         return std::make_pair("", EC);
       StringRef FileName = I.getName();
-      printMemberHeader(Out, Kind, Thin, sys::path::filename(FileName),
-                        StringMapIndexIter, ModTime, UID, GID, Perms,
-                        Size.get());
+      printMemberHeader(HeaderOS, Pos, Kind, Thin,
+                        sys::path::filename(FileName), StringMapIndexIter,
+                        ModTime, UID, GID, Perms, Size.get());
     }
+    HeaderOS.flush();
 
+    Pos += MemberHeaders[MemberNum - 1].size();
     if (!Thin)
-      Out << File.getBuffer();
-
-    if (Out.tell() % 2)
-      Out << '\n';
+      Pos += File.getBufferSize();
+    // Members are aligned to two bytes with a newline.
+    Pos += Pos % 2;
   }
 
   if (MemberReferenceOffset) {
-    Out.seek(MemberReferenceOffset);
+    char *Ref = &Head[MemberReferenceOffset];
     for (unsigned MemberNum : MemberOffsetRefs) {
       if (Kind == object::Archive::K_BSD)
-        Out.seek(Out.tell() + 4); // skip over the string offset
-      print32(Out, Kind, MemberOffset[MemberNum]);
+        Ref += 4; // skip over the string offset
+      write32(Ref, Kind, MemberOffset[MemberNum]);
+      Ref += 4;
     }
   }
 
+  // Write to a temporary file first, so that the old archive is only replaced
+  // once the new one is complete.
+  SmallString<128> TmpArchive;
+  int TmpArchiveFD;
+  if (auto EC = sys::fs::createUniqueFile(ArcName + ".temp-archive-%%%%%%%.a",
+                                          TmpArchiveFD, TmpArchive))
+    return std::make_pair(ArcName, EC);
+
+  tool_output_file Output(TmpArchive, TmpArchiveFD);
+  raw_fd_ostream &OutFile = Output.os();
+  OutFile << Head;
+  for (unsigned I = 0, N = NewMembers.size(); I != N; ++I) {
+    assert(OutFile.tell() == MemberOffset[I]);
+    OutFile << MemberHeaders[I];
+    if (!Thin)
+      OutFile << Members[I].getBuffer();
+    if (OutFile.tell() % 2)
+      OutFile << '\n';
+  }
+  assert(OutFile.tell() == Pos);
+
+  OutFile.close();
+  if (OutFile.has_error()) {
+    OutFile.clear_error();
+    return std::make_pair(ArcName, make_error_code(errc::io_error));
+  }
+  if (auto EC = sys::fs::rename(TmpArchive, ArcName))
+    return std::make_pair(ArcName, EC);
   Output.keep();
-  Out.close();
-  sys::fs::rename(TmpArchive, ArcName);
   return std::make_pair("", std::error_code());
 }
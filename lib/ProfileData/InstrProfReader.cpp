@@ -14,14 +14,18 @@
 
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
 #include <cassert>
+#include <map>
 
 using namespace llvm;
 
 static ErrorOr<std::unique_ptr<MemoryBuffer>>
-setupMemoryBuffer(std::string Path) {
+setupMemoryBuffer(std::string Path, bool RequiresNullTerminator = true) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFileOrSTDIN(Path);
+      MemoryBuffer::getFileOrSTDIN(Path, -1, RequiresNullTerminator);
   if (std::error_code EC = BufferOrErr.getError())
     return EC;
   return std::move(BufferOrErr.get());
@@ -68,8 +72,9 @@ InstrProfReader::create(std::unique_ptr<MemoryBuffer> Buffer) {
 
 ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
 IndexedInstrProfReader::create(std::string Path) {
-  // Set up the buffer to read.
-  auto BufferOrError = setupMemoryBuffer(Path);
+  // Set up the buffer to read. The indexed format does not need a null
+  // terminator, so the file can always be mapped rather than copied.
+  auto BufferOrError = setupMemoryBuffer(Path, false);
   if (std::error_code EC = BufferOrError.getError())
     return EC;
   return IndexedInstrProfReader::create(std::move(BufferOrError.get()));
@@ -517,6 +522,69 @@ std::error_code InstrProfReaderIndex<HashTableImpl>::getRecords(
   return instrprof_error::success;
 }
 
+std::error_code InstrProfLookupTrait::findRecordRef(
+    StringRef K, const unsigned char *D, offset_type N, uint64_t FuncHash,
+    InstrProfRecordRef &Record) const {
+  // Check if the data is corrupt. If so, don't try to read it.
+  if (N % sizeof(uint64_t))
+    return instrprof_error::malformed;
+
+  using namespace support;
+  const unsigned char *End = D + N;
+  while (D < End) {
+    // Read hash.
+    if (D + sizeof(uint64_t) >= End)
+      return instrprof_error::malformed;
+    uint64_t Hash = endian::readNext<uint64_t, little, unaligned>(D);
+
+    // Initialize number of counters for FormatVersion == 1.
+    uint64_t CountsSize = N / sizeof(uint64_t) - 1;
+    // If format version is different then read the number of counters.
+    if (FormatVersion != 1) {
+      if (D + sizeof(uint64_t) > End)
+        return instrprof_error::malformed;
+      CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
+    }
+    if (CountsSize > (uint64_t)(End - D) / sizeof(uint64_t))
+      return instrprof_error::malformed;
+    ArrayRef<ulittle64_t> Counts(reinterpret_cast<const ulittle64_t *>(D),
+                                 CountsSize);
+    D += CountsSize * sizeof(uint64_t);
+
+    if (Hash == FuncHash) {
+      Record.Name = K;
+      Record.Hash = Hash;
+      Record.Counts = Counts;
+      return instrprof_error::success;
+    }
+
+    // Skip over the value profiling data, which starts with its total size.
+    if (FormatVersion > 2) {
+      if (D + sizeof(ValueProfData) > End)
+        return instrprof_error::malformed;
+      uint32_t TotalSize =
+          ValueProfDataEndianness == little
+              ? endian::read<uint32_t, little, unaligned>(D)
+              : endian::read<uint32_t, big, unaligned>(D);
+      if (TotalSize < sizeof(ValueProfData) || TotalSize > (uint64_t)(End - D))
+        return instrprof_error::malformed;
+      D += TotalSize;
+    }
+  }
+  return instrprof_error::hash_mismatch;
+}
+
+template <typename HashTableImpl>
+std::error_code InstrProfReaderIndex<HashTableImpl>::getRecordRef(
+    StringRef FuncName, uint64_t FuncHash, InstrProfRecordRef &Record) {
+  auto Iter = HashTable->find(FuncName);
+  if (Iter == HashTable->end())
+    return instrprof_error::unknown_function;
+
+  return HashTable->getInfoObj().findRecordRef(
+      FuncName, Iter.getDataPtr(), Iter.getDataLen(), FuncHash, Record);
+}
+
 template <typename HashTableImpl>
 std::error_code InstrProfReaderIndex<HashTableImpl>::getRecords(
     ArrayRef<InstrProfRecord> &Data) {
@@ -623,17 +691,89 @@ IndexedInstrProfReader::getInstrProfRecord(StringRef FuncName,
   return error(instrprof_error::hash_mismatch);
 }
 
+ErrorOr<InstrProfRecordRef>
+IndexedInstrProfReader::getInstrProfRecordRef(StringRef FuncName,
+                                              uint64_t FuncHash) {
+  // This must not go through error(), which records the last error in the
+  // reader and would race with other threads doing lookups.
+  InstrProfRecordRef Record;
+  if (std::error_code EC = Index->getRecordRef(FuncName, FuncHash, Record))
+    return EC;
+  return Record;
+}
+
 std::error_code
 IndexedInstrProfReader::getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                                           std::vector<uint64_t> &Counts) {
-  ErrorOr<InstrProfRecord> Record = getInstrProfRecord(FuncName, FuncHash);
-  if (std::error_code EC = Record.getError())
+  ErrorOr<InstrProfRecordRef> Record =
+      getInstrProfRecordRef(FuncName, FuncHash);
+  if (std::error_code EC = Record.getError()) {
+    if (EC == instrprof_error::hash_mismatch)
+      return error(EC);
     return EC;
+  }
 
-  Counts = Record.get().Counts;
+  Counts.assign(Record->Counts.begin(), Record->Counts.end());
   return success();
 }
 
+namespace {
+/// A reader in the process-wide cache, along with the path it was opened
+/// through and the state of the file at that time.
+struct SharedReaderEntry {
+  std::string Path;
+  sys::TimeValue ModTime;
+  uint64_t Size;
+  std::shared_ptr<IndexedInstrProfReader> Reader;
+
+  /// Whether the file at Path is still the one the reader was created from.
+  bool isCurrent(const sys::fs::UniqueID &ID) const {
+    sys::fs::file_status Status;
+    return !sys::fs::status(Path, Status) && Status.getUniqueID() == ID &&
+           Status.getLastModificationTime() == ModTime &&
+           Status.getSize() == Size;
+  }
+};
+} // end anonymous namespace
+
+static ManagedStatic<sys::SmartMutex<true> > SharedReadersLock;
+static ManagedStatic<std::map<sys::fs::UniqueID, SharedReaderEntry> >
+    SharedReaders;
+
+ErrorOr<std::shared_ptr<IndexedInstrProfReader>>
+IndexedInstrProfReader::getShared(StringRef Path) {
+  sys::SmartScopedLock<true> Lock(*SharedReadersLock);
+
+  // Drop the readers of the files that were removed or changed since, so
+  // that they are unmapped once their last user is done with them. There are
+  // only as many entries as there are distinct profiles in use.
+  for (auto I = SharedReaders->begin(), E = SharedReaders->end(); I != E;) {
+    auto Cur = I++;
+    if (!Cur->second.isCurrent(Cur->first))
+      SharedReaders->erase(Cur);
+  }
+
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(Path, Status))
+    return EC;
+
+  // Key on the identity of the file so that different paths to the same
+  // profile share a reader.
+  auto I = SharedReaders->find(Status.getUniqueID());
+  if (I != SharedReaders->end())
+    return I->second.Reader;
+
+  auto ReaderOrErr = create(Path);
+  if (std::error_code EC = ReaderOrErr.getError())
+    return EC;
+  SharedReaderEntry &Entry = (*SharedReaders)[Status.getUniqueID()];
+  Entry.Path = Path;
+  Entry.ModTime = Status.getLastModificationTime();
+  Entry.Size = Status.getSize();
+  Entry.Reader = std::move(ReaderOrErr.get());
+  return Entry.Reader;
+}
+
 std::error_code IndexedInstrProfReader::readNextRecord(
     InstrProfRecord &Record) {
   static unsigned RecordIndex = 0;
@@ -127,6 +127,17 @@ std::error_code InstrProfWriter::addRecord(InstrProfRecord &&I,
   return Result;
 }
 
+void InstrProfWriter::mergeRecordsFromWriter(
+    InstrProfWriter &&IPW,
+    function_ref<void(std::error_code, StringRef)> Warn) {
+  for (auto &I : IPW.FunctionData)
+    for (auto &Func : I.getValue())
+      if (std::error_code EC = addRecord(std::move(Func.second)))
+        Warn(EC, I.getKey());
+  IPW.FunctionData.clear();
+  IPW.MaxFunctionCount = 0;
+}
+
 std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
   OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
 
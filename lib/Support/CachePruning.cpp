@@ -0,0 +1,158 @@
+//===-CachePruning.cpp - LLVM Cache Directory Pruning ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the pruning of a directory based on least recently used.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CachePruning.h"
+
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "cache-pruning"
+
+#include <set>
+#include <tuple>
+
+using namespace llvm;
+
+/// Write a new timestamp file with the given path. This is used for the pruning
+/// interval option.
+static void writeTimestampFile(StringRef TimestampFile) {
+  std::error_code EC;
+  raw_fd_ostream Out(TimestampFile.str(), EC, sys::fs::F_None);
+}
+
+void CachePruning::touch(StringRef EntryPath) {
+  int FD;
+  if (sys::fs::openFileForWrite(EntryPath, FD, sys::fs::F_Append))
+    return;
+  sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+  sys::Process::SafelyCloseFileDescriptor(FD);
+}
+
+/// Return true if \p Filename is a lock file (as created by LockFileManager,
+/// "<entry>.lock" and "<entry>.lock-XXXX") or a temporary file that is renamed
+/// into place once complete. They may be in use by another process.
+static bool isInFlightFile(StringRef Filename) {
+  return Filename.find(".lock") != StringRef::npos ||
+         Filename.endswith(".tmp");
+}
+
+/// Prune the cache of files that haven't been accessed in a long time.
+bool CachePruning::prune() {
+  if (Path.empty())
+    return false;
+
+  bool isPathDir;
+  if (sys::fs::is_directory(Path, isPathDir))
+    return false;
+
+  if (!isPathDir)
+    return false;
+
+  if (Expiration == 0 && MaxSize == 0) {
+    DEBUG(dbgs() << "No pruning settings set, exit early\n");
+    // Nothing will be pruned, early exit
+    return false;
+  }
+
+  // Try to stat() the timestamp file.
+  SmallString<128> TimestampFile(Path);
+  sys::path::append(TimestampFile, "llvmcache.timestamp");
+  sys::fs::file_status FileStatus;
+  sys::TimeValue CurrentTime = sys::TimeValue::now();
+  if (sys::fs::status(TimestampFile, FileStatus)) {
+    // If the timestamp file wasn't there, create one now.
+    writeTimestampFile(TimestampFile);
+  } else {
+    if (Interval) {
+      // Check whether the time stamp is older than our pruning interval.
+      // If not, do nothing.
+      sys::TimeValue TimeStampModTime = FileStatus.getLastModificationTime();
+      auto TimeInterval = sys::TimeValue(sys::TimeValue::SecondsType(Interval));
+      auto TimeStampAge = CurrentTime - TimeStampModTime;
+      if (TimeStampAge <= TimeInterval) {
+        DEBUG(dbgs() << "Timestamp file too recent (" << TimeStampAge.seconds()
+                     << "s old), do not prune.\n");
+        return false;
+      }
+    }
+    // Write a new timestamp file so that nobody else attempts to prune.
+    // There is a benign race condition here, if two processes happen to
+    // notice at the same time that the timestamp is out-of-date.
+    writeTimestampFile(TimestampFile);
+  }
+
+  // Keep track of space, ordered by the last use so the least recently used
+  // entries are removed first when the size limit is exceeded.
+  std::set<std::tuple<sys::TimeValue, uint64_t, std::string>> FileInfos;
+  uint64_t TotalSize = 0;
+
+  // Walk the entire directory cache, looking for unused files.
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  sys::path::native(Path, CachePathNative);
+  auto TimeExpiration = sys::TimeValue(sys::TimeValue::SecondsType(Expiration));
+  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    // Do not touch the timestamp or any file that is not a cache entry.
+    StringRef Filename = sys::path::filename(File->path());
+    if (!Filename.startswith("llvmcache-"))
+      continue;
+
+    // Look at this file. If we can't stat it, there's nothing interesting
+    // there.
+    if (File->status(FileStatus)) {
+      DEBUG(dbgs() << "Ignore " << File->path() << " (can't stat)\n");
+      continue;
+    }
+
+    // If the file hasn't been used recently enough, delete it. Lock and
+    // temporary files are only ever removed this way: once they are that old,
+    // the process that created them is gone.
+    sys::TimeValue FileModTime = FileStatus.getLastModificationTime();
+    auto FileAge = CurrentTime - FileModTime;
+    if (Expiration && FileAge > TimeExpiration) {
+      DEBUG(dbgs() << "Remove " << File->path() << " ("
+                   << FileAge.seconds() << "s old)\n");
+      sys::fs::remove(File->path());
+      continue;
+    }
+    if (isInFlightFile(Filename))
+      continue;
+
+    // Leave it here for now, but add it to the list of size-based pruning.
+    TotalSize += FileStatus.getSize();
+    FileInfos.insert(
+        std::make_tuple(FileModTime, FileStatus.getSize(), File->path()));
+  }
+
+  // Prune for size now if needed.
+  if (MaxSize && TotalSize > MaxSize) {
+    DEBUG(dbgs() << "Occupancy: " << TotalSize << " bytes, limit " << MaxSize
+                 << " bytes\n");
+    auto FileInfo = FileInfos.begin();
+    while (TotalSize > MaxSize && FileInfo != FileInfos.end()) {
+      // Remove the file.
+      sys::fs::remove(std::get<2>(*FileInfo));
+      // Update size
+      TotalSize -= std::get<1>(*FileInfo);
+      DEBUG(dbgs() << " - Remove " << std::get<2>(*FileInfo) << " (size "
+                   << std::get<1>(*FileInfo) << "), new occupancy is "
+                   << TotalSize << " bytes\n");
+      ++FileInfo;
+    }
+  }
+  return true;
+}
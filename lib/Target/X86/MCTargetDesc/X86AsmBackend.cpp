@@ -120,6 +120,8 @@ public:
 
   bool mayNeedRelaxation(const MCInst &Inst) const override;
 
+  bool fixupRelaxationOnlyDependsOnValue() const override { return true; }
+
   bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
                             const MCRelaxableFragment *DF,
                             const MCAsmLayout &Layout) const override;
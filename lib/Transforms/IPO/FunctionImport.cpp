@@ -70,8 +70,9 @@ public:
       std::unique_ptr<Module>(StringRef FileName)> createLazyModule)
       : createLazyModule(createLazyModule) {}
 
-  /// Retrieve a Module from the cache or lazily load it on demand.
-  Module &operator()(StringRef FileName);
+  /// Retrieve a Module from the cache or lazily load it on demand. Returns
+  /// nullptr if the module can't be loaded.
+  Module *operator()(StringRef FileName);
 
   std::unique_ptr<Module> takeModule(StringRef FileName) {
     auto I = ModuleMap.find(FileName);
@@ -83,11 +84,11 @@ public:
 };
 
 // Get a Module for \p FileName from the cache, or load it lazily.
-Module &ModuleLazyLoaderCache::operator()(StringRef Identifier) {
+Module *ModuleLazyLoaderCache::operator()(StringRef Identifier) {
   auto &Module = ModuleMap[Identifier];
   if (!Module)
     Module = createLazyModule(Identifier);
-  return *Module;
+  return Module.get();
 }
 } // anonymous namespace
 
@@ -206,7 +207,14 @@ static void GetImportList(Module &DestModule,
     DEBUG(dbgs() << DestModule.getModuleIdentifier() << ": Importing "
                  << CalledFunctionName << " from " << ModuleIdentifier << "\n");
 
-    auto &SrcModule = ModuleLoaderCache(ModuleIdentifier);
+    Module *SrcModulePtr = ModuleLoaderCache(ModuleIdentifier);
+    if (!SrcModulePtr) {
+      DEBUG(dbgs() << DestModule.getModuleIdentifier() << ": Can't load "
+                   << ModuleIdentifier << ", not importing "
+                   << CalledFunctionName << "\n");
+      continue;
+    }
+    auto &SrcModule = *SrcModulePtr;
 
     // The function that we will import!
     GlobalValue *SGV = SrcModule.getNamedValue(CalledFunctionName);
@@ -263,7 +271,8 @@ static void GetImportList(Module &DestModule,
 //
 // The current implementation imports every called functions that exists in the
 // summaries index.
-bool FunctionImporter::importFunctions(Module &DestModule) {
+bool FunctionImporter::importFunctions(Module &DestModule,
+                                       ImportListTy *ImportList) {
   DEBUG(dbgs() << "Starting import for Module "
                << DestModule.getModuleIdentifier() << "\n");
   unsigned ImportedCount = 0;
@@ -307,6 +316,12 @@ bool FunctionImporter::importFunctions(Module &DestModule) {
     assert(&DestModule.getContext() == &SrcModule->getContext() &&
            "Context mismatch");
 
+    if (ImportList) {
+      auto &Imported = (*ImportList)[SrcModule->getModuleIdentifier()];
+      for (const GlobalValue *GV : FunctionsToImport)
+        Imported.insert(GV->getName());
+    }
+
     // Save the mapping of value ids to temporary metadata created when
     // importing this function. If we have already imported from this module,
     // add new temporary metadata to the existing mapping.
@@ -326,7 +341,7 @@ bool FunctionImporter::importFunctions(Module &DestModule) {
   for (StringMapEntry<std::unique_ptr<DenseMap<unsigned, MDNode *>>> &SME :
        ModuleToTempMDValsMap) {
     // Load the specified source module.
-    auto &SrcModule = ModuleLoaderCache(SME.getKey());
+    auto &SrcModule = *ModuleLoaderCache(SME.getKey());
     // The modules were created with lazy metadata loading. Materialize it
     // now, before linking it.
     SrcModule.materializeMetadata();
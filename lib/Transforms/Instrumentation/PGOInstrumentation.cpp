@@ -129,7 +129,7 @@ public:
 
 private:
   std::string ProfileFileName;
-  std::unique_ptr<IndexedInstrProfReader> PGOReader;
+  std::shared_ptr<IndexedInstrProfReader> PGOReader;
   bool runOnModule(Module &M) override;
 
   void getAnalysisUsage(AnalysisUsage &AU) const override {
@@ -415,7 +415,7 @@ private:
   uint64_t ProgramMaxCount;
 
   // Find the Instrumented BB and set the value.
-  void setInstrumentedCounts(const std::vector<uint64_t> &CountFromProfile);
+  void setInstrumentedCounts(ArrayRef<support::ulittle64_t> CountFromProfile);
 
   // Set the edge counter value for the unknown edge -- there should be only
   // one unknown edge.
@@ -458,7 +458,7 @@ public:
 // Visit all the edges and assign the count value for the instrumented
 // edges and the BB.
 void PGOUseFunc::setInstrumentedCounts(
-    const std::vector<uint64_t> &CountFromProfile) {
+    ArrayRef<support::ulittle64_t> CountFromProfile) {
 
   // Use a worklist as we will update the vector during the iteration.
   std::vector<PGOUseEdge *> WorkList;
@@ -511,8 +511,8 @@ void PGOUseFunc::setEdgeCount(DirectEdges &Edges, uint64_t Value) {
 // Return true if the profile are successfully read, and false on errors.
 bool PGOUseFunc::readCounters(IndexedInstrProfReader *PGOReader) {
   auto &Ctx = M->getContext();
-  ErrorOr<InstrProfRecord> Result =
-      PGOReader->getInstrProfRecord(FuncInfo.FuncName, FuncInfo.FunctionHash);
+  ErrorOr<InstrProfRecordRef> Result = PGOReader->getInstrProfRecordRef(
+      FuncInfo.FuncName, FuncInfo.FunctionHash);
   if (std::error_code EC = Result.getError()) {
     if (EC == instrprof_error::unknown_function)
       NumOfPGOMissing++;
@@ -525,7 +525,7 @@ bool PGOUseFunc::readCounters(IndexedInstrProfReader *PGOReader) {
         DiagnosticInfoPGOProfile(M->getName().data(), Msg, DS_Warning));
     return false;
   }
-  std::vector<uint64_t> &CountFromProfile = Result.get().Counts;
+  ArrayRef<support::ulittle64_t> CountFromProfile = Result.get().Counts;
 
   NumOfPGOFunc++;
   DEBUG(dbgs() << CountFromProfile.size() << " counts\n");
@@ -689,15 +689,16 @@ static void setPGOCountOnFunc(PGOUseFunc &Func,
 bool PGOInstrumentationUse::runOnModule(Module &M) {
   DEBUG(dbgs() << "Read in profile counters: ");
   auto &Ctx = M.getContext();
-  // Read the counter array from file.
-  auto ReaderOrErr = IndexedInstrProfReader::create(ProfileFileName);
+  // Read the counter array from file. The reader is shared with every other
+  // module compiled against the same profile in this process.
+  auto ReaderOrErr = IndexedInstrProfReader::getShared(ProfileFileName);
   if (std::error_code EC = ReaderOrErr.getError()) {
     Ctx.diagnose(
         DiagnosticInfoPGOProfile(ProfileFileName.data(), EC.message()));
     return false;
   }
 
-  PGOReader = std::move(ReaderOrErr.get());
+  PGOReader = ReaderOrErr.get();
   if (!PGOReader) {
     Ctx.diagnose(DiagnosticInfoPGOProfile(ProfileFileName.data(),
                                           "Cannot get PGOReader"));
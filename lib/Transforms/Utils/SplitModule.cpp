@@ -14,18 +14,29 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalObject.h"
 #include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
 
 using namespace llvm;
 
+#define DEBUG_TYPE "split-module"
+
+typedef EquivalenceClasses<const GlobalValue *> ClusterMapType;
+typedef DenseMap<const GlobalValue *, unsigned> ClusterIDMapType;
+
 static void externalize(GlobalValue *GV) {
   if (GV->hasLocalLinkage()) {
     GV->setLinkage(GlobalValue::ExternalLinkage);
@@ -60,9 +71,192 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
   return (R[0] | (R[1] << 8)) % N == I;
 }
 
+/// Put every global value using \p V, looking through constant expressions, in
+/// the same cluster as \p GV.
+static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
+                                   const GlobalValue *GV, const Value *V) {
+  SmallVector<const User *, 4> Worklist(V->user_begin(), V->user_end());
+  while (!Worklist.empty()) {
+    const User *U = Worklist.pop_back_val();
+    if (auto *I = dyn_cast<Instruction>(U)) {
+      GVtoClusterMap.unionSets(GV, I->getParent()->getParent());
+    } else if (auto *UGV = dyn_cast<GlobalValue>(U)) {
+      GVtoClusterMap.unionSets(GV, UGV);
+    } else if (isa<Constant>(U)) {
+      // A constant that is not a global value: look at its users.
+      Worklist.append(U->user_begin(), U->user_end());
+    }
+  }
+}
+
+/// Estimated code generation cost of \p GV: the number of instructions for a
+/// function, one for any other global.
+static uint64_t getWeight(const GlobalValue &GV) {
+  auto *F = dyn_cast<Function>(&GV);
+  if (!F)
+    return 1;
+  uint64_t Weight = 1;
+  for (const BasicBlock &BB : *F)
+    Weight += BB.size();
+  return Weight;
+}
+
+/// Group the global values of \p M that must stay in the same partition into
+/// clusters, and assign the clusters to \p N partitions, balancing the total
+/// weight of each partition. A local is clustered with everything that
+/// references it, a comdat member with the other members of its comdat, an
+/// alias with its aliasee, and a function whose block addresses escape with
+/// their users.
+///
+/// The assignment only depends on the module content and order: clusters are
+/// placed by decreasing weight, each into the lightest partition so far (the
+/// first one on ties), and clusters of equal weight are placed in module order.
+///
+/// If \p PreserveOrder is true, the clusters are instead cut into N contiguous
+/// runs of roughly equal weight, in the order their first member appears in
+/// the module.
+static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
+                           unsigned N, bool PreserveOrder) {
+  ClusterMapType GVtoClusterMap;
+  DenseMap<const Comdat *, const GlobalValue *> ComdatMembers;
+  std::vector<const GlobalValue *> Definitions;
+
+  auto recordGVSet = [&](GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+    Definitions.push_back(&GV);
+    GVtoClusterMap.insert(&GV);
+
+    // Comdat groups must not be partitioned.
+    if (const Comdat *C = GV.getComdat()) {
+      auto &Member = ComdatMembers[C];
+      if (Member)
+        GVtoClusterMap.unionSets(Member, &GV);
+      else
+        Member = &GV;
+    }
+    // Aliases are never separated from their aliasee, regardless of linkage.
+    if (auto *GA = dyn_cast<GlobalAlias>(&GV))
+      if (const GlobalObject *Base = GA->getBaseObject())
+        GVtoClusterMap.unionSets(&GV, Base);
+    // Block addresses can only be referenced from their own module.
+    if (auto *F = dyn_cast<Function>(&GV))
+      for (const BasicBlock &BB : *F)
+        if (BlockAddress *BA = BlockAddress::lookup(&BB))
+          if (BA->isConstantUsed())
+            addAllGlobalValueUsers(GVtoClusterMap, F, BA);
+    if (GV.hasLocalLinkage())
+      addAllGlobalValueUsers(GVtoClusterMap, &GV, &GV);
+  };
+
+  for (Function &F : M)
+    recordGVSet(F);
+  for (GlobalVariable &GV : M.globals())
+    recordGVSet(GV);
+  for (GlobalAlias &GA : M.aliases())
+    recordGVSet(GA);
+
+  // Number the clusters in the order their first member appears in the
+  // module, and compute their weight. The iteration order of the equivalence
+  // classes themselves is not deterministic.
+  struct Cluster {
+    const GlobalValue *Leader;
+    uint64_t Weight;
+  };
+  std::vector<Cluster> Clusters;
+  DenseMap<const GlobalValue *, unsigned> LeaderToCluster;
+  for (const GlobalValue *GV : Definitions) {
+    const GlobalValue *Leader = GVtoClusterMap.getLeaderValue(GV);
+    auto Ins = LeaderToCluster.insert(std::make_pair(Leader, Clusters.size()));
+    if (Ins.second)
+      Clusters.push_back({Leader, 0});
+    Clusters[Ins.first->second].Weight += getWeight(*GV);
+  }
+
+  std::vector<uint64_t> PartitionWeights(N, 0);
+  std::vector<unsigned> ClusterToPartition(Clusters.size());
+  if (PreserveOrder) {
+    uint64_t TotalWeight = 0;
+    for (const Cluster &C : Clusters)
+      TotalWeight += C.Weight;
+
+    // Move on to the next partition once the clusters placed so far reach its
+    // share of the total weight.
+    unsigned P = 0;
+    uint64_t Placed = 0;
+    for (unsigned C = 0, E = Clusters.size(); C != E; ++C) {
+      ClusterToPartition[C] = P;
+      PartitionWeights[P] += Clusters[C].Weight;
+      Placed += Clusters[C].Weight;
+      if (P + 1 < N && Placed * N >= TotalWeight * (P + 1))
+        ++P;
+    }
+  } else {
+    std::vector<unsigned> Order(Clusters.size());
+    for (unsigned I = 0, E = Clusters.size(); I != E; ++I)
+      Order[I] = I;
+    std::stable_sort(Order.begin(), Order.end(), [&](unsigned A, unsigned B) {
+      return Clusters[A].Weight > Clusters[B].Weight;
+    });
+
+    for (unsigned C : Order) {
+      unsigned Lightest =
+          std::min_element(PartitionWeights.begin(), PartitionWeights.end()) -
+          PartitionWeights.begin();
+      ClusterToPartition[C] = Lightest;
+      PartitionWeights[Lightest] += Clusters[C].Weight;
+    }
+  }
+
+  for (const GlobalValue *GV : Definitions)
+    ClusterIDMap[GV] = ClusterToPartition[LeaderToCluster.lookup(
+        GVtoClusterMap.getLeaderValue(GV))];
+
+  DEBUG({
+    dbgs() << "Split " << M.getModuleIdentifier() << " (" << Clusters.size()
+           << " clusters) into partitions of weight:";
+    for (uint64_t Weight : PartitionWeights)
+      dbgs() << ' ' << Weight;
+    dbgs() << '\n';
+  });
+}
+
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
-    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback) {
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback,
+    bool PreserveLocals, bool PreserveOrder) {
+  if (PreserveLocals || PreserveOrder) {
+    // Locals stay local, but unnamed entities must still be named
+    // consistently between modules.
+    auto nameUnnamed = [](GlobalValue &GV) {
+      if (!GV.hasName())
+        GV.setName("__llvmsplit_unnamed");
+    };
+    for (Function &F : *M)
+      nameUnnamed(F);
+    for (GlobalVariable &GV : M->globals())
+      nameUnnamed(GV);
+    for (GlobalAlias &GA : M->aliases())
+      nameUnnamed(GA);
+
+    ClusterIDMapType ClusterIDMap;
+    findPartitions(*M, ClusterIDMap, N, PreserveOrder);
+
+    for (unsigned I = 0; I != N; ++I) {
+      ValueToValueMapTy VMap;
+      std::unique_ptr<Module> MPart(
+          CloneModule(M.get(), VMap, [&](const GlobalValue *GV) {
+            // Declarations are copied as they are to every partition.
+            auto It = ClusterIDMap.find(GV);
+            return It == ClusterIDMap.end() || It->second == I;
+          }));
+      if (I != 0)
+        MPart->setModuleInlineAsm("");
+      ModuleCallback(std::move(MPart));
+    }
+    return;
+  }
+
   for (Function &F : *M)
     externalize(&F);
   for (GlobalVariable &GV : M->globals())
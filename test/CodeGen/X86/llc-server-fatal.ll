@@ -0,0 +1,23 @@
+; RUN: echo "%S/llc-server.ll %t.0.s" > %t.jobs
+; RUN: echo "%s %t.1.s" >> %t.jobs
+; RUN: echo "%S/llc-server.ll %t.2.s" >> %t.jobs
+; RUN: not llc -mtriple=x86_64-unknown-linux-gnu -server < %t.jobs 2> %t.err \
+; RUN:   | FileCheck %s
+; RUN: FileCheck --check-prefix=ERR %s < %t.err
+; RUN: not ls %t.1.s %t.2.s
+
+; A fatal error in the backend answers the current job with "error" before the
+; server exits.
+; CHECK: ok
+; CHECK-NEXT: error
+; CHECK-NOT: ok
+; ERR: LLVM ERROR: Invalid register name global variable
+
+define i64 @bad() {
+  %r = call i64 @llvm.read_register.i64(metadata !0)
+  ret i64 %r
+}
+
+declare i64 @llvm.read_register.i64(metadata)
+
+!0 = !{!"notareg"}
@@ -0,0 +1,24 @@
+; RUN: echo "%s %t.0.s" > %t.jobs
+; RUN: echo "%t.missing.ll %t.1.s" >> %t.jobs
+; RUN: echo "%s %t.2.s" >> %t.jobs
+; RUN: echo "- %t.3.s" >> %t.jobs
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -server < %t.jobs 2> %t.err \
+; RUN:   | FileCheck --check-prefix=STATUS %s
+; RUN: FileCheck --check-prefix=ERR %s < %t.err
+; RUN: FileCheck %s < %t.0.s
+; RUN: FileCheck %s < %t.2.s
+
+; A failing job is reported, and does not stop the following ones.
+; STATUS: ok
+; STATUS-NEXT: error
+; STATUS-NEXT: ok
+; STATUS-NEXT: error
+; ERR: missing.ll
+; ERR: error: jobs must have an input file
+
+; CHECK-LABEL: foo:
+; CHECK: leal 1(%rdi), %eax
+define i32 @foo(i32 %x) {
+  %r = add i32 %x, 1
+  ret i32 %r
+}
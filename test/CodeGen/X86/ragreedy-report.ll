@@ -0,0 +1,47 @@
+; RUN: llc < %s -mtriple=i686-unknown-unknown -regalloc-greedy-report \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=i686-unknown-unknown -regalloc-greedy-report \
+; RUN:   -regalloc-greedy-report-threshold=1000000 -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=THRESHOLD --allow-empty
+
+; Check the per-function report of the greedy register allocator.
+
+; CHECK: greedy: no_pressure: {{[0-9]+}} virtregs, {{[0-9]+\.[0-9]+}} ms, 0 evictions (max depth 0), 0 global splits, 0 block splits, 0 instr splits, 0 local splits, 0 spills
+; CHECK: greedy: pressure: {{[0-9]+}} virtregs, {{[0-9]+\.[0-9]+}} ms, {{[0-9]+}} evictions (max depth {{[0-9]+}}), {{[0-9]+}} global splits, {{[0-9]+}} block splits, {{[0-9]+}} instr splits, {{[0-9]+}} local splits, {{[1-9][0-9]*}} spills
+
+; THRESHOLD-NOT: greedy:
+
+define i32 @no_pressure(i32 %a, i32 %b) {
+entry:
+  %add = add i32 %a, %b
+  ret i32 %add
+}
+
+; Keep more values live across the call than there are callee-saved registers.
+define i32 @pressure(i32* %p) {
+entry:
+  %p1 = getelementptr i32, i32* %p, i32 1
+  %p2 = getelementptr i32, i32* %p, i32 2
+  %p3 = getelementptr i32, i32* %p, i32 3
+  %p4 = getelementptr i32, i32* %p, i32 4
+  %p5 = getelementptr i32, i32* %p, i32 5
+  %p6 = getelementptr i32, i32* %p, i32 6
+  %v0 = load volatile i32, i32* %p
+  %v1 = load volatile i32, i32* %p1
+  %v2 = load volatile i32, i32* %p2
+  %v3 = load volatile i32, i32* %p3
+  %v4 = load volatile i32, i32* %p4
+  %v5 = load volatile i32, i32* %p5
+  %v6 = load volatile i32, i32* %p6
+  call void @f()
+  store volatile i32 %v0, i32* %p6
+  store volatile i32 %v1, i32* %p5
+  store volatile i32 %v2, i32* %p4
+  store volatile i32 %v3, i32* %p3
+  store volatile i32 %v4, i32* %p2
+  store volatile i32 %v5, i32* %p1
+  store volatile i32 %v6, i32* %p
+  ret i32 %v0
+}
+
+declare void @f()
@@ -0,0 +1,76 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-aa-sched-mi \
+; RUN:   -sched-max-tracked-mem-ops=3 -debug-only=misched -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=MEMOPS
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -misched-max-region-instrs=3 \
+; RUN:   -debug-only=misched -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=MISCHED
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -post-RA-scheduler \
+; RUN:   -postra-sched-max-region-instrs=2 -debug-only=post-RA-sched \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=POSTRA
+
+; Check the options bounding the cost of scheduling huge regions.
+
+; In @f the third store from the bottom becomes a barrier for the two stores
+; below it, and the third of the loads above it becomes the next one.
+; MEMOPS: SU(7) becomes a barrier
+; MEMOPS: SU(4) becomes a barrier
+; MEMOPS: SU(4): {{.*}} MOV64rm {{.*}} mem:LD8[%a2]
+; MEMOPS: Successors:
+; MEMOPS-NEXT: val SU(8)
+; MEMOPS-NEXT: ch SU(7)
+; MEMOPS-NEXT: ch SU(6)
+; MEMOPS-NEXT: ch SU(5)
+; MEMOPS: SU(7):{{.*}}MOV64mr{{.*}}mem:ST8[%b1]
+; MEMOPS: Successors:
+; MEMOPS-NEXT: ch SU(9)
+; MEMOPS-NEXT: ch SU(8)
+; The stores of @g have no identified underlying object and go through the
+; alias chain, which counts towards the limit as well.
+; MEMOPS-LABEL: g:BB#0
+; MEMOPS: SU(3) becomes a barrier
+
+; The ten instructions of @f are split into regions of at most three.
+; MISCHED-LABEL: f:BB#0
+; MISCHED: RegionInstrs: 3 Remaining: 7
+; MISCHED: RegionInstrs: 3 Remaining: 3
+; MISCHED: RegionInstrs: 2 Remaining: 0
+
+; The post-RA regions hold at most two instructions.
+; POSTRA: SU(0):{{.*}}MOV64mr{{.*}}mem:ST8[%b2]
+; POSTRA: SU(1):{{.*}}MOV64mr{{.*}}mem:ST8[%b3]
+; POSTRA: List Scheduling
+; POSTRA-NEXT: SU(0):{{.*}}MOV64rm{{.*}}mem:LD8[%a3]
+; POSTRA: SU(1):{{.*}}MOV64mr{{.*}}mem:ST8[%b]
+; POSTRA-NOT: SU(2)
+
+define void @f(i64* noalias %a, i64* noalias %b) {
+entry:
+  %a1 = getelementptr i64, i64* %a, i64 1
+  %a2 = getelementptr i64, i64* %a, i64 2
+  %a3 = getelementptr i64, i64* %a, i64 3
+  %b1 = getelementptr i64, i64* %b, i64 1
+  %b2 = getelementptr i64, i64* %b, i64 2
+  %b3 = getelementptr i64, i64* %b, i64 3
+  %x0 = load i64, i64* %a
+  %x1 = load i64, i64* %a1
+  %x2 = load i64, i64* %a2
+  %x3 = load i64, i64* %a3
+  store i64 %x0, i64* %b
+  store i64 %x1, i64* %b1
+  store i64 %x2, i64* %b2
+  store i64 %x3, i64* %b3
+  ret void
+}
+
+define void @g(i64* %b, i64 %x) {
+entry:
+  %b1 = getelementptr i64, i64* %b, i64 1
+  %b2 = getelementptr i64, i64* %b, i64 2
+  %b3 = getelementptr i64, i64* %b, i64 3
+  store i64 %x, i64* %b
+  store i64 %x, i64* %b1
+  store i64 %x, i64* %b2
+  store i64 %x, i64* %b3
+  ret void
+}
@@ -0,0 +1,18 @@
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @lib_used() {
+  %r = call i32 @shared()
+  ret i32 %r
+}
+
+define i32 @lib_unused() {
+  ret i32 7
+}
+
+define linkonce_odr i32 @shared() unnamed_addr {
+  ret i32 1
+}
+
+define linkonce_odr i32 @lib_linkonce_unused() unnamed_addr {
+  ret i32 3
+}
@@ -0,0 +1,48 @@
+; Inputs are loaded lazily from their files: function bodies are only read
+; when the linker pulls them in. Check that the symbols and the linked module
+; are the same as with eagerly loaded inputs.
+; RUN: llvm-as %s -o %t1.bc
+; RUN: llvm-as %p/Inputs/lazy-load.ll -o %t2.bc
+; RUN: llvm-lto -exported-symbol=main -exported-symbol=lib_unused \
+; RUN:     -save-merged-module -O0 -o %t3 %t1.bc %t2.bc
+; RUN: llvm-dis < %t3.merged.bc | FileCheck %s
+; RUN: llvm-nm %t3 | FileCheck %s --check-prefix=NM
+
+; CHECK:      define i32 @main() {
+; CHECK-NEXT:   %a = call i32 @lib_used()
+; CHECK-NEXT:   %b = call i32 @shared()
+
+; The only copy of @shared comes from the first module.
+; CHECK:      define internal i32 @shared() unnamed_addr {
+; CHECK-NEXT:   ret i32 1
+; CHECK-NOT:  @shared()
+
+; CHECK:      define internal i32 @lib_used() {
+; CHECK-NEXT:   %r = call i32 @shared()
+; CHECK-NEXT:   ret i32 %r
+; CHECK:      define i32 @lib_unused() {
+; CHECK-NEXT:   ret i32 7
+
+; Unused linkonce_odr functions are not linked in.
+; CHECK-NOT:  @lib_linkonce_unused
+
+; NM-NOT: lib_linkonce_unused
+; NM: T lib_unused
+; NM: t lib_used
+; NM: T main
+; NM: t shared
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @main() {
+  %a = call i32 @lib_used()
+  %b = call i32 @shared()
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+declare i32 @lib_used()
+
+define linkonce_odr i32 @shared() unnamed_addr {
+  ret i32 1
+}
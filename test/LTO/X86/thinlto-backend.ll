@@ -0,0 +1,29 @@
+; Test the parallel ThinLTO backends driven by llvm-lto.
+; RUN: llvm-as -function-summary %s -o %t.o
+; RUN: llvm-as -function-summary %p/Inputs/thinlto-backend.ll -o %t2.o
+; RUN: llvm-lto -thinlto-backend -j2 -o %t3 %t.o %t2.o
+; RUN: llvm-nm %t3.0 | FileCheck %s --check-prefix=CHECK0
+; RUN: llvm-nm %t3.1 | FileCheck %s --check-prefix=CHECK1
+; RUN: not test -e %t3
+
+; RUN: not llvm-lto -thinlto-backend %t.o 2>&1 | FileCheck %s --check-prefix=NOOUT
+; NOOUT: llvm-lto: -thinlto-backend requires -o
+
+target triple = "x86_64-unknown-linux-gnu"
+
+; The callee is imported from the second module and inlined, but only ever
+; defined in the second object.
+; CHECK0-NOT: T callee
+; CHECK0: T caller
+; CHECK0-NOT: T callee
+define i32 @caller() {
+entry:
+  %r = call i32 @callee()
+  ret i32 %r
+}
+
+declare i32 @callee()
+
+; CHECK1-NOT: caller
+; CHECK1: T callee
+; CHECK1-NOT: caller
@@ -0,0 +1,37 @@
+; Test the on-disk cache of the ThinLTO backends.
+; RUN: llvm-as -function-summary %s -o %t.o
+; RUN: llvm-as -function-summary %p/Inputs/thinlto-backend.ll -o %t2.o
+; RUN: llvm-as -function-summary %p/Inputs/thinlto-cache.ll -o %t6.o
+; RUN: rm -rf %t.cache
+; RUN: llvm-lto -thinlto-backend -thinlto-cache-dir %t.cache -o %t3 %t.o %t2.o
+; Each object has an entry keyed by the whole link and one keyed by the
+; module and its imports.
+; RUN: ls %t.cache | grep llvmcache- | count 4
+
+; A second link is served from the cache and produces the same objects.
+; RUN: llvm-lto -thinlto-backend -thinlto-cache-dir %t.cache -o %t4 %t.o %t2.o
+; RUN: ls %t.cache | grep llvmcache- | count 4
+; RUN: cmp %t3.0 %t4.0
+; RUN: cmp %t3.1 %t4.1
+
+; Adding a module changes the combined index, but the objects of the modules
+; that don't import from it are still reused: only the new module is compiled.
+; RUN: llvm-lto -thinlto-backend -thinlto-cache-dir %t.cache -o %t5 %t.o %t2.o \
+; RUN:     %t6.o
+; RUN: ls %t.cache | grep llvmcache- | count 8
+; RUN: cmp %t3.0 %t5.0
+; RUN: cmp %t3.1 %t5.1
+
+; Different codegen options use different entries.
+; RUN: llvm-lto -thinlto-backend -thinlto-cache-dir %t.cache -O1 -o %t7 %t.o %t2.o
+; RUN: ls %t.cache | grep llvmcache- | count 12
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @caller() {
+entry:
+  %r = call i32 @callee()
+  ret i32 %r
+}
+
+declare i32 @callee()
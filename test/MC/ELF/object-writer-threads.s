@@ -0,0 +1,61 @@
+// Check that writing the sections with several threads gives the same object
+// file as writing them serially.
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.threads \
+// RUN:     -object-writer-threads=4
+// RUN: cmp %t %t.threads
+// RUN: llvm-readobj -s -r %t.threads | FileCheck %s
+
+// RUN: llvm-mc -filetype=obj -triple i386-pc-linux-gnu %s -o %t.32
+// RUN: llvm-mc -filetype=obj -triple i386-pc-linux-gnu %s -o %t.32.threads \
+// RUN:     -object-writer-threads=4
+// RUN: cmp %t.32 %t.32.threads
+
+// CHECK: Name: .group
+// CHECK: Name: .text.f1
+// CHECK: Name: .rela.text.f1
+// CHECK: Name: .text.f2
+// CHECK: Name: .rela.text.f2
+// CHECK: Name: .data.d1
+// CHECK: Name: .rela.data.d1
+
+// CHECK:      Relocations [
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.f1 {
+// CHECK-NEXT:     0x1 R_X86_64_PC32 ext 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:     0x8 R_X86_64_32S d1 0x0
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.f2 {
+// CHECK-NEXT:     0x1 R_X86_64_PC32 f1 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.data.d1 {
+// CHECK-NEXT:     0x0 R_X86_64_32 f1 0x0
+// CHECK-NEXT:     0x4 R_X86_64_32 f2 0x0
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+
+	.section .text.f1,"axG",@progbits,f1,comdat
+	.globl f1
+f1:
+	call ext
+	movl d1, %eax
+	.p2align 4
+	ret
+
+	.section .text.f2,"ax",@progbits
+	.globl f2
+f2:
+	call f1
+	jmp .Lend
+	.fill 200, 1, 0x90
+.Lend:
+	ret
+
+	.section .data.d1,"aw",@progbits
+	.globl d1
+d1:
+	.long f1
+	.long f2
+
+	.bss
+	.zero 16
@@ -0,0 +1,35 @@
+# REQUIRES: asserts
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu -show-relax-stats \
+# RUN:   %s -o /dev/null 2>&1 | FileCheck %s
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu -stats %s \
+# RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+# RUN: llvm-mc -filetype=asm -triple x86_64-pc-linux-gnu -show-relax-stats \
+# RUN:   %s -o /dev/null 2>&1 | count 0
+
+# Check the relaxation report of each section. Both jumps of .text are checked
+# on the first iteration and the first one is relaxed. The distance of the
+# second one does not change after that, so the later iterations skip it, as
+# they skip the jump of .text.other.
+
+# CHECK: section #0 (.text): 3 iterations, 2 checks, 2 skipped, 1 relaxed
+# CHECK-NEXT: section #1 (.text.other): 2 iterations, 1 checks, 1 skipped, 0 relaxed
+# CHECK-NOT: section
+
+# STATS: 3 assembler - Number of fragments checked for relaxation
+# STATS: 3 assembler - Number of relaxation checks skipped for an unchanged distance
+
+        .text
+        jmp     far
+        jmp     near
+near:
+        .fill   200, 1, 0x90
+far:
+        ret
+
+        .section .text.other,"ax",@progbits
+        jmp     other
+other:
+        ret
+
+        .data
+        .long   0
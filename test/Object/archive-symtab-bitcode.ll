@@ -0,0 +1,65 @@
+; RUN: llvm-as %s -o=%t1
+; RUN: sed -e 's/m:e/m:o/' %s | llvm-as -o=%t2
+; RUN: rm -f %t.a
+; RUN: llvm-ar rcs %t.a %t1
+; RUN: llvm-nm -M %t.a | FileCheck %s
+; RUN: rm -f %t.a
+; RUN: llvm-ar -threads=2 rcs %t.a %t1 %t2
+; RUN: llvm-nm -M %t.a | FileCheck %s --check-prefix=CHECK --check-prefix=MACHO
+
+; The same symbols are read from the symbol table block if there is one.
+; RUN: llvm-as -symbol-table %s -o=%t3
+; RUN: rm -f %t.a
+; RUN: llvm-ar rcs %t.a %t3
+; RUN: llvm-nm -M %t.a | FileCheck %s
+
+; The symbol table of an archive of bitcode lists the global values that the
+; module defines, mangled for its target, with the functions first.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; CHECK:      Archive map
+; CHECK-NEXT: func in
+; CHECK-NEXT: weak_func in
+; CHECK-NEXT: raw_name in
+; CHECK-NEXT: var in
+; CHECK-NEXT: common_var in
+; CHECK-NEXT: alias in
+; MACHO-NEXT: _func in
+; MACHO-NEXT: _weak_func in
+; MACHO-NEXT: raw_name in
+; MACHO-NEXT: _var in
+; MACHO-NEXT: _common_var in
+; MACHO-NEXT: _alias in
+; CHECK-NOT:  {{ in }}
+; CHECK:      .tmp{{[13]}}:
+
+define void @func() {
+  ret void
+}
+
+define weak void @weak_func() {
+  ret void
+}
+
+define internal void @internal_func() {
+  ret void
+}
+
+define available_externally void @available_externally_func() {
+  ret void
+}
+
+define void @"\01raw_name"() {
+  ret void
+}
+
+declare void @declared_func()
+
+@var = global i32 0
+@common_var = common global i32 0
+@private_var = private global i32 0
+@declared_var = external global i32
+@metadata_var = global i32 0, section "llvm.metadata"
+@alias = alias i32, i32* @var
+@llvm.used = appending global [1 x i8*] [i8* bitcast (void ()* @internal_func to i8*)], section "llvm.metadata"
@@ -0,0 +1,25 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: rm -rf %t.cache
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -u foo \
+; RUN:    --plugin-opt=cache-dir=%t.cache -m elf_x86_64 -r -o %t.o %t.bc
+; RUN: ls %t.cache | grep llvmcache- | count 1
+
+; The second link is served from the cache.
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -u foo \
+; RUN:    --plugin-opt=cache-dir=%t.cache -m elf_x86_64 -r -o %t2.o %t.bc
+; RUN: ls %t.cache | grep llvmcache- | count 1
+; RUN: llvm-nm %t2.o | FileCheck %s
+
+; Each backend partition has its own entry.
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -u foo \
+; RUN:    --plugin-opt=cache-dir=%t.cache --plugin-opt=jobs=2 \
+; RUN:    -m elf_x86_64 -r -o %t3.o %t.bc
+; RUN: ls %t.cache | grep llvmcache- | count 3
+
+; CHECK: T foo
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  ret void
+}
@@ -0,0 +1,43 @@
+; RUN: llvm-split -preserve-locals -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The largest function goes to the first partition along with its local
+; callee; the two smaller clusters are both placed in the lighter second
+; partition. Locals keep their linkage.
+
+; CHECK0-NOT: @counter = internal global
+; CHECK1: @counter = internal global i32 0
+@counter = internal global i32 0
+
+; CHECK0: define void @big(i32 %x)
+; CHECK1-NOT: define void @big
+define void @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %a
+  %d = xor i32 %c, %b
+  call void @helper(i32 %d)
+  ret void
+}
+
+; CHECK0: define internal void @helper(i32 %y)
+; CHECK1-NOT: define internal void @helper
+define internal void @helper(i32 %y) {
+  ret void
+}
+
+; CHECK0-NOT: define void @inc
+; CHECK1: define void @inc()
+define void @inc() {
+  %v = load i32, i32* @counter
+  %n = add i32 %v, 1
+  store i32 %n, i32* @counter
+  ret void
+}
+
+; CHECK0-NOT: define void @nop
+; CHECK1: define void @nop()
+define void @nop() {
+  ret void
+}
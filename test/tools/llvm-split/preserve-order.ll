@@ -0,0 +1,53 @@
+; RUN: llvm-split -preserve-order -j3 -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+; RUN: llvm-dis -o - %t2 | FileCheck --check-prefix=CHECK2 %s
+
+; The definitions are cut into three contiguous runs of similar size, so each
+; partition follows the previous one in module order. The local callee stays
+; local and goes with its caller.
+
+; CHECK0-NOT: @g = global
+; CHECK1-NOT: @g = global
+; CHECK2: @g = global i32 0
+
+; CHECK0: define void @f1(i32 %x)
+; CHECK0: define internal void @h()
+; CHECK0-NOT: define
+
+; CHECK1-NOT: define void @f1
+; CHECK1: define void @f2()
+; CHECK1: define void @f3(i32 %x)
+; CHECK1-NOT: define
+
+; CHECK2-NOT: define void @f3
+; CHECK2: define void @f4()
+; CHECK2-NOT: define
+
+define void @f1(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  call void @h()
+  ret void
+}
+
+define internal void @h() {
+  ret void
+}
+
+define void @f2() {
+  ret void
+}
+
+define void @f3(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %a
+  ret void
+}
+
+define void @f4() {
+  ret void
+}
+
+@g = global i32 0
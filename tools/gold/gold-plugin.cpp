@@ -21,6 +21,7 @@
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -33,9 +34,15 @@
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Object/FunctionIndexObjectFile.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
@@ -124,6 +131,9 @@ namespace options {
   static OutputType TheOutputType = OT_NORMAL;
   static unsigned OptLevel = 2;
   static unsigned Parallelism = 1;
+  // Split the module into contiguous partitions when Parallelism > 1, so that
+  // the code is laid out in module order once the partitions are linked.
+  static bool PreserveOrder = false;
 #ifdef NDEBUG
   static bool DisableVerify = true;
 #else
@@ -137,6 +147,11 @@ namespace options {
   // the information from intermediate files and write a combined
   // global index for the ThinLTO backends.
   static bool thinlto = false;
+  // Directory where the native objects produced by the LTO backend are
+  // cached, keyed by the hash of the linked module and the codegen options.
+  static std::string cache_dir;
+  // Maximum total size of the cache directory in bytes, zero for no limit.
+  static uint64_t cache_max_size = 0;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -168,6 +183,12 @@ namespace options {
       TheOutputType = OT_DISABLE;
     } else if (opt == "thinlto") {
       thinlto = true;
+    } else if (opt.startswith("cache-dir=")) {
+      cache_dir = opt.substr(strlen("cache-dir="));
+    } else if (opt.startswith("cache-max-size=")) {
+      if (opt.substr(strlen("cache-max-size=")).getAsInteger(10,
+                                                              cache_max_size))
+        message(LDPL_FATAL, "Invalid cache size: %s", opt_);
     } else if (opt.size() == 2 && opt[0] == 'O') {
       if (opt[1] < '0' || opt[1] > '3')
         message(LDPL_FATAL, "Optimization level must be between 0 and 3");
@@ -175,6 +196,8 @@ namespace options {
     } else if (opt.startswith("jobs=")) {
       if (StringRef(opt_ + 5).getAsInteger(10, Parallelism))
         message(LDPL_FATAL, "Invalid parallelism level: %s", opt_ + 5);
+    } else if (opt == "jobs-preserve-order") {
+      PreserveOrder = true;
     } else if (opt == "disable-verify") {
       DisableVerify = true;
     } else {
@@ -759,6 +782,109 @@ static void saveBCFile(StringRef Path, Module &M) {
   WriteBitcodeToFile(&M, OS, /* ShouldPreserveUseListOrder */ false);
 }
 
+/// Compute the key under which the objects produced for \p M are cached. The
+/// linked module is hashed before optimization, together with everything that
+/// affects the generated code.
+static std::string computeCacheKey(Module &M, StringRef Features) {
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(&M, OS, /* ShouldPreserveUseListOrder */ false);
+  }
+
+  MD5 Hasher;
+  Hasher.update(LLVM_VERSION_STRING);
+  Hasher.update(StringRef(Bitcode.data(), Bitcode.size()));
+  Hasher.update(M.getTargetTriple());
+  Hasher.update(options::mcpu);
+  Hasher.update(Features);
+  for (const char *Opt : options::extra) {
+    Hasher.update(Opt);
+    Hasher.update(StringRef("\0", 1));
+  }
+  uint32_t Opts[] = {options::OptLevel, options::Parallelism, RelocationModel,
+                     options::DisableVerify, options::PreserveOrder};
+  Hasher.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Opts),
+                                  sizeof(Opts)));
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Str;
+  MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+static std::string getCacheEntryPath(StringRef Key, unsigned Partition) {
+  SmallString<128> Path;
+  sys::path::append(Path, options::cache_dir,
+                    "llvmcache-" + Key + "-" + utostr(Partition));
+  return Path.str();
+}
+
+/// Give the link a private copy of the cache entry \p EntryPath, so that a
+/// concurrent pruning of the cache can't remove the file gold reads from.
+/// The entry is hard linked when possible, and copied otherwise.
+static bool getPrivateCopy(StringRef EntryPath, SmallVectorImpl<char> &Path) {
+  int FD;
+  if (sys::fs::createTemporaryFile("lto-llvm", "o", FD, Path))
+    return false;
+  sys::Process::SafelyCloseFileDescriptor(FD);
+  sys::fs::remove(Path);
+  if (!sys::fs::create_hard_link(EntryPath, Path) ||
+      !sys::fs::copy_file(EntryPath, Path))
+    return true;
+  sys::fs::remove(Path);
+  return false;
+}
+
+/// Add the cached objects for \p Key to the link. Returns false, without
+/// adding anything, if any of the partitions is missing from the cache.
+static bool addCachedObjects(StringRef Key) {
+  std::vector<SmallString<128>> Paths(options::Parallelism);
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    std::string EntryPath = getCacheEntryPath(Key, I);
+    if (!getPrivateCopy(EntryPath, Paths[I])) {
+      for (unsigned J = 0; J != I; ++J)
+        sys::fs::remove(Paths[J]);
+      return false;
+    }
+    CachePruning::touch(EntryPath);
+  }
+  for (SmallString<128> &Path : Paths) {
+    if (add_input_file(Path.c_str()) != LDPS_OK)
+      message(LDPL_FATAL, "Unable to add .o file to the link: %s",
+              Path.c_str());
+    Cleanup.push_back(Path.c_str());
+  }
+  return true;
+}
+
+/// Store the objects in \p Filenames in the cache under \p Key. Each entry is
+/// copied to a temporary file first and renamed into place, so that concurrent
+/// links never see a partial entry. Failures are not fatal.
+static void storeCachedObjects(StringRef Key,
+                               ArrayRef<SmallString<128>> Filenames) {
+  for (unsigned I = 0, E = Filenames.size(); I != E; ++I) {
+    std::string EntryPath = getCacheEntryPath(Key, I);
+    int FD;
+    SmallString<128> TempPath;
+    if (sys::fs::createUniqueFile(EntryPath + "-%%%%%%.tmp", FD, TempPath))
+      return;
+    sys::Process::SafelyCloseFileDescriptor(FD);
+    if (sys::fs::copy_file(Filenames[I], TempPath) ||
+        sys::fs::rename(TempPath, EntryPath)) {
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  CachePruning(options::cache_dir)
+      .setPruningInterval(1200)
+      .setEntryExpiration(7 * 24 * 3600)
+      .setMaxSize(options::cache_max_size)
+      .prune();
+}
+
 static void codegen(std::unique_ptr<Module> M) {
   const std::string &TripleStr = M->getTargetTriple();
   Triple TheTriple(TripleStr);
@@ -796,6 +922,27 @@ static void codegen(std::unique_ptr<Module> M) {
       TripleStr, options::mcpu, Features.getString(), Options, RelocationModel,
       CodeModel::Default, CGOptLevel));
 
+  // The cache is only used when the objects go to temporary files, that is
+  // when nothing but the link itself consumes them.
+  std::string CacheKey;
+  std::unique_ptr<LockFileManager> CacheLock;
+  if (!options::cache_dir.empty() && options::obj_path.empty() &&
+      options::TheOutputType == options::OT_NORMAL) {
+    sys::fs::create_directories(options::cache_dir);
+    CacheKey = computeCacheKey(*M, Features.getString());
+    if (addCachedObjects(CacheKey))
+      return;
+    // Another link may be producing the same objects: wait for it rather than
+    // duplicating the work.
+    CacheLock = llvm::make_unique<LockFileManager>(
+        getCacheEntryPath(CacheKey, 0));
+    if (CacheLock->getState() == LockFileManager::LFS_Shared) {
+      CacheLock->waitForUnlock();
+      if (addCachedObjects(CacheKey))
+        return;
+    }
+  }
+
   runLTOPasses(*M, *TM);
 
   if (options::TheOutputType == options::OT_SAVE_TEMPS)
@@ -837,9 +984,13 @@ static void codegen(std::unique_ptr<Module> M) {
 
     // Run backend threads.
     splitCodeGen(std::move(M), OSPtrs, options::mcpu, Features.getString(),
-                 Options, RelocationModel, CodeModel::Default, CGOptLevel);
+                 Options, RelocationModel, CodeModel::Default, CGOptLevel,
+                 TargetMachine::CGFT_ObjectFile, options::PreserveOrder);
   }
 
+  if (!CacheKey.empty())
+    storeCachedObjects(CacheKey, Filenames);
+
   for (auto &Filename : Filenames) {
     if (add_input_file(Filename.c_str()) != LDPS_OK)
       message(LDPL_FATAL,
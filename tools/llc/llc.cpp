@@ -15,6 +15,7 @@
 
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
@@ -32,6 +33,7 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
@@ -46,6 +48,7 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <cstdio>
 #include <memory>
 using namespace llvm;
 
@@ -103,7 +106,17 @@ static cl::opt<bool>
                           "manager and verify the result is the same."),
                  cl::init(false));
 
-static int compileModule(char **, LLVMContext &);
+static cl::opt<bool>
+Server("server",
+       cl::desc("Read compilation jobs from the standard input, one per line "
+                "as '<input> <output>', and answer each with 'ok' or 'error' "
+                "on the standard output"));
+
+typedef StringMap<std::unique_ptr<TargetMachine>> TargetMachineCache;
+
+static int compileModule(char **, LLVMContext &,
+                         TargetMachineCache *TMCache = nullptr);
+static int runServer(char **);
 
 static std::unique_ptr<tool_output_file>
 GetOutputStream(const char *TargetName, Triple::OSType OS,
@@ -205,6 +218,9 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  if (Server)
+    return runServer(argv);
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
@@ -213,7 +229,72 @@ int main(int argc, char **argv) {
   return 0;
 }
 
-static int compileModule(char **argv, LLVMContext &Context) {
+/// Read a line from the standard input into \p Line. Returns false at the end of
+/// the input.
+static bool readLine(std::string &Line) {
+  Line.clear();
+  int C;
+  while ((C = getchar()) != EOF && C != '\n')
+    Line += C;
+  return C != EOF || !Line.empty();
+}
+
+/// Answer the current job with "error" before report_fatal_error exits, so that
+/// the client is not left waiting for it.
+static void fatalJobError(void *, const std::string &Reason, bool) {
+  errs() << "LLVM ERROR: " << Reason << "\n";
+  errs().flush();
+  outs() << "error\n";
+  outs().flush();
+}
+
+/// Compile the jobs read from the standard input until it is closed. The
+/// targets and the command line are only set up once, and the target machines
+/// are reused by all the jobs for the same triple. Each job is compiled in its
+/// own LLVMContext, so that no IR outlives it.
+///
+/// A job that fails to read or verify its input only fails itself. A fatal
+/// error in the backend, however, still ends the server: LLVM cannot recover
+/// from report_fatal_error, so the current job is answered with "error" and the
+/// client has to start a new server for the remaining jobs.
+static int runServer(char **argv) {
+  install_fatal_error_handler(fatalJobError);
+  TargetMachineCache TargetMachines;
+  std::string Line;
+  while (readLine(Line)) {
+    StringRef Input, Output;
+    std::tie(Input, Output) = StringRef(Line).trim().split(' ');
+    Output = Output.trim();
+    if (Input.empty())
+      continue;
+
+    bool Failed;
+    if (Input == "-") {
+      // The standard input is used to read the jobs.
+      errs() << argv[0] << ": error: jobs must have an input file\n";
+      Failed = true;
+    } else if (Output.empty() || Output == "-") {
+      // The standard output is used to report the status of the jobs.
+      errs() << argv[0] << ": " << Input
+             << ": error: jobs must have an output file\n";
+      Failed = true;
+    } else {
+      InputFilename = Input.str();
+      OutputFilename = Output.str();
+      LLVMContext Context;
+      Failed = compileModule(argv, Context, &TargetMachines) != 0;
+    }
+
+    // Tell the client that the job is done.
+    outs() << (Failed ? "error\n" : "ok\n");
+    outs().flush();
+    errs().flush();
+  }
+  return 0;
+}
+
+static int compileModule(char **argv, LLVMContext &Context,
+                         TargetMachineCache *TMCache) {
   // Load the module to be compiled...
   SMDiagnostic Err;
   std::unique_ptr<Module> M;
@@ -286,9 +367,23 @@ static int compileModule(char **argv, LLVMContext &Context) {
   Options.MCOptions.MCUseDwarfDirectory = EnableDwarfDirectory;
   Options.MCOptions.AsmVerbose = AsmVerbose;
 
-  std::unique_ptr<TargetMachine> Target(
-      TheTarget->createTargetMachine(TheTriple.getTriple(), CPUStr, FeaturesStr,
-                                     Options, RelocModel, CMModel, OLvl));
+  std::unique_ptr<TargetMachine> OwnedTarget;
+  TargetMachine *Target;
+  if (TMCache) {
+    // Everything but the triple comes from the command line, and is the same
+    // for all the modules.
+    std::unique_ptr<TargetMachine> &Cached = (*TMCache)[TheTriple.getTriple()];
+    if (!Cached)
+      Cached.reset(TheTarget->createTargetMachine(TheTriple.getTriple(), CPUStr,
+                                                  FeaturesStr, Options,
+                                                  RelocModel, CMModel, OLvl));
+    Target = Cached.get();
+  } else {
+    OwnedTarget.reset(TheTarget->createTargetMachine(
+        TheTriple.getTriple(), CPUStr, FeaturesStr, Options, RelocModel,
+        CMModel, OLvl));
+    Target = OwnedTarget.get();
+  }
 
   assert(Target && "Could not allocate target machine!");
 
@@ -81,6 +81,12 @@ static cl::opt<Format>
                          clEnumValN(GNU, "gnu", "gnu"),
                          clEnumValN(BSD, "bsd", "bsd"), clEnumValEnd));
 
+static cl::opt<unsigned>
+    Threads("threads",
+            cl::desc("Number of threads used to read the symbols of the "
+                     "members for the symbol table"),
+            cl::init(1));
+
 static std::string Options;
 
 // Provide additional help output explaining the operations and modifiers of
@@ -600,14 +606,14 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
   }
   if (NewMembersP) {
     std::pair<StringRef, std::error_code> Result = writeArchive(
-        ArchiveName, *NewMembersP, Symtab, Kind, Deterministic, Thin);
+        ArchiveName, *NewMembersP, Symtab, Kind, Deterministic, Thin, Threads);
     failIfError(Result.second, Result.first);
     return;
   }
   std::vector<NewArchiveIterator> NewMembers =
       computeNewArchiveMembers(Operation, OldArchive);
-  auto Result =
-      writeArchive(ArchiveName, NewMembers, Symtab, Kind, Deterministic, Thin);
+  auto Result = writeArchive(ArchiveName, NewMembers, Symtab, Kind,
+                             Deterministic, Thin, Threads);
   failIfError(Result.second, Result.first);
 }
 
@@ -19,6 +19,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
+#include "llvm/LTO/ThinLTOCodeGenerator.h"
 #include "llvm/Object/FunctionIndexObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
@@ -64,6 +65,21 @@ static cl::opt<bool>
     ThinLTO("thinlto", cl::init(false),
             cl::desc("Only write combined global index for ThinLTO backends"));
 
+static cl::opt<bool> ThinLTOBackend(
+    "thinlto-backend", cl::init(false),
+    cl::desc("Import, optimize and codegen each input module separately, "
+             "in parallel on -j threads, writing one object per input"));
+
+static cl::opt<std::string> ThinLTOCacheDir(
+    "thinlto-cache-dir",
+    cl::desc("Cache the objects produced by -thinlto-backend in this directory"),
+    cl::value_desc("directory"));
+
+static cl::opt<unsigned long long> ThinLTOCacheMaxSize(
+    "thinlto-cache-max-size", cl::init(0),
+    cl::desc("Prune the ThinLTO cache down to this size in bytes (0 for no "
+             "limit)"));
+
 static cl::opt<bool>
 SaveModuleFile("save-merged-module", cl::init(false),
                cl::desc("Write merged LTO module to file before CodeGen"));
@@ -234,6 +250,57 @@ static void createCombinedFunctionIndex() {
   OS.close();
 }
 
+/// Run the ThinLTO backends over the input IR files and write one output file
+/// per input, named after the output file with the input index appended.
+static int runThinLTOBackends(const char *ProgName,
+                              const TargetOptions &Options) {
+  if (OutputFilename.empty())
+    error("-thinlto-backend requires -o");
+
+  ThinLTOCodeGenerator ThinGenerator;
+  std::vector<std::unique_ptr<MemoryBuffer>> InputBuffers;
+  for (auto &Filename : InputFilenames) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(Filename);
+    error(BufferOrErr, "error loading file '" + Filename + "'");
+    InputBuffers.push_back(std::move(*BufferOrErr));
+    ThinGenerator.addModule(Filename, InputBuffers.back()->getBuffer());
+  }
+
+  ThinGenerator.setTargetOptions(Options);
+  ThinGenerator.setCodePICModel(RelocModel);
+  ThinGenerator.setCpu(MCPU);
+  std::string Attrs;
+  for (unsigned i = 0; i < MAttrs.size(); ++i) {
+    if (i > 0)
+      Attrs.append(",");
+    Attrs.append(MAttrs[i]);
+  }
+  ThinGenerator.setAttr(Attrs);
+  ThinGenerator.setOptLevel(OptLevel - '0');
+  ThinGenerator.setParallelism(Parallelism);
+  if (FileType.getNumOccurrences())
+    ThinGenerator.setFileType(FileType);
+  ThinGenerator.setCacheDir(ThinLTOCacheDir);
+  ThinGenerator.setCacheMaxSize(ThinLTOCacheMaxSize);
+
+  if (!ThinGenerator.run()) {
+    errs() << ProgName << ": error running the ThinLTO backends\n";
+    return 1;
+  }
+
+  auto &Binaries = ThinGenerator.getProducedBinaries();
+  for (unsigned I = 0, E = Binaries.size(); I != E; ++I) {
+    std::string PartFilename = OutputFilename + "." + utostr(I);
+    std::error_code EC;
+    tool_output_file OS(PartFilename, EC, sys::fs::F_None);
+    error(EC, "error opening the file '" + PartFilename + "'");
+    OS.os() << Binaries[I]->getBuffer();
+    OS.keep();
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -264,6 +331,9 @@ int main(int argc, char **argv) {
     return 0;
   }
 
+  if (ThinLTOBackend)
+    return runThinLTOBackends(argv[0], Options);
+
   unsigned BaseArg = 0;
 
   LLVMContext Context;
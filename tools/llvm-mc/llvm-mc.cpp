@@ -15,10 +15,12 @@
 #include "Disassembler.h"
 #include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCInstPrinter.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCObjectStreamer.h"
 #include "llvm/MC/MCParser/AsmLexer.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSectionMachO.h"
@@ -56,6 +58,11 @@ static cl::opt<bool>
 CompressDebugSections("compress-debug-sections",
                       cl::desc("Compress DWARF debug sections"));
 
+static cl::opt<unsigned>
+ObjectWriterThreads("object-writer-threads",
+                    cl::desc("Number of threads used to write the object file"),
+                    cl::init(1));
+
 static cl::opt<bool>
 ShowInst("show-inst", cl::desc("Show internal instruction representation"));
 
@@ -168,6 +175,11 @@ static cl::opt<bool> SaveTempLabels("save-temp-labels",
 static cl::opt<bool> NoExecStack("no-exec-stack",
                                  cl::desc("File doesn't need an exec stack"));
 
+static cl::opt<bool>
+ShowRelaxStats("show-relax-stats",
+               cl::desc("Report the relaxation work of each section to "
+                        "stderr (object files only)"));
+
 enum ActionType {
   AC_AsLex,
   AC_Assemble,
@@ -427,6 +439,7 @@ int main(int argc, char **argv) {
     }
     MAI->setCompressDebugSections(true);
   }
+  MAI->setObjectWriterThreads(ObjectWriterThreads);
 
   // FIXME: This is not pretty. MCContext has a ptr to MCObjectFileInfo and
   // MCObjectFileInfo needs a MCContext reference in order to initialize itself.
@@ -517,6 +530,9 @@ int main(int argc, char **argv) {
         /*DWARFMustBeAtTheEnd*/ false));
     if (NoExecStack)
       Str->InitSections(true);
+    if (ShowRelaxStats)
+      static_cast<MCObjectStreamer &>(*Str).getAssembler().setRelaxationReport(
+          &errs());
   }
 
   int Res = 1;
@@ -38,8 +38,10 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cerrno>
 #include <cstring>
@@ -158,18 +160,32 @@ cl::opt<bool> FormatMachOasHex("x", cl::desc("Print symbol entry in hex, "
 cl::opt<bool> NoLLVMBitcode("no-llvm-bc",
                             cl::desc("Disable LLVM bitcode reader"));
 
+cl::opt<unsigned> NumThreads("threads",
+                             cl::desc("Number of threads used to dump the "
+                                      "input files and archive members"),
+                             cl::init(1));
+
 bool PrintAddress = true;
 
 bool MultipleFiles = false;
 
-bool HadError = false;
+std::atomic<bool> HadError(false);
 
 std::string ToolName;
 } // anonymous namespace
 
+// With -threads every job prints into its own buffers, which are written out
+// in input order once the job has finished. These point at the buffers of the
+// job running on the current thread and are null otherwise.
+static LLVM_THREAD_LOCAL raw_ostream *JobOuts;
+static LLVM_THREAD_LOCAL raw_ostream *JobErrs;
+
+static raw_ostream &nmOuts() { return JobOuts ? *JobOuts : outs(); }
+static raw_ostream &nmErrs() { return JobErrs ? *JobErrs : errs(); }
+
 static void error(Twine Message, Twine Path = Twine()) {
   HadError = true;
-  errs() << ToolName << ": " << Path << ": " << Message << ".\n";
+  nmErrs() << ToolName << ": " << Path << ": " << Message << ".\n";
 }
 
 static bool error(std::error_code EC, Twine Path = Twine()) {
@@ -223,9 +239,7 @@ static char isSymbolList64Bit(SymbolicFile &Obj) {
   return cast<ELFObjectFileBase>(Obj).getBytesInAddress() == 8;
 }
 
-static StringRef CurrentFilename;
 typedef std::vector<NMSymbol> SymbolListT;
-static SymbolListT SymbolList;
 
 static char getSymbolNMTypeChar(IRObjectFile &Obj, basic_symbol_iterator I);
 
@@ -302,16 +316,16 @@ static void darwinPrintSymbol(SymbolicFile &Obj, SymbolListT::iterator I,
   if (FormatMachOasHex) {
     char Str[18] = "";
     format(printFormat, NValue).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    nmOuts() << Str << ' ';
     format("%02x", NType).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    nmOuts() << Str << ' ';
     format("%02x", NSect).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    nmOuts() << Str << ' ';
     format("%04x", NDesc).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    nmOuts() << Str << ' ';
     format("%08x", NStrx).print(Str, sizeof(Str));
-    outs() << Str << ' ';
-    outs() << I->Name << "\n";
+    nmOuts() << Str << ' ';
+    nmOuts() << I->Name << "\n";
     return;
   }
 
@@ -320,51 +334,52 @@ static void darwinPrintSymbol(SymbolicFile &Obj, SymbolListT::iterator I,
       strcpy(SymbolAddrStr, printBlanks);
     if (Obj.isIR() && (NType & MachO::N_TYPE) == MachO::N_TYPE)
       strcpy(SymbolAddrStr, printDashes);
-    outs() << SymbolAddrStr << ' ';
+    nmOuts() << SymbolAddrStr << ' ';
   }
 
   switch (NType & MachO::N_TYPE) {
   case MachO::N_UNDF:
     if (NValue != 0) {
-      outs() << "(common) ";
+      nmOuts() << "(common) ";
       if (MachO::GET_COMM_ALIGN(NDesc) != 0)
-        outs() << "(alignment 2^" << (int)MachO::GET_COMM_ALIGN(NDesc) << ") ";
+        nmOuts() << "(alignment 2^" << (int)MachO::GET_COMM_ALIGN(NDesc)
+                 << ") ";
     } else {
       if ((NType & MachO::N_TYPE) == MachO::N_PBUD)
-        outs() << "(prebound ";
+        nmOuts() << "(prebound ";
       else
-        outs() << "(";
+        nmOuts() << "(";
       if ((NDesc & MachO::REFERENCE_TYPE) ==
           MachO::REFERENCE_FLAG_UNDEFINED_LAZY)
-        outs() << "undefined [lazy bound]) ";
+        nmOuts() << "undefined [lazy bound]) ";
       else if ((NDesc & MachO::REFERENCE_TYPE) ==
                MachO::REFERENCE_FLAG_UNDEFINED_LAZY)
-        outs() << "undefined [private lazy bound]) ";
+        nmOuts() << "undefined [private lazy bound]) ";
       else if ((NDesc & MachO::REFERENCE_TYPE) ==
                MachO::REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY)
-        outs() << "undefined [private]) ";
+        nmOuts() << "undefined [private]) ";
       else
-        outs() << "undefined) ";
+        nmOuts() << "undefined) ";
     }
     break;
   case MachO::N_ABS:
-    outs() << "(absolute) ";
+    nmOuts() << "(absolute) ";
     break;
   case MachO::N_INDR:
-    outs() << "(indirect) ";
+    nmOuts() << "(indirect) ";
     break;
   case MachO::N_SECT: {
     if (Obj.isIR()) {
       // For llvm bitcode files print out a fake section name using the values
       // use 1, 2 and 3 for section numbers as set above.
       if (NSect == 1)
-        outs() << "(LTO,CODE) ";
+        nmOuts() << "(LTO,CODE) ";
       else if (NSect == 2)
-        outs() << "(LTO,DATA) ";
+        nmOuts() << "(LTO,DATA) ";
       else if (NSect == 3)
-        outs() << "(LTO,RODATA) ";
+        nmOuts() << "(LTO,RODATA) ";
       else
-        outs() << "(?,?) ";
+        nmOuts() << "(?,?) ";
       break;
     }
     section_iterator Sec = *MachO->getSymbolSection(I->Sym.getRawDataRefImpl());
@@ -372,67 +387,67 @@ static void darwinPrintSymbol(SymbolicFile &Obj, SymbolListT::iterator I,
     StringRef SectionName;
     MachO->getSectionName(Ref, SectionName);
     StringRef SegmentName = MachO->getSectionFinalSegmentName(Ref);
-    outs() << "(" << SegmentName << "," << SectionName << ") ";
+    nmOuts() << "(" << SegmentName << "," << SectionName << ") ";
     break;
   }
   default:
-    outs() << "(?) ";
+    nmOuts() << "(?) ";
     break;
   }
 
   if (NType & MachO::N_EXT) {
     if (NDesc & MachO::REFERENCED_DYNAMICALLY)
-      outs() << "[referenced dynamically] ";
+      nmOuts() << "[referenced dynamically] ";
     if (NType & MachO::N_PEXT) {
       if ((NDesc & MachO::N_WEAK_DEF) == MachO::N_WEAK_DEF)
-        outs() << "weak private external ";
+        nmOuts() << "weak private external ";
       else
-        outs() << "private external ";
+        nmOuts() << "private external ";
     } else {
       if ((NDesc & MachO::N_WEAK_REF) == MachO::N_WEAK_REF ||
           (NDesc & MachO::N_WEAK_DEF) == MachO::N_WEAK_DEF) {
         if ((NDesc & (MachO::N_WEAK_REF | MachO::N_WEAK_DEF)) ==
             (MachO::N_WEAK_REF | MachO::N_WEAK_DEF))
-          outs() << "weak external automatically hidden ";
+          nmOuts() << "weak external automatically hidden ";
         else
-          outs() << "weak external ";
+          nmOuts() << "weak external ";
       } else
-        outs() << "external ";
+        nmOuts() << "external ";
     }
   } else {
     if (NType & MachO::N_PEXT)
-      outs() << "non-external (was a private external) ";
+      nmOuts() << "non-external (was a private external) ";
     else
-      outs() << "non-external ";
+      nmOuts() << "non-external ";
   }
 
   if (Filetype == MachO::MH_OBJECT &&
       (NDesc & MachO::N_NO_DEAD_STRIP) == MachO::N_NO_DEAD_STRIP)
-    outs() << "[no dead strip] ";
+    nmOuts() << "[no dead strip] ";
 
   if (Filetype == MachO::MH_OBJECT &&
       ((NType & MachO::N_TYPE) != MachO::N_UNDF) &&
       (NDesc & MachO::N_SYMBOL_RESOLVER) == MachO::N_SYMBOL_RESOLVER)
-    outs() << "[symbol resolver] ";
+    nmOuts() << "[symbol resolver] ";
 
   if (Filetype == MachO::MH_OBJECT &&
       ((NType & MachO::N_TYPE) != MachO::N_UNDF) &&
       (NDesc & MachO::N_ALT_ENTRY) == MachO::N_ALT_ENTRY)
-    outs() << "[alt entry] ";
+    nmOuts() << "[alt entry] ";
 
   if ((NDesc & MachO::N_ARM_THUMB_DEF) == MachO::N_ARM_THUMB_DEF)
-    outs() << "[Thumb] ";
+    nmOuts() << "[Thumb] ";
 
   if ((NType & MachO::N_TYPE) == MachO::N_INDR) {
-    outs() << I->Name << " (for ";
+    nmOuts() << I->Name << " (for ";
     StringRef IndirectName;
     if (!MachO ||
         MachO->getIndirectName(I->Sym.getRawDataRefImpl(), IndirectName))
-      outs() << "?)";
+      nmOuts() << "?)";
     else
-      outs() << IndirectName << ")";
+      nmOuts() << IndirectName << ")";
   } else
-    outs() << I->Name;
+    nmOuts() << I->Name;
 
   if ((Flags & MachO::MH_TWOLEVEL) == MachO::MH_TWOLEVEL &&
       (((NType & MachO::N_TYPE) == MachO::N_UNDF && NValue == 0) ||
@@ -440,21 +455,21 @@ static void darwinPrintSymbol(SymbolicFile &Obj, SymbolListT::iterator I,
     uint32_t LibraryOrdinal = MachO::GET_LIBRARY_ORDINAL(NDesc);
     if (LibraryOrdinal != 0) {
       if (LibraryOrdinal == MachO::EXECUTABLE_ORDINAL)
-        outs() << " (from executable)";
+        nmOuts() << " (from executable)";
       else if (LibraryOrdinal == MachO::DYNAMIC_LOOKUP_ORDINAL)
-        outs() << " (dynamically looked up)";
+        nmOuts() << " (dynamically looked up)";
       else {
         StringRef LibraryName;
         if (!MachO ||
             MachO->getLibraryShortNameByIndex(LibraryOrdinal - 1, LibraryName))
-          outs() << " (from bad library ordinal " << LibraryOrdinal << ")";
+          nmOuts() << " (from bad library ordinal " << LibraryOrdinal << ")";
         else
-          outs() << " (from " << LibraryName << ")";
+          nmOuts() << " (from " << LibraryName << ")";
       }
     }
   }
 
-  outs() << "\n";
+  nmOuts() << "\n";
 }
 
 // Table that maps Darwin's Mach-O stab constants to strings to allow printing.
@@ -527,19 +542,20 @@ static void darwinPrintStab(MachOObjectFile *MachO, SymbolListT::iterator I) {
 
   char Str[18] = "";
   format("%02x", NSect).print(Str, sizeof(Str));
-  outs() << ' ' << Str << ' ';
+  nmOuts() << ' ' << Str << ' ';
   format("%04x", NDesc).print(Str, sizeof(Str));
-  outs() << Str << ' ';
+  nmOuts() << Str << ' ';
   if (const char *stabString = getDarwinStabString(NType))
     format("%5.5s", stabString).print(Str, sizeof(Str));
   else
     format("   %02x", NType).print(Str, sizeof(Str));
-  outs() << Str;
+  nmOuts() << Str;
 }
 
-static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
-                                   std::string ArchiveName,
+static void sortAndPrintSymbolList(SymbolicFile &Obj, SymbolListT &SymbolList,
+                                   bool printName, std::string ArchiveName,
                                    std::string ArchitectureName) {
+  StringRef CurrentFilename = Obj.getFileName();
   if (!NoSort) {
     std::function<bool(const NMSymbol &, const NMSymbol &)> Cmp;
     if (NumericSort)
@@ -556,13 +572,13 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
 
   if (!PrintFileName) {
     if (OutputFormat == posix && MultipleFiles && printName) {
-      outs() << '\n' << CurrentFilename << ":\n";
+      nmOuts() << '\n' << CurrentFilename << ":\n";
     } else if (OutputFormat == bsd && MultipleFiles && printName) {
-      outs() << "\n" << CurrentFilename << ":\n";
+      nmOuts() << "\n" << CurrentFilename << ":\n";
     } else if (OutputFormat == sysv) {
-      outs() << "\n\nSymbols from " << CurrentFilename << ":\n\n"
-             << "Name                  Value   Class        Type"
-             << "         Size   Line  Section\n";
+      nmOuts() << "\n\nSymbols from " << CurrentFilename << ":\n\n"
+               << "Name                  Value   Class        Type"
+               << "         Size   Line  Section\n";
     }
   }
 
@@ -592,14 +608,14 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
       continue;
     if (PrintFileName) {
       if (!ArchitectureName.empty())
-        outs() << "(for architecture " << ArchitectureName << "):";
+        nmOuts() << "(for architecture " << ArchitectureName << "):";
       if (!ArchiveName.empty())
-        outs() << ArchiveName << ":";
-      outs() << CurrentFilename << ": ";
+        nmOuts() << ArchiveName << ":";
+      nmOuts() << CurrentFilename << ": ";
     }
     if ((JustSymbolName || (UndefinedOnly && isa<MachOObjectFile>(Obj) &&
                             OutputFormat != darwin)) && OutputFormat != posix) {
-      outs() << I->Name << "\n";
+      nmOuts() << I->Name << "\n";
       continue;
     }
 
@@ -630,49 +646,64 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
       darwinPrintSymbol(Obj, I, SymbolAddrStr, printBlanks, printDashes,
                         printFormat);
     } else if (OutputFormat == posix) {
-      outs() << I->Name << " " << I->TypeChar << " ";
+      nmOuts() << I->Name << " " << I->TypeChar << " ";
       if (MachO)
-        outs() << I->Address << " " << "0" /* SymbolSizeStr */ << "\n";
+        nmOuts() << I->Address << " " << "0" /* SymbolSizeStr */ << "\n";
       else
-        outs() << SymbolAddrStr << SymbolSizeStr << "\n";
+        nmOuts() << SymbolAddrStr << SymbolSizeStr << "\n";
     } else if (OutputFormat == bsd || (OutputFormat == darwin && !MachO)) {
       if (PrintAddress)
-        outs() << SymbolAddrStr << ' ';
+        nmOuts() << SymbolAddrStr << ' ';
       if (PrintSize) {
-        outs() << SymbolSizeStr;
-        outs() << ' ';
+        nmOuts() << SymbolSizeStr;
+        nmOuts() << ' ';
       }
-      outs() << I->TypeChar;
+      nmOuts() << I->TypeChar;
       if (I->TypeChar == '-' && MachO)
         darwinPrintStab(MachO, I);
-      outs() << " " << I->Name << "\n";
+      nmOuts() << " " << I->Name << "\n";
     } else if (OutputFormat == sysv) {
       std::string PaddedName(I->Name);
       while (PaddedName.length() < 20)
         PaddedName += " ";
-      outs() << PaddedName << "|" << SymbolAddrStr << "|   " << I->TypeChar
-             << "  |                  |" << SymbolSizeStr << "|     |\n";
+      nmOuts() << PaddedName << "|" << SymbolAddrStr << "|   " << I->TypeChar
+               << "  |                  |" << SymbolSizeStr << "|     |\n";
     }
   }
-
-  SymbolList.clear();
 }
 
-static char getSymbolNMTypeChar(ELFObjectFileBase &Obj,
+/// The type of an ELF symbol, read from the symbol and section headers in
+/// place.
+template <class ELFT>
+static char getSymbolNMTypeChar(const ELFObjectFile<ELFT> &Obj,
                                 basic_symbol_iterator I) {
-  // OK, this is ELF
-  elf_symbol_iterator SymI(I);
-
-  ErrorOr<elf_section_iterator> SecIOrErr = SymI->getSection();
-  if (error(SecIOrErr.getError()))
-    return '?';
+  typedef typename ELFObjectFile<ELFT>::Elf_Sym Elf_Sym;
+  typedef typename ELFObjectFile<ELFT>::Elf_Shdr Elf_Shdr;
+  const Elf_Sym *Sym = Obj.getSymbol(I->getRawDataRefImpl());
+
+  const Elf_Shdr *Sec = nullptr;
+  if (Sym->st_shndx == ELF::SHN_XINDEX) {
+    // The index is in the extended section index table.
+    ErrorOr<elf_section_iterator> SecIOrErr =
+        elf_symbol_iterator(I)->getSection();
+    if (error(SecIOrErr.getError()))
+      return '?';
+    if (*SecIOrErr != Obj.section_end())
+      Sec = Obj.getSection((*SecIOrErr)->getRawDataRefImpl());
+  } else if (Sym->st_shndx != ELF::SHN_UNDEF &&
+             Sym->st_shndx < ELF::SHN_LORESERVE) {
+    ErrorOr<const Elf_Shdr *> SecOrErr =
+        Obj.getELFFile()->getSection(Sym->st_shndx);
+    if (error(SecOrErr.getError()))
+      return '?';
+    Sec = *SecOrErr;
+  }
 
-  elf_section_iterator SecI = *SecIOrErr;
-  if (SecI != Obj.section_end()) {
-    switch (SecI->getType()) {
+  if (Sec) {
+    switch (Sec->sh_type) {
     case ELF::SHT_PROGBITS:
     case ELF::SHT_DYNAMIC:
-      switch (SecI->getFlags()) {
+      switch (Sec->sh_flags) {
       case (ELF::SHF_ALLOC | ELF::SHF_EXECINSTR):
         return 't';
       case (ELF::SHF_TLS | ELF::SHF_ALLOC | ELF::SHF_WRITE):
@@ -689,8 +720,8 @@ static char getSymbolNMTypeChar(ELFObjectFileBase &Obj,
     }
   }
 
-  if (SymI->getELFType() == ELF::STT_SECTION) {
-    ErrorOr<StringRef> Name = SymI->getName();
+  if (Sym->getType() == ELF::STT_SECTION) {
+    ErrorOr<StringRef> Name = Obj.getSymbolName(*Sym, DynamicSyms);
     if (error(Name.getError()))
       return '?';
     return StringSwitch<char>(*Name)
@@ -702,6 +733,17 @@ static char getSymbolNMTypeChar(ELFObjectFileBase &Obj,
   return 'n';
 }
 
+static char getSymbolNMTypeChar(ELFObjectFileBase &Obj,
+                                basic_symbol_iterator I) {
+  if (auto *ELFObj = dyn_cast<ELF32LEObjectFile>(&Obj))
+    return getSymbolNMTypeChar(*ELFObj, I);
+  if (auto *ELFObj = dyn_cast<ELF64LEObjectFile>(&Obj))
+    return getSymbolNMTypeChar(*ELFObj, I);
+  if (auto *ELFObj = dyn_cast<ELF32BEObjectFile>(&Obj))
+    return getSymbolNMTypeChar(*ELFObj, I);
+  return getSymbolNMTypeChar(cast<ELF64BEObjectFile>(Obj), I);
+}
+
 static char getSymbolNMTypeChar(COFFObjectFile &Obj, symbol_iterator I) {
   COFFSymbolRef Symb = Obj.getCOFFSymbol(*I);
   // OK, this is COFF.
@@ -908,6 +950,7 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
     Symbols =
         make_range<basic_symbol_iterator>(DynSymbols.begin(), DynSymbols.end());
   }
+  SymbolListT SymbolList;
   std::string NameBuffer;
   raw_string_ostream OS(NameBuffer);
   // If a "-s segname sectname" option was specified and this is a Mach-O
@@ -965,8 +1008,8 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
     P += strlen(P) + 1;
   }
 
-  CurrentFilename = Obj.getFileName();
-  sortAndPrintSymbolList(Obj, printName, ArchiveName, ArchitectureName);
+  sortAndPrintSymbolList(Obj, SymbolList, printName, ArchiveName,
+                         ArchitectureName);
 }
 
 // checkMachOAndArchFlags() checks to see if the SymbolicFile is a Mach-O file
@@ -974,7 +1017,8 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
 // check to make sure this Mach-O file is one of those architectures or all
 // architectures was specificed.  If not then an error is generated and this
 // routine returns false.  Else it returns true.
-static bool checkMachOAndArchFlags(SymbolicFile *O, std::string &Filename) {
+static bool checkMachOAndArchFlags(SymbolicFile *O,
+                                   const std::string &Filename) {
   MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(O);
 
   if (!MachO || ArchAll || ArchFlags.size() == 0)
@@ -999,63 +1043,149 @@ static bool checkMachOAndArchFlags(SymbolicFile *O, std::string &Filename) {
   return true;
 }
 
-static void dumpSymbolNamesFromFile(std::string &Filename) {
-  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFileOrSTDIN(Filename);
-  if (error(BufferOrErr.getError(), Filename))
-    return;
+namespace {
+/// Runs the work for the input files. With -threads=1 every job runs as soon
+/// as it is added and prints straight to stdout and stderr. Otherwise jobs are
+/// queued, run on a thread pool a window at a time, and their buffered output
+/// is written out in the order the jobs were added.
+class DumpQueue {
+  struct Job {
+    std::function<bool()> Run;
+    unsigned Group;
+    bool Result;
+    std::string Out;
+    std::string Err;
+  };
+
+  std::unique_ptr<ThreadPool> Pool;
+  std::vector<Job> Jobs;
+  unsigned StoppedGroup = 0;
+
+  static void run(Job &J) {
+    raw_string_ostream Out(J.Out), Err(J.Err);
+    JobOuts = &Out;
+    JobErrs = &Err;
+    J.Result = J.Run();
+    JobOuts = JobErrs = nullptr;
+  }
 
-  LLVMContext &Context = getGlobalContext();
-  ErrorOr<std::unique_ptr<Binary>> BinaryOrErr = createBinary(
-      BufferOrErr.get()->getMemBufferRef(), NoLLVMBitcode ? nullptr : &Context);
-  if (error(BinaryOrErr.getError(), Filename))
-    return;
-  Binary &Bin = *BinaryOrErr.get();
+public:
+  DumpQueue() {
+    if (NumThreads > 1)
+      Pool.reset(new ThreadPool(NumThreads));
+  }
 
-  if (Archive *A = dyn_cast<Archive>(&Bin)) {
-    if (ArchiveMap) {
-      Archive::symbol_iterator I = A->symbol_begin();
-      Archive::symbol_iterator E = A->symbol_end();
-      if (I != E) {
-        outs() << "Archive map\n";
-        for (; I != E; ++I) {
-          ErrorOr<Archive::Child> C = I->getMember();
-          if (error(C.getError()))
-            return;
-          ErrorOr<StringRef> FileNameOrErr = C->getName();
-          if (error(FileNameOrErr.getError()))
-            return;
-          StringRef SymName = I->getName();
-          outs() << SymName << " in " << FileNameOrErr.get() << "\n";
-        }
-        outs() << "\n";
-      }
+  ~DumpQueue() { flush(); }
+
+  /// Adds a job for the input file numbered \p Group, counting from 1. A job
+  /// returns false to drop the jobs after it in the same group.
+  void add(unsigned Group, std::function<bool()> Run) {
+    if (!Pool) {
+      if (Group != StoppedGroup && !Run())
+        StoppedGroup = Group;
+      return;
     }
+    Jobs.push_back({std::move(Run), Group, true, std::string(), std::string()});
+    if (Jobs.size() >= NumThreads * 16)
+      flush();
+  }
 
-    for (Archive::child_iterator I = A->child_begin(), E = A->child_end();
-         I != E; ++I) {
-      if (error(I->getError()))
-        return;
-      auto &C = I->get();
-      ErrorOr<std::unique_ptr<Binary>> ChildOrErr = C.getAsBinary(&Context);
-      if (ChildOrErr.getError())
+  void flush() {
+    if (Jobs.empty())
+      return;
+    parallelForBatches(*Pool, Jobs.size(), NumThreads * 4,
+                       [this](size_t, size_t Begin, size_t End) {
+                         for (size_t I = Begin; I != End; ++I)
+                           run(Jobs[I]);
+                       });
+    for (Job &J : Jobs) {
+      if (J.Group == StoppedGroup)
         continue;
-      if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
-        if (!checkMachOAndArchFlags(O, Filename))
-          return;
-        if (!PrintFileName) {
-          outs() << "\n";
-          if (isa<MachOObjectFile>(O)) {
-            outs() << Filename << "(" << O->getFileName() << ")";
-          } else
-            outs() << O->getFileName();
-          outs() << ":\n";
-        }
-        dumpSymbolNamesFromObject(*O, false, Filename);
+      outs() << J.Out;
+      if (!J.Err.empty()) {
+        outs().flush();
+        errs() << J.Err;
       }
+      if (!J.Result)
+        StoppedGroup = J.Group;
     }
-    return;
+    Jobs.clear();
+  }
+};
+} // anonymous namespace
+
+// Every job creates its own LLVMContext, and only once it runs into bitcode,
+// on its own or embedded in an object file, so that dumping native objects
+// never sets one up.
+static LLVMContext *getContextFor(MemoryBufferRef Buffer,
+                                  std::unique_ptr<LLVMContext> &Context) {
+  if (!IRObjectFile::findBitcodeInMemBuffer(Buffer))
+    return nullptr;
+  if (!Context)
+    Context.reset(new LLVMContext);
+  return Context.get();
+}
+
+static ErrorOr<std::unique_ptr<Binary>>
+getChildAsBinary(const Archive::Child &C,
+                 std::unique_ptr<LLVMContext> &Context) {
+  ErrorOr<MemoryBufferRef> BufferOrErr = C.getMemoryBufferRef();
+  if (std::error_code EC = BufferOrErr.getError())
+    return EC;
+  return C.getAsBinary(getContextFor(*BufferOrErr, Context));
+}
+
+static bool dumpArchiveMap(Archive &A) {
+  Archive::symbol_iterator I = A.symbol_begin();
+  Archive::symbol_iterator E = A.symbol_end();
+  if (I == E)
+    return true;
+  nmOuts() << "Archive map\n";
+  for (; I != E; ++I) {
+    ErrorOr<Archive::Child> C = I->getMember();
+    if (error(C.getError()))
+      return false;
+    ErrorOr<StringRef> FileNameOrErr = C->getName();
+    if (error(FileNameOrErr.getError()))
+      return false;
+    StringRef SymName = I->getName();
+    nmOuts() << SymName << " in " << FileNameOrErr.get() << "\n";
   }
+  nmOuts() << "\n";
+  return true;
+}
+
+static bool dumpSymbolNamesFromArchiveMember(const Archive::Child &C,
+                                             const std::string &Filename) {
+  std::unique_ptr<LLVMContext> Context;
+  ErrorOr<std::unique_ptr<Binary>> ChildOrErr = getChildAsBinary(C, Context);
+  if (ChildOrErr.getError())
+    return true;
+  if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
+    if (!checkMachOAndArchFlags(O, Filename))
+      return false;
+    if (!PrintFileName) {
+      nmOuts() << "\n";
+      if (isa<MachOObjectFile>(O)) {
+        nmOuts() << Filename << "(" << O->getFileName() << ")";
+      } else
+        nmOuts() << O->getFileName();
+      nmOuts() << ":\n";
+    }
+    dumpSymbolNamesFromObject(*O, false, Filename);
+  }
+  return true;
+}
+
+static void dumpSymbolNamesFromBinary(MemoryBufferRef Buffer,
+                                      const std::string &Filename) {
+  std::unique_ptr<LLVMContext> Context;
+  ErrorOr<std::unique_ptr<Binary>> BinaryOrErr = createBinary(
+      Buffer, NoLLVMBitcode ? nullptr : getContextFor(Buffer, Context));
+  if (error(BinaryOrErr.getError(), Filename))
+    return;
+  Binary &Bin = *BinaryOrErr.get();
+
   if (MachOUniversalBinary *UB = dyn_cast<MachOUniversalBinary>(&Bin)) {
     // If we have a list of architecture flags specified dump only those.
     if (!ArchAll && ArchFlags.size() != 0) {
@@ -1080,9 +1210,9 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                 if (PrintFileName)
                   ArchitectureName = I->getArchTypeName();
                 else
-                  outs() << "\n" << Obj.getFileName() << " (for architecture "
-                         << I->getArchTypeName() << ")"
-                         << ":\n";
+                  nmOuts() << "\n" << Obj.getFileName() << " (for architecture "
+                           << I->getArchTypeName() << ")"
+                           << ":\n";
               }
               dumpSymbolNamesFromObject(Obj, false, ArchiveName,
                                         ArchitectureName);
@@ -1096,7 +1226,7 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                   return;
                 auto &C = AI->get();
                 ErrorOr<std::unique_ptr<Binary>> ChildOrErr =
-                    C.getAsBinary(&Context);
+                    getChildAsBinary(C, Context);
                 if (ChildOrErr.getError())
                   continue;
                 if (SymbolicFile *O =
@@ -1106,13 +1236,13 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                     if (ArchFlags.size() > 1)
                       ArchitectureName = I->getArchTypeName();
                   } else {
-                    outs() << "\n" << A->getFileName();
-                    outs() << "(" << O->getFileName() << ")";
+                    nmOuts() << "\n" << A->getFileName();
+                    nmOuts() << "(" << O->getFileName() << ")";
                     if (ArchFlags.size() > 1) {
-                      outs() << " (for architecture " << I->getArchTypeName()
-                             << ")";
+                      nmOuts() << " (for architecture " << I->getArchTypeName()
+                               << ")";
                     }
-                    outs() << ":\n";
+                    nmOuts() << ":\n";
                   }
                   dumpSymbolNamesFromObject(*O, false, ArchiveName,
                                             ArchitectureName);
@@ -1153,7 +1283,7 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                 return;
               auto &C = AI->get();
               ErrorOr<std::unique_ptr<Binary>> ChildOrErr =
-                  C.getAsBinary(&Context);
+                  getChildAsBinary(C, Context);
               if (ChildOrErr.getError())
                 continue;
               if (SymbolicFile *O =
@@ -1161,9 +1291,9 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                 if (PrintFileName)
                   ArchiveName = A->getFileName();
                 else
-                  outs() << "\n" << A->getFileName() << "(" << O->getFileName()
-                         << ")"
-                         << ":\n";
+                  nmOuts() << "\n" << A->getFileName() << "("
+                           << O->getFileName() << ")"
+                           << ":\n";
                 dumpSymbolNamesFromObject(*O, false, ArchiveName);
               }
             }
@@ -1190,11 +1320,11 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
             ArchitectureName = I->getArchTypeName();
         } else {
           if (moreThanOneArch)
-            outs() << "\n";
-          outs() << Obj.getFileName();
+            nmOuts() << "\n";
+          nmOuts() << Obj.getFileName();
           if (isa<MachOObjectFile>(Obj) && moreThanOneArch)
-            outs() << " (for architecture " << I->getArchTypeName() << ")";
-          outs() << ":\n";
+            nmOuts() << " (for architecture " << I->getArchTypeName() << ")";
+          nmOuts() << ":\n";
         }
         dumpSymbolNamesFromObject(Obj, false, ArchiveName, ArchitectureName);
       } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr = I->getAsArchive()) {
@@ -1204,7 +1334,8 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
           if (error(AI->getError()))
             return;
           auto &C = AI->get();
-          ErrorOr<std::unique_ptr<Binary>> ChildOrErr = C.getAsBinary(&Context);
+          ErrorOr<std::unique_ptr<Binary>> ChildOrErr =
+              getChildAsBinary(C, Context);
           if (ChildOrErr.getError())
             continue;
           if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
@@ -1213,15 +1344,15 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
               if (isa<MachOObjectFile>(O) && moreThanOneArch)
                 ArchitectureName = I->getArchTypeName();
             } else {
-              outs() << "\n" << A->getFileName();
+              nmOuts() << "\n" << A->getFileName();
               if (isa<MachOObjectFile>(O)) {
-                outs() << "(" << O->getFileName() << ")";
+                nmOuts() << "(" << O->getFileName() << ")";
                 if (moreThanOneArch)
-                  outs() << " (for architecture " << I->getArchTypeName()
-                         << ")";
+                  nmOuts() << " (for architecture " << I->getArchTypeName()
+                           << ")";
               } else
-                outs() << ":" << O->getFileName();
-              outs() << ":\n";
+                nmOuts() << ":" << O->getFileName();
+              nmOuts() << ":\n";
             }
             dumpSymbolNamesFromObject(*O, false, ArchiveName, ArchitectureName);
           }
@@ -1239,6 +1370,52 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
   error("unrecognizable file type", Filename);
 }
 
+// Archives are split into one job per member here; every other kind of input
+// file is dumped by a single job.
+static void dumpSymbolNamesFromFile(std::string Filename, unsigned Group,
+                                    DumpQueue &Queue) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFileOrSTDIN(Filename);
+  if (std::error_code EC = BufferOrErr.getError()) {
+    Queue.add(Group, [=] { return !error(EC, Filename); });
+    return;
+  }
+  std::shared_ptr<MemoryBuffer> Buffer = std::move(*BufferOrErr);
+
+  if (sys::fs::identify_magic(Buffer->getBuffer()) !=
+      sys::fs::file_magic::archive) {
+    Queue.add(Group, [=] {
+      dumpSymbolNamesFromBinary(Buffer->getMemBufferRef(), Filename);
+      return true;
+    });
+    return;
+  }
+
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(Buffer->getMemBufferRef());
+  if (std::error_code EC = ArchiveOrErr.getError()) {
+    Queue.add(Group, [=] { return !error(EC, Filename); });
+    return;
+  }
+  std::shared_ptr<Archive> A = std::move(*ArchiveOrErr);
+
+  // The archive refers to the buffer and the members to the archive, so every
+  // job holds on to both.
+  if (ArchiveMap)
+    Queue.add(Group, [A, Buffer] { return dumpArchiveMap(*A); });
+  for (Archive::child_iterator I = A->child_begin(), E = A->child_end();
+       I != E; ++I) {
+    if (std::error_code EC = I->getError()) {
+      Queue.add(Group, [=] { return !error(EC); });
+      return;
+    }
+    Archive::Child C = I->get();
+    Queue.add(Group, [C, A, Buffer, Filename] {
+      return dumpSymbolNamesFromArchiveMember(C, Filename);
+    });
+  }
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -1294,8 +1471,11 @@ int main(int argc, char **argv) {
     error("bad number of arguments (must be two arguments)",
           "for the -s option");
 
-  std::for_each(InputFilenames.begin(), InputFilenames.end(),
-                dumpSymbolNamesFromFile);
+  {
+    DumpQueue Queue;
+    for (unsigned I = 0, E = InputFilenames.size(); I != E; ++I)
+      dumpSymbolNamesFromFile(InputFilenames[I], I + 1, Queue);
+  }
 
   if (HadError)
     return 1;
@@ -53,6 +53,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cctype>
@@ -181,6 +182,11 @@ cl::opt<bool>
 cl::opt<bool> PrintFaultMaps("fault-map-section",
                              cl::desc("Display contents of faultmap section"));
 
+static cl::opt<unsigned> DisassembleThreads(
+    "disassemble-threads", cl::init(1),
+    cl::desc("Number of threads used to disassemble the symbols of a "
+             "section"));
+
 static StringRef ToolName;
 
 namespace {
@@ -308,12 +314,12 @@ public:
                          ArrayRef<uint8_t> Bytes, uint64_t Address,
                          raw_ostream &OS, StringRef Annot,
                          MCSubtargetInfo const &STI) {
-    outs() << format("%8" PRIx64 ":", Address);
+    OS << format("%8" PRIx64 ":", Address);
     if (!NoShowRawInsn) {
-      outs() << "\t";
-      dumpBytes(Bytes, outs());
+      OS << "\t";
+      dumpBytes(Bytes, OS);
     }
-    IP.printInst(MI, outs(), "", STI);
+    IP.printInst(MI, OS, "", STI);
   }
 };
 PrettyPrinter PrettyPrinterInst;
@@ -824,6 +830,27 @@ static bool getHidden(RelocationRef RelRef) {
   return false;
 }
 
+namespace {
+/// The objects that decode and print instructions. They keep state, so each
+/// task of a parallel disassembly has its own.
+struct DisassemblerInstance {
+  std::unique_ptr<MCContext> Ctx;
+  std::unique_ptr<MCDisassembler> DisAsm;
+  std::unique_ptr<const MCInstrAnalysis> MIA;
+  std::unique_ptr<MCInstPrinter> IP;
+};
+
+/// The output of disassembling a symbol, before its relocations are merged
+/// in. They are printed in order after all the symbols before it.
+struct DisassembledSymbol {
+  std::string Text;
+  std::string Warnings;
+  /// For each instruction, the end of its text and the end of its bytes.
+  /// The relocations before the latter are printed after the former.
+  std::vector<std::pair<size_t, uint64_t>> Insts;
+};
+}
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   const Target *TheTarget = getTarget(Obj);
 
@@ -854,25 +881,40 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   if (!MII)
     report_fatal_error("error: no instruction info for target " + TripleName);
   std::unique_ptr<const MCObjectFileInfo> MOFI(new MCObjectFileInfo);
-  MCContext Ctx(AsmInfo.get(), MRI.get(), MOFI.get());
-
-  std::unique_ptr<MCDisassembler> DisAsm(
-    TheTarget->createMCDisassembler(*STI, Ctx));
-  if (!DisAsm)
-    report_fatal_error("error: no disassembler for target " + TripleName);
-
-  std::unique_ptr<const MCInstrAnalysis> MIA(
-      TheTarget->createMCInstrAnalysis(MII.get()));
-
-  int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
-  std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
-      Triple(TripleName), AsmPrinterVariant, *AsmInfo, *MII, *MRI));
-  if (!IP)
-    report_fatal_error("error: no instruction printer for target " +
-                       TripleName);
-  IP->setPrintImmHex(PrintImmHex);
+
+  auto CreateInstance = [&](DisassemblerInstance &DI) {
+    DI.Ctx.reset(new MCContext(AsmInfo.get(), MRI.get(), MOFI.get()));
+
+    DI.DisAsm.reset(TheTarget->createMCDisassembler(*STI, *DI.Ctx));
+    if (!DI.DisAsm)
+      report_fatal_error("error: no disassembler for target " + TripleName);
+
+    DI.MIA.reset(TheTarget->createMCInstrAnalysis(MII.get()));
+
+    int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
+    DI.IP.reset(TheTarget->createMCInstPrinter(
+        Triple(TripleName), AsmPrinterVariant, *AsmInfo, *MII, *MRI));
+    if (!DI.IP)
+      report_fatal_error("error: no instruction printer for target " +
+                         TripleName);
+    DI.IP->setPrintImmHex(PrintImmHex);
+  };
+  DisassemblerInstance MainInstance;
+  CreateInstance(MainInstance);
   PrettyPrinter &PIP = selectPrettyPrinter(Triple(TripleName));
 
+  // With several threads, the symbols of a section are disassembled in
+  // windows, each split in batches that run on their own instance.
+  unsigned NumThreads = std::max(1u, unsigned(DisassembleThreads));
+  unsigned NumBatches = NumThreads * 4;
+  size_t WindowSize = NumBatches * 16;
+  std::unique_ptr<ThreadPool> Pool;
+  std::vector<DisassemblerInstance> Instances;
+  if (NumThreads > 1) {
+    Pool = llvm::make_unique<ThreadPool>(NumThreads);
+    Instances.resize(NumBatches);
+  }
+
   StringRef Fmt = Obj->getBytesInAddress() > 4 ? "\t\t%016" PRIx64 ":  " :
                                                  "\t\t\t%08" PRIx64 ":  ";
 
@@ -1003,43 +1045,42 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     if (Symbols.empty() || Symbols[0].first != 0)
       Symbols.insert(Symbols.begin(), std::make_pair(SectionAddr, name));
 
-    SmallString<40> Comments;
-    raw_svector_ostream CommentStream(Comments);
-
     StringRef BytesStr;
     error(Section.getContents(BytesStr));
     ArrayRef<uint8_t> Bytes(reinterpret_cast<const uint8_t *>(BytesStr.data()),
                             BytesStr.size());
 
-    uint64_t Size;
-    uint64_t Index;
-
-    std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
-    std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
-    // Disassemble symbol by symbol.
-    for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
+#ifndef NDEBUG
+    raw_ostream &DebugOut = DebugFlag && NumThreads == 1 ? dbgs() : nulls();
+#else
+    raw_ostream &DebugOut = nulls();
+#endif
 
+    // Disassemble the symbol Symbols[si] with the instance DI. This only
+    // reads the state shared with the other threads.
+    auto DisassembleSymbol = [&](DisassemblerInstance &DI, unsigned si,
+                                 DisassembledSymbol &Out) {
       uint64_t Start = Symbols[si].first - SectionAddr;
       // The end is either the section end or the beginning of the next
       // symbol.
-      uint64_t End =
-          (si == se - 1) ? SectSize : Symbols[si + 1].first - SectionAddr;
+      uint64_t End = (si == Symbols.size() - 1)
+                         ? SectSize
+                         : Symbols[si + 1].first - SectionAddr;
       // Don't try to disassemble beyond the end of section contents.
       if (End > SectSize)
         End = SectSize;
       // If this symbol has the same address as the next symbol, then skip it.
       if (Start >= End)
-        continue;
+        return;
 
-      outs() << '\n' << Symbols[si].second << ":\n";
+      raw_string_ostream OS(Out.Text);
+      SmallString<40> Comments;
+      raw_svector_ostream CommentStream(Comments);
 
-#ifndef NDEBUG
-      raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
-#else
-      raw_ostream &DebugOut = nulls();
-#endif
+      OS << '\n' << Symbols[si].second << ":\n";
 
-      for (Index = Start; Index < End; Index += Size) {
+      uint64_t Size;
+      for (uint64_t Index = Start; Index < End; Index += Size) {
         MCInst Inst;
 
         // AArch64 ELF binaries can interleave data and text in the
@@ -1053,23 +1094,23 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
           if (DAI != DataMappingSymsAddr.end() && *DAI == Index) {
             // Switch to data.
             while (Index < End) {
-              outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-              outs() << "\t";
+              OS << format("%8" PRIx64 ":", SectionAddr + Index);
+              OS << "\t";
               if (Index + 4 <= End) {
                 Stride = 4;
-                dumpBytes(Bytes.slice(Index, 4), outs());
-                outs() << "\t.word";
+                dumpBytes(Bytes.slice(Index, 4), OS);
+                OS << "\t.word";
               } else if (Index + 2 <= End) {
                 Stride = 2;
-                dumpBytes(Bytes.slice(Index, 2), outs());
-                outs() << "\t.short";
+                dumpBytes(Bytes.slice(Index, 2), OS);
+                OS << "\t.short";
               } else {
                 Stride = 1;
-                dumpBytes(Bytes.slice(Index, 1), outs());
-                outs() << "\t.byte";
+                dumpBytes(Bytes.slice(Index, 1), OS);
+                OS << "\t.byte";
               }
               Index += Stride;
-              outs() << "\n";
+              OS << "\n";
               auto TAI = std::lower_bound(TextMappingSymsAddr.begin(),
                                           TextMappingSymsAddr.end(), Index);
               if (TAI != TextMappingSymsAddr.end() && *TAI == Index)
@@ -1081,21 +1122,23 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         if (Index >= End)
           break;
 
-        if (DisAsm->getInstruction(Inst, Size, Bytes.slice(Index),
-                                   SectionAddr + Index, DebugOut,
-                                   CommentStream)) {
-          PIP.printInst(*IP, &Inst,
+        if (DI.DisAsm->getInstruction(Inst, Size, Bytes.slice(Index),
+                                      SectionAddr + Index, DebugOut,
+                                      CommentStream)) {
+          PIP.printInst(*DI.IP, &Inst,
                         Bytes.slice(Index, Size),
-                        SectionAddr + Index, outs(), "", *STI);
-          outs() << CommentStream.str();
+                        SectionAddr + Index, OS, "", *STI);
+          OS << CommentStream.str();
           Comments.clear();
 
           // Try to resolve the target of a call, tail call, etc. to a specific
           // symbol.
-          if (MIA && (MIA->isCall(Inst) || MIA->isUnconditionalBranch(Inst) ||
-                      MIA->isConditionalBranch(Inst))) {
+          if (DI.MIA && (DI.MIA->isCall(Inst) ||
+                         DI.MIA->isUnconditionalBranch(Inst) ||
+                         DI.MIA->isConditionalBranch(Inst))) {
             uint64_t Target;
-            if (MIA->evaluateBranch(Inst, SectionAddr + Index, Size, Target)) {
+            if (DI.MIA->evaluateBranch(Inst, SectionAddr + Index, Size,
+                                       Target)) {
               // In a relocatable object, the target's section must reside in
               // the same section as the call instruction or it is accessed
               // through a relocation.
@@ -1103,7 +1146,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
               // In a non-relocatable object, the target may be in any section.
               //
               // N.B. We don't walk the relocations in the relocatable case yet.
-              auto *TargetSectionSymbols = &Symbols;
+              const SectionSymbolsTy *TargetSectionSymbols = &Symbols;
               if (!Obj->isRelocatableObject()) {
                 auto SectionAddress = std::upper_bound(
                     SectionAddresses.begin(), SectionAddresses.end(), Target,
@@ -1111,11 +1154,12 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
                        const std::pair<uint64_t, SectionRef> &RHS) {
                       return LHS < RHS.first;
                     });
+                TargetSectionSymbols = nullptr;
                 if (SectionAddress != SectionAddresses.begin()) {
                   --SectionAddress;
-                  TargetSectionSymbols = &AllSymbols[SectionAddress->second];
-                } else {
-                  TargetSectionSymbols = nullptr;
+                  auto SecSyms = AllSymbols.find(SectionAddress->second);
+                  if (SecSyms != AllSymbols.end())
+                    TargetSectionSymbols = &SecSyms->second;
                 }
               }
 
@@ -1132,22 +1176,38 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
                   --TargetSym;
                   uint64_t TargetAddress = std::get<0>(*TargetSym);
                   StringRef TargetName = std::get<1>(*TargetSym);
-                  outs() << " <" << TargetName;
+                  OS << " <" << TargetName;
                   uint64_t Disp = Target - TargetAddress;
                   if (Disp)
-                    outs() << '+' << utohexstr(Disp);
-                  outs() << '>';
+                    OS << '+' << utohexstr(Disp);
+                  OS << '>';
                 }
               }
             }
           }
-          outs() << "\n";
+          OS << "\n";
         } else {
-          errs() << ToolName << ": warning: invalid instruction encoding\n";
+          Out.Warnings +=
+              (ToolName + ": warning: invalid instruction encoding\n").str();
           if (Size == 0)
             Size = 1; // skip illegible bytes
         }
 
+        Out.Insts.push_back(std::make_pair(OS.str().size(), Index + Size));
+      }
+      OS.flush();
+    };
+
+    std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
+    std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
+    auto PrintSymbol = [&](const DisassembledSymbol &Sym) {
+      errs() << Sym.Warnings;
+      StringRef Text = Sym.Text;
+      size_t TextStart = 0;
+      for (const std::pair<size_t, uint64_t> &Inst : Sym.Insts) {
+        outs() << Text.slice(TextStart, Inst.first);
+        TextStart = Inst.first;
+
         // Print relocation for instruction.
         while (rel_cur != rel_end) {
           bool hidden = getHidden(*rel_cur);
@@ -1159,7 +1219,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
           if (hidden) goto skip_print_rel;
 
           // Stop when rel_cur's address is past the current instruction.
-          if (addr >= Index + Size) break;
+          if (addr >= Inst.second) break;
           rel_cur->getTypeName(name);
           error(getRelocationValueString(*rel_cur, val));
           outs() << format(Fmt.data(), SectionAddr + addr) << name
@@ -1169,6 +1229,33 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
           ++rel_cur;
         }
       }
+      outs() << Text.substr(TextStart);
+    };
+
+    // Disassemble symbol by symbol.
+    if (NumThreads == 1) {
+      for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
+        DisassembledSymbol Sym;
+        DisassembleSymbol(MainInstance, si, Sym);
+        PrintSymbol(Sym);
+      }
+      continue;
+    }
+
+    for (size_t WindowBegin = 0; WindowBegin < Symbols.size();
+         WindowBegin += WindowSize) {
+      size_t N = std::min(WindowSize, Symbols.size() - WindowBegin);
+      std::vector<DisassembledSymbol> Window(N);
+      parallelForBatches(*Pool, N, NumBatches,
+                         [&](size_t Batch, size_t Begin, size_t End) {
+                           DisassemblerInstance &DI = Instances[Batch];
+                           if (!DI.DisAsm)
+                             CreateInstance(DI);
+                           for (size_t I = Begin; I != End; ++I)
+                             DisassembleSymbol(DI, WindowBegin + I, Window[I]);
+                         });
+      for (const DisassembledSymbol &Sym : Window)
+        PrintSymbol(Sym);
     }
   }
 }
@@ -13,6 +13,7 @@
 
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -28,6 +29,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <tuple>
@@ -96,7 +98,7 @@ static void handleMergeWriterError(std::error_code &Error,
 }
 
 struct WeightedFile {
-  StringRef Filename;
+  std::string Filename;
   uint64_t Weight;
 
   WeightedFile() {}
@@ -105,9 +107,70 @@ struct WeightedFile {
 };
 typedef SmallVector<WeightedFile, 5> WeightedFileVector;
 
+namespace {
+/// A diagnostic produced while merging, kept around so that it can be printed
+/// once all the merge jobs are done.
+struct MergeWarning {
+  std::error_code EC;
+  std::string File;
+  std::string Function;
+};
+
+/// The state of one merge job: a writer that accumulates the records of a
+/// contiguous slice of the inputs, along with the diagnostics produced while
+/// reading them.
+struct WriterContext {
+  InstrProfWriter Writer;
+  std::vector<MergeWarning> Warnings;
+  /// Set if an input could not be read. The job stops at that input.
+  std::error_code ReadError;
+  std::string ReadErrorFile;
+  /// The first input of the job that has a record for each function, to
+  /// blame for the warnings produced when the writers are combined. Only
+  /// filled in if there are several jobs.
+  StringMap<StringRef> FirstInput;
+  bool TrackFirstInput = false;
+};
+}
+
+/// Read \p Input and merge its records into the writer of \p WC.
+static void loadInput(const WeightedFile &Input, WriterContext &WC) {
+  auto ReaderOrErr = InstrProfReader::create(Input.Filename);
+  if (std::error_code EC = ReaderOrErr.getError()) {
+    WC.ReadError = EC;
+    WC.ReadErrorFile = Input.Filename;
+    return;
+  }
+
+  auto Reader = std::move(ReaderOrErr.get());
+  for (auto &I : *Reader) {
+    StringRef Name = I.Name;
+    if (WC.TrackFirstInput)
+      WC.FirstInput.insert(std::make_pair(Name, StringRef(Input.Filename)));
+    if (std::error_code EC = WC.Writer.addRecord(std::move(I), Input.Weight))
+      WC.Warnings.push_back({EC, Input.Filename, Name});
+  }
+  if (Reader->hasError()) {
+    WC.ReadError = Reader->getError();
+    WC.ReadErrorFile = Input.Filename;
+  }
+}
+
+/// Print the warnings collected in \p Warnings.
+static void reportWarnings(ArrayRef<MergeWarning> Warnings,
+                           SmallSet<std::error_code, 4> &WriterErrorCodes) {
+  for (const MergeWarning &W : Warnings) {
+    std::error_code EC = W.EC;
+    // Only show hint the first time an error occurs.
+    bool firstTime = WriterErrorCodes.insert(EC).second;
+    handleMergeWriterError(EC, W.File, W.Function, firstTime);
+  }
+}
+
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
                               StringRef OutputFilename,
-                              ProfileFormat OutputFormat) {
+                              ProfileFormat OutputFormat,
+                              unsigned NumThreads) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -119,24 +182,74 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   if (EC)
     exitWithErrorCode(EC, OutputFilename);
 
-  InstrProfWriter Writer;
+  // Split the inputs into contiguous slices, one per job. Each job merges its
+  // slice into a private writer, and the writers are then combined pairwise.
+  // The slicing and the combining order only depend on the number of jobs, so
+  // the output and the diagnostics do not depend on thread scheduling. Each
+  // reader is released as soon as its records have been merged, so at most
+  // one input per job is held in memory on top of the job's writer.
+  unsigned NumJobs = std::max(1u, std::min<unsigned>(NumThreads,
+                                                     Inputs.size()));
+  if (NumJobs > 1)
+    errs() << "warning: merging with " << NumJobs << " threads keeps up to "
+           << NumJobs << " merged profiles in memory\n";
+  std::vector<std::unique_ptr<WriterContext>> Contexts;
+  for (unsigned J = 0; J < NumJobs; ++J) {
+    Contexts.emplace_back(new WriterContext());
+    Contexts.back()->TrackFirstInput = NumJobs > 1;
+  }
+
+  auto RunJob = [&](unsigned J) {
+    size_t Begin = Inputs.size() * J / NumJobs;
+    size_t End = Inputs.size() * (J + 1) / NumJobs;
+    WriterContext &WC = *Contexts[J];
+    for (size_t I = Begin; I != End && !WC.ReadError; ++I)
+      loadInput(Inputs[I], WC);
+  };
+
+  std::unique_ptr<ThreadPool> Pool;
+  if (NumJobs == 1) {
+    RunJob(0);
+  } else {
+    Pool.reset(new ThreadPool(NumJobs));
+    for (unsigned J = 0; J < NumJobs; ++J)
+      Pool->async(RunJob, J);
+    Pool->wait();
+  }
+
+  // Report the diagnostics in input order. The first input that could not be
+  // read is fatal, exactly as if the inputs had been merged one at a time.
   SmallSet<std::error_code, 4> WriterErrorCodes;
-  for (const auto &Input : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Input.Filename);
-    if (std::error_code ec = ReaderOrErr.getError())
-      exitWithErrorCode(ec, Input.Filename);
-
-    auto Reader = std::move(ReaderOrErr.get());
-    for (auto &I : *Reader) {
-      if (std::error_code EC = Writer.addRecord(std::move(I), Input.Weight)) {
-        // Only show hint the first time an error occurs.
-        bool firstTime = WriterErrorCodes.insert(EC).second;
-        handleMergeWriterError(EC, Input.Filename, I.Name, firstTime);
-      }
-    }
-    if (Reader->hasError())
-      exitWithErrorCode(Reader->getError(), Input.Filename);
+  for (const auto &WC : Contexts) {
+    reportWarnings(WC->Warnings, WriterErrorCodes);
+    if (WC->ReadError)
+      exitWithErrorCode(WC->ReadError, WC->ReadErrorFile);
+  }
+
+  // Combine the writers in a binary tree, freeing each source writer as soon
+  // as its records have been moved out. A conflict is blamed on the first
+  // input of the source writer that has the function, which is where merging
+  // the inputs one at a time would have run into it.
+  for (size_t Stride = 1; Stride < Contexts.size(); Stride *= 2) {
+    auto Combine = [&](size_t Dst) {
+      WriterContext &To = *Contexts[Dst];
+      std::unique_ptr<WriterContext> From = std::move(Contexts[Dst + Stride]);
+      To.Warnings.clear();
+      To.Writer.mergeRecordsFromWriter(
+          std::move(From->Writer), [&](std::error_code EC, StringRef Name) {
+            To.Warnings.push_back({EC, From->FirstInput.lookup(Name), Name});
+          });
+      for (const auto &I : From->FirstInput)
+        To.FirstInput.insert(std::make_pair(I.getKey(), I.getValue()));
+    };
+    for (size_t Dst = 0; Dst + Stride < Contexts.size(); Dst += 2 * Stride)
+      Pool->async(Combine, Dst);
+    Pool->wait();
+    for (size_t Dst = 0; Dst + Stride < Contexts.size(); Dst += 2 * Stride)
+      reportWarnings(Contexts[Dst]->Warnings, WriterErrorCodes);
   }
+
+  InstrProfWriter &Writer = Contexts.front()->Writer;
   if (OutputFormat == PF_Text)
     Writer.writeText(Output);
   else
@@ -205,6 +318,32 @@ static WeightedFile parseWeightedFile(const StringRef &WeightedFilename) {
   return WeightedFile(FileName, Weight);
 }
 
+/// Add the inputs listed in \p InputFilenamesFile to \p WFV. Each non-empty
+/// line names one input, either as <filename> or as <weight>,<filename>.
+/// Lines starting with '#' are ignored.
+static void addWeightedInputsFromFile(StringRef InputFilenamesFile,
+                                      WeightedFileVector &WFV) {
+  auto BufOrErr = MemoryBuffer::getFileOrSTDIN(InputFilenamesFile);
+  if (std::error_code EC = BufOrErr.getError())
+    exitWithErrorCode(EC, InputFilenamesFile);
+
+  SmallVector<StringRef, 8> Lines;
+  BufOrErr.get()->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                    /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    Line = Line.trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    StringRef WeightStr = Line.split(',').first;
+    uint64_t Weight;
+    if (WeightStr != Line && !WeightStr.getAsInteger(10, Weight))
+      WFV.push_back(parseWeightedFile(Line));
+    else
+      WFV.push_back(WeightedFile(Line, 1));
+  }
+}
+
 static int merge_main(int argc, const char *argv[]) {
   cl::list<std::string> InputFilenames(cl::Positional,
                                        cl::desc("<filename...>"));
@@ -227,10 +366,22 @@ static int merge_main(int argc, const char *argv[]) {
                  clEnumValN(PF_GCC, "gcc",
                             "GCC encoding (only meaningful for -sample)"),
                  clEnumValEnd));
+  cl::opt<std::string> InputFilenamesFile(
+      "input-files", cl::init(""),
+      cl::desc("Path to file containing newline-separated "
+               "[<weight>,]<filename> entries"));
+  cl::opt<unsigned> NumThreads(
+      "threads", cl::init(1),
+      cl::desc("Number of threads used to merge instrumentation profiles. "
+               "Each thread keeps its own merged profile in memory. "
+               "Sample profiles are always merged on one thread"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --threads"),
+                        cl::aliasopt(NumThreads));
 
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
-  if (InputFilenames.empty() && WeightedInputFilenames.empty())
+  if (InputFilenames.empty() && WeightedInputFilenames.empty() &&
+      InputFilenamesFile.empty())
     exitWithError("No input files specified. See " +
                   sys::path::filename(argv[0]) + " -help");
 
@@ -239,11 +390,17 @@ static int merge_main(int argc, const char *argv[]) {
     WeightedInputs.push_back(WeightedFile(Filename, 1));
   for (StringRef WeightedFilename : WeightedInputFilenames)
     WeightedInputs.push_back(parseWeightedFile(WeightedFilename));
+  if (!InputFilenamesFile.empty())
+    addWeightedInputsFromFile(InputFilenamesFile, WeightedInputs);
 
   if (ProfileKind == instr)
-    mergeInstrProfile(WeightedInputs, OutputFilename, OutputFormat);
-  else
+    mergeInstrProfile(WeightedInputs, OutputFilename, OutputFormat,
+                      NumThreads);
+  else {
+    if (NumThreads > 1)
+      errs() << "warning: -threads is ignored when merging sample profiles\n";
     mergeSampleProfile(WeightedInputs, OutputFilename, OutputFormat);
+  }
 
   return 0;
 }
@@ -42,7 +42,7 @@ namespace {
 template<typename ELFT>
 class ELFDumper : public ObjDumper {
 public:
-  ELFDumper(const ELFFile<ELFT> *Obj, StreamWriter &Writer);
+  ELFDumper(const ELFObjectFile<ELFT> *ObjF, StreamWriter &Writer);
 
   void printFileHeaders() override;
   void printSections() override;
@@ -128,6 +128,7 @@ private:
   void LoadVersionNeeds(const Elf_Shdr *ec) const;
   void LoadVersionDefs(const Elf_Shdr *sec) const;
 
+  const ELFObjectFile<ELFT> *ObjF;
   const ELFO *Obj;
   DynRegionInfo DynRelaRegion;
   const Elf_Phdr *DynamicProgHeader = nullptr;
@@ -194,7 +195,7 @@ template <class T> T errorOrDefault(ErrorOr<T> Val, T Default = T()) {
 namespace llvm {
 
 template <class ELFT>
-static std::error_code createELFDumper(const ELFFile<ELFT> *Obj,
+static std::error_code createELFDumper(const ELFObjectFile<ELFT> *Obj,
                                        StreamWriter &Writer,
                                        std::unique_ptr<ObjDumper> &Result) {
   Result.reset(new ELFDumper<ELFT>(Obj, Writer));
@@ -206,19 +207,19 @@ std::error_code createELFDumper(const object::ObjectFile *Obj,
                                 std::unique_ptr<ObjDumper> &Result) {
   // Little-endian 32-bit
   if (const ELF32LEObjectFile *ELFObj = dyn_cast<ELF32LEObjectFile>(Obj))
-    return createELFDumper(ELFObj->getELFFile(), Writer, Result);
+    return createELFDumper(ELFObj, Writer, Result);
 
   // Big-endian 32-bit
   if (const ELF32BEObjectFile *ELFObj = dyn_cast<ELF32BEObjectFile>(Obj))
-    return createELFDumper(ELFObj->getELFFile(), Writer, Result);
+    return createELFDumper(ELFObj, Writer, Result);
 
   // Little-endian 64-bit
   if (const ELF64LEObjectFile *ELFObj = dyn_cast<ELF64LEObjectFile>(Obj))
-    return createELFDumper(ELFObj->getELFFile(), Writer, Result);
+    return createELFDumper(ELFObj, Writer, Result);
 
   // Big-endian 64-bit
   if (const ELF64BEObjectFile *ELFObj = dyn_cast<ELF64BEObjectFile>(Obj))
-    return createELFDumper(ELFObj->getELFFile(), Writer, Result);
+    return createELFDumper(ELFObj, Writer, Result);
 
   return readobj_error::unsupported_obj_file_format;
 }
@@ -498,16 +499,6 @@ static const typename ELFO::Elf_Shdr *findSectionByAddress(const ELFO *Obj,
   return nullptr;
 }
 
-template <class ELFO>
-static const typename ELFO::Elf_Shdr *findSectionByName(const ELFO &Obj,
-                                                        StringRef Name) {
-  for (const auto &Shdr : Obj.sections()) {
-    if (Name == errorOrDefault(Obj.getSectionName(&Shdr)))
-      return &Shdr;
-  }
-  return nullptr;
-}
-
 static const EnumEntry<unsigned> ElfClass[] = {
   { "None",   ELF::ELFCLASSNONE },
   { "32-bit", ELF::ELFCLASS32   },
@@ -904,8 +895,9 @@ static const EnumEntry<unsigned> ElfHeaderMipsFlags[] = {
 };
 
 template <typename ELFT>
-ELFDumper<ELFT>::ELFDumper(const ELFFile<ELFT> *Obj, StreamWriter &Writer)
-    : ObjDumper(Writer), Obj(Obj) {
+ELFDumper<ELFT>::ELFDumper(const ELFObjectFile<ELFT> *ObjF,
+                           StreamWriter &Writer)
+    : ObjDumper(Writer), ObjF(ObjF), Obj(ObjF->getELFFile()) {
 
   SmallVector<const Elf_Phdr *, 4> LoadSegments;
   for (const Elf_Phdr &Phdr : Obj->program_headers()) {
@@ -1140,7 +1132,7 @@ void ELFDumper<ELFT>::printRelocations() {
   ListScope D(W, "Relocations");
 
   int SectionNumber = -1;
-  for (const Elf_Shdr &Sec : Obj->sections()) {
+  for (const Elf_Shdr &Sec : ObjF->elf_sections()) {
     ++SectionNumber;
 
     if (Sec.sh_type != ELF::SHT_REL && Sec.sh_type != ELF::SHT_RELA)
@@ -1195,7 +1187,7 @@ void ELFDumper<ELFT>::printRelocations(const Elf_Shdr *Sec) {
 
   switch (Sec->sh_type) {
   case ELF::SHT_REL:
-    for (const Elf_Rel &R : Obj->rels(Sec)) {
+    for (const Elf_Rel &R : ObjF->getRels(Sec)) {
       Elf_Rela Rela;
       Rela.r_offset = R.r_offset;
       Rela.r_info = R.r_info;
@@ -1204,7 +1196,7 @@ void ELFDumper<ELFT>::printRelocations(const Elf_Shdr *Sec) {
     }
     break;
   case ELF::SHT_RELA:
-    for (const Elf_Rela &R : Obj->relas(Sec))
+    for (const Elf_Rela &R : ObjF->getRelas(Sec))
       printRelocation(R, SymTab);
     break;
   }
@@ -1223,9 +1215,18 @@ void ELFDumper<ELFT>::printRelocation(Elf_Rela Rel, const Elf_Shdr *SymTab) {
     if (SecName)
       TargetName = SecName.get();
   } else if (Sym) {
-    ErrorOr<StringRef> StrTableOrErr = Obj->getStringTableForSymtab(*SymTab);
-    error(StrTableOrErr.getError());
-    TargetName = errorOrDefault(Sym->getName(*StrTableOrErr));
+    // The object file has the string tables of .symtab and .dynsym already.
+    // If that lookup fails, look the table up again to report why.
+    ErrorOr<StringRef> NameOrErr = object_error::parse_failed;
+    if (SymTab == DotSymtabSec || SymTab == DotDynSymSec)
+      NameOrErr = ObjF->getSymbolName(*Sym, SymTab == DotDynSymSec);
+    if (NameOrErr) {
+      TargetName = *NameOrErr;
+    } else {
+      ErrorOr<StringRef> StrTableOrErr = Obj->getStringTableForSymtab(*SymTab);
+      error(StrTableOrErr.getError());
+      TargetName = errorOrDefault(Sym->getName(*StrTableOrErr));
+    }
   }
 
   if (opts::ExpandRelocs) {
@@ -1251,7 +1252,7 @@ void ELFDumper<ELFT>::printSymbolsHelper(bool IsDynamic) {
   ErrorOr<StringRef> StrTableOrErr = Obj->getStringTableForSymtab(*Symtab);
   error(StrTableOrErr.getError());
   StringRef StrTable = *StrTableOrErr;
-  for (const Elf_Sym &Sym : Obj->symbols(Symtab))
+  for (const Elf_Sym &Sym : ObjF->elf_symbols(IsDynamic))
     printSymbol(&Sym, Symtab, StrTable, IsDynamic);
 }
 
@@ -2081,7 +2082,7 @@ static int getMipsRegisterSize(uint8_t Flag) {
 }
 
 template <class ELFT> void ELFDumper<ELFT>::printMipsABIFlags() {
-  const Elf_Shdr *Shdr = findSectionByName(*Obj, ".MIPS.abiflags");
+  const Elf_Shdr *Shdr = ObjF->findSection(".MIPS.abiflags");
   if (!Shdr) {
     W.startLine() << "There is no .MIPS.abiflags section in the file.\n";
     return;
@@ -2119,7 +2120,7 @@ template <class ELFT> void ELFDumper<ELFT>::printMipsABIFlags() {
 }
 
 template <class ELFT> void ELFDumper<ELFT>::printMipsReginfo() {
-  const Elf_Shdr *Shdr = findSectionByName(*Obj, ".reginfo");
+  const Elf_Shdr *Shdr = ObjF->findSection(".reginfo");
   if (!Shdr) {
     W.startLine() << "There is no .reginfo section in the file.\n";
     return;
@@ -15,6 +15,7 @@
 
 #include "llvm/ADT/APInt.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
@@ -26,8 +27,11 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -77,15 +81,56 @@ RadixShort(cl::desc("Print size in radix:"),
 static cl::list<std::string>
 InputFilenames(cl::Positional, cl::desc("<input files>"), cl::ZeroOrMore);
 
+static cl::opt<unsigned>
+NumThreads("threads", cl::desc("Number of threads used to read the input "
+                               "files and archive members"),
+           cl::init(1));
+
 static std::string ToolName;
 
+namespace {
+/// The column header a job wants printed in front of its output, and where.
+struct PendingHeader {
+  size_t Pos = std::string::npos;
+  std::string Text;
+};
+} // anonymous namespace
+
+// With -threads every job prints into its own buffers, which are written out
+// in input order once the job has finished. These point at the buffers of the
+// job running on the current thread and are null otherwise. Only the first
+// header is printed, so a job merely records its header in JobHeader and the
+// header is inserted when the buffers are written out.
+static LLVM_THREAD_LOCAL raw_ostream *JobOuts;
+static LLVM_THREAD_LOCAL raw_ostream *JobErrs;
+static LLVM_THREAD_LOCAL PendingHeader *JobHeader;
+
+static raw_ostream &sizeOuts() { return JobOuts ? *JobOuts : outs(); }
+static raw_ostream &sizeErrs() { return JobErrs ? *JobErrs : errs(); }
+
+/// @brief Print the column header @p Header unless a header was printed
+///        already.
+static void printHeaderOnce(StringRef Header) {
+  if (JobHeader) {
+    if (JobHeader->Pos == std::string::npos) {
+      JobHeader->Pos = sizeOuts().tell();
+      JobHeader->Text = Header;
+    }
+    return;
+  }
+  if (!berkeleyHeaderPrinted) {
+    sizeOuts() << Header;
+    berkeleyHeaderPrinted = true;
+  }
+}
+
 ///  @brief If ec is not success, print the error and return true.
 static bool error(std::error_code ec) {
   if (!ec)
     return false;
 
-  outs() << ToolName << ": error reading file: " << ec.message() << ".\n";
-  outs().flush();
+  sizeOuts() << ToolName << ": error reading file: " << ec.message() << ".\n";
+  sizeOuts().flush();
   return true;
 }
 
@@ -129,59 +174,61 @@ static void PrintDarwinSectionSizes(MachOObjectFile *MachO) {
   for (const auto &Load : MachO->load_commands()) {
     if (Load.C.cmd == MachO::LC_SEGMENT_64) {
       MachO::segment_command_64 Seg = MachO->getSegment64LoadCommand(Load);
-      outs() << "Segment " << Seg.segname << ": "
-             << format(fmt.str().c_str(), Seg.vmsize);
+      sizeOuts() << "Segment " << Seg.segname << ": "
+                 << format(fmt.str().c_str(), Seg.vmsize);
       if (DarwinLongFormat)
-        outs() << " (vmaddr 0x" << format("%" PRIx64, Seg.vmaddr) << " fileoff "
-               << Seg.fileoff << ")";
-      outs() << "\n";
+        sizeOuts() << " (vmaddr 0x" << format("%" PRIx64, Seg.vmaddr)
+                   << " fileoff " << Seg.fileoff << ")";
+      sizeOuts() << "\n";
       total += Seg.vmsize;
       uint64_t sec_total = 0;
       for (unsigned J = 0; J < Seg.nsects; ++J) {
         MachO::section_64 Sec = MachO->getSection64(Load, J);
         if (Filetype == MachO::MH_OBJECT)
-          outs() << "\tSection (" << format("%.16s", &Sec.segname) << ", "
-                 << format("%.16s", &Sec.sectname) << "): ";
+          sizeOuts() << "\tSection (" << format("%.16s", &Sec.segname) << ", "
+                     << format("%.16s", &Sec.sectname) << "): ";
         else
-          outs() << "\tSection " << format("%.16s", &Sec.sectname) << ": ";
-        outs() << format(fmt.str().c_str(), Sec.size);
+          sizeOuts() << "\tSection " << format("%.16s", &Sec.sectname) << ": ";
+        sizeOuts() << format(fmt.str().c_str(), Sec.size);
         if (DarwinLongFormat)
-          outs() << " (addr 0x" << format("%" PRIx64, Sec.addr) << " offset "
-                 << Sec.offset << ")";
-        outs() << "\n";
+          sizeOuts() << " (addr 0x" << format("%" PRIx64, Sec.addr)
+                     << " offset " << Sec.offset << ")";
+        sizeOuts() << "\n";
         sec_total += Sec.size;
       }
       if (Seg.nsects != 0)
-        outs() << "\ttotal " << format(fmt.str().c_str(), sec_total) << "\n";
+        sizeOuts() << "\ttotal " << format(fmt.str().c_str(), sec_total)
+                   << "\n";
     } else if (Load.C.cmd == MachO::LC_SEGMENT) {
       MachO::segment_command Seg = MachO->getSegmentLoadCommand(Load);
-      outs() << "Segment " << Seg.segname << ": "
-             << format(fmt.str().c_str(), Seg.vmsize);
+      sizeOuts() << "Segment " << Seg.segname << ": "
+                 << format(fmt.str().c_str(), Seg.vmsize);
       if (DarwinLongFormat)
-        outs() << " (vmaddr 0x" << format("%" PRIx64, Seg.vmaddr) << " fileoff "
-               << Seg.fileoff << ")";
-      outs() << "\n";
+        sizeOuts() << " (vmaddr 0x" << format("%" PRIx64, Seg.vmaddr)
+                   << " fileoff " << Seg.fileoff << ")";
+      sizeOuts() << "\n";
       total += Seg.vmsize;
       uint64_t sec_total = 0;
       for (unsigned J = 0; J < Seg.nsects; ++J) {
         MachO::section Sec = MachO->getSection(Load, J);
         if (Filetype == MachO::MH_OBJECT)
-          outs() << "\tSection (" << format("%.16s", &Sec.segname) << ", "
-                 << format("%.16s", &Sec.sectname) << "): ";
+          sizeOuts() << "\tSection (" << format("%.16s", &Sec.segname) << ", "
+                     << format("%.16s", &Sec.sectname) << "): ";
         else
-          outs() << "\tSection " << format("%.16s", &Sec.sectname) << ": ";
-        outs() << format(fmt.str().c_str(), Sec.size);
+          sizeOuts() << "\tSection " << format("%.16s", &Sec.sectname) << ": ";
+        sizeOuts() << format(fmt.str().c_str(), Sec.size);
         if (DarwinLongFormat)
-          outs() << " (addr 0x" << format("%" PRIx64, Sec.addr) << " offset "
-                 << Sec.offset << ")";
-        outs() << "\n";
+          sizeOuts() << " (addr 0x" << format("%" PRIx64, Sec.addr)
+                     << " offset " << Sec.offset << ")";
+        sizeOuts() << "\n";
         sec_total += Sec.size;
       }
       if (Seg.nsects != 0)
-        outs() << "\ttotal " << format(fmt.str().c_str(), sec_total) << "\n";
+        sizeOuts() << "\ttotal " << format(fmt.str().c_str(), sec_total)
+                   << "\n";
     }
   }
-  outs() << "total " << format(fmt.str().c_str(), total) << "\n";
+  sizeOuts() << "total " << format(fmt.str().c_str(), total) << "\n";
 }
 
 /// @brief Print the summary sizes of the standard Mach-O segments in @p MachO.
@@ -250,13 +297,46 @@ static void PrintDarwinSegmentSizes(MachOObjectFile *MachO) {
   }
   uint64_t total = total_text + total_data + total_objc + total_others;
 
-  if (!berkeleyHeaderPrinted) {
-    outs() << "__TEXT\t__DATA\t__OBJC\tothers\tdec\thex\n";
-    berkeleyHeaderPrinted = true;
+  printHeaderOnce("__TEXT\t__DATA\t__OBJC\tothers\tdec\thex\n");
+  sizeOuts() << total_text << "\t" << total_data << "\t" << total_objc << "\t"
+             << total_others << "\t" << total << "\t"
+             << format("%" PRIx64, total) << "\t";
+}
+
+/// @brief Add up the sizes of the text, data and bss sections of an ELF
+///        object, reading the section headers in place.
+template <class ELFT>
+static void sumELFSectionSizes(const ELFObjectFile<ELFT> &Obj,
+                               uint64_t &total_text, uint64_t &total_data,
+                               uint64_t &total_bss) {
+  for (const auto &Sec : Obj.elf_sections()) {
+    // The same classification as SectionRef::isText, isData and isBSS.
+    if (Sec.sh_flags & ELF::SHF_EXECINSTR)
+      total_text += Sec.sh_size;
+    else if (!(Sec.sh_flags & (ELF::SHF_ALLOC | ELF::SHF_WRITE)))
+      continue;
+    else if (Sec.sh_type == ELF::SHT_PROGBITS)
+      total_data += Sec.sh_size;
+    else if (Sec.sh_type == ELF::SHT_NOBITS)
+      total_bss += Sec.sh_size;
   }
-  outs() << total_text << "\t" << total_data << "\t" << total_objc << "\t"
-         << total_others << "\t" << total << "\t" << format("%" PRIx64, total)
-         << "\t";
+}
+
+/// @brief Add up the sizes of the text, data and bss sections of @p Obj if
+///        it is an ELF object. Returns false otherwise.
+static bool sumELFSectionSizes(const ObjectFile *Obj, uint64_t &total_text,
+                               uint64_t &total_data, uint64_t &total_bss) {
+  if (auto *ELFObj = dyn_cast<ELF32LEObjectFile>(Obj))
+    sumELFSectionSizes(*ELFObj, total_text, total_data, total_bss);
+  else if (auto *ELFObj = dyn_cast<ELF64LEObjectFile>(Obj))
+    sumELFSectionSizes(*ELFObj, total_text, total_data, total_bss);
+  else if (auto *ELFObj = dyn_cast<ELF32BEObjectFile>(Obj))
+    sumELFSectionSizes(*ELFObj, total_text, total_data, total_bss);
+  else if (auto *ELFObj = dyn_cast<ELF64BEObjectFile>(Obj))
+    sumELFSectionSizes(*ELFObj, total_text, total_data, total_bss);
+  else
+    return false;
+  return true;
 }
 
 /// @brief Print the size of each section in @p Obj.
@@ -308,9 +388,10 @@ static void PrintObjectSectionSizes(ObjectFile *Obj) {
         << "%" << max_addr_len << "s\n";
 
     // Print header
-    outs() << format(fmt.str().c_str(), static_cast<const char *>("section"),
-                     static_cast<const char *>("size"),
-                     static_cast<const char *>("addr"));
+    sizeOuts() << format(fmt.str().c_str(),
+                         static_cast<const char *>("section"),
+                         static_cast<const char *>("size"),
+                         static_cast<const char *>("addr"));
     fmtbuf.clear();
 
     // Setup per section format.
@@ -327,15 +408,15 @@ static void PrintObjectSectionSizes(ObjectFile *Obj) {
       uint64_t addr = Section.getAddress();
       std::string namestr = name;
 
-      outs() << format(fmt.str().c_str(), namestr.c_str(), size, addr);
+      sizeOuts() << format(fmt.str().c_str(), namestr.c_str(), size, addr);
     }
 
     // Print total.
     fmtbuf.clear();
     fmt << "%-" << max_name_len << "s "
         << "%#" << max_size_len << radix_fmt << "\n";
-    outs() << format(fmt.str().c_str(), static_cast<const char *>("Total"),
-                     total);
+    sizeOuts() << format(fmt.str().c_str(),
+                         static_cast<const char *>("Total"), total);
   } else {
     // The Berkeley format does not display individual section sizes. It
     // displays the cumulative size for each section type.
@@ -344,36 +425,36 @@ static void PrintObjectSectionSizes(ObjectFile *Obj) {
     uint64_t total_bss = 0;
 
     // Make one pass over the section table to calculate sizes.
-    for (const SectionRef &Section : Obj->sections()) {
-      uint64_t size = Section.getSize();
-      bool isText = Section.isText();
-      bool isData = Section.isData();
-      bool isBSS = Section.isBSS();
-      if (isText)
-        total_text += size;
-      else if (isData)
-        total_data += size;
-      else if (isBSS)
-        total_bss += size;
+    if (!sumELFSectionSizes(Obj, total_text, total_data, total_bss)) {
+      for (const SectionRef &Section : Obj->sections()) {
+        uint64_t size = Section.getSize();
+        bool isText = Section.isText();
+        bool isData = Section.isData();
+        bool isBSS = Section.isBSS();
+        if (isText)
+          total_text += size;
+        else if (isData)
+          total_data += size;
+        else if (isBSS)
+          total_bss += size;
+      }
     }
 
     total = total_text + total_data + total_bss;
 
-    if (!berkeleyHeaderPrinted) {
-      outs() << "   text    data     bss     "
-             << (Radix == octal ? "oct" : "dec") << "     hex filename\n";
-      berkeleyHeaderPrinted = true;
-    }
+    printHeaderOnce(Radix == octal
+                        ? "   text    data     bss     oct     hex filename\n"
+                        : "   text    data     bss     dec     hex filename\n");
 
     // Print result.
     fmt << "%#7" << radix_fmt << " "
         << "%#7" << radix_fmt << " "
         << "%#7" << radix_fmt << " ";
-    outs() << format(fmt.str().c_str(), total_text, total_data, total_bss);
+    sizeOuts() << format(fmt.str().c_str(), total_text, total_data, total_bss);
     fmtbuf.clear();
     fmt << "%7" << (Radix == octal ? PRIo64 : PRIu64) << " "
         << "%7" PRIx64 " ";
-    outs() << format(fmt.str().c_str(), total, total);
+    sizeOuts() << format(fmt.str().c_str(), total, total);
   }
 }
 
@@ -403,61 +484,130 @@ static bool checkMachOAndArchFlags(ObjectFile *o, StringRef file) {
       break;
     }
     if (!ArchFound) {
-      errs() << ToolName << ": file: " << file
-             << " does not contain architecture: " << ArchFlags[i] << ".\n";
+      sizeErrs() << ToolName << ": file: " << file
+                 << " does not contain architecture: " << ArchFlags[i] << ".\n";
       return false;
     }
   }
   return true;
 }
 
-/// @brief Print the section sizes for @p file. If @p file is an archive, print
-///        the section sizes for each archive member.
-static void PrintFileSectionSizes(StringRef file) {
+namespace {
+/// Runs the work for the input files. With -threads=1 every job runs as soon
+/// as it is added and prints straight to stdout and stderr. Otherwise jobs are
+/// queued, run on a thread pool a window at a time, and their buffered output
+/// is written out in the order the jobs were added.
+class SizeQueue {
+  struct Job {
+    std::function<bool()> Run;
+    unsigned Group;
+    bool Result;
+    PendingHeader Header;
+    std::string Out;
+    std::string Err;
+  };
+
+  std::unique_ptr<ThreadPool> Pool;
+  std::vector<Job> Jobs;
+  unsigned StoppedGroup = 0;
+
+  static void run(Job &J) {
+    raw_string_ostream Out(J.Out), Err(J.Err);
+    JobOuts = &Out;
+    JobErrs = &Err;
+    JobHeader = &J.Header;
+    J.Result = J.Run();
+    JobOuts = JobErrs = nullptr;
+    JobHeader = nullptr;
+  }
 
-  // Attempt to open the binary.
-  ErrorOr<OwningBinary<Binary>> BinaryOrErr = createBinary(file);
-  if (std::error_code EC = BinaryOrErr.getError()) {
-    errs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
-    return;
+public:
+  SizeQueue() {
+    if (NumThreads > 1)
+      Pool.reset(new ThreadPool(NumThreads));
   }
-  Binary &Bin = *BinaryOrErr.get().getBinary();
-
-  if (Archive *a = dyn_cast<Archive>(&Bin)) {
-    // This is an archive. Iterate over each member and display its sizes.
-    for (object::Archive::child_iterator i = a->child_begin(),
-                                         e = a->child_end();
-         i != e; ++i) {
-      if (i->getError()) {
-        errs() << ToolName << ": " << file << ": " << i->getError().message()
-               << ".\n";
-        exit(1);
-      }
-      auto &c = i->get();
-      ErrorOr<std::unique_ptr<Binary>> ChildOrErr = c.getAsBinary();
-      if (std::error_code EC = ChildOrErr.getError()) {
-        errs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+
+  ~SizeQueue() { flush(); }
+
+  /// Adds a job for the input file numbered \p Group, counting from 1. A job
+  /// returns false to drop the jobs after it in the same group.
+  void add(unsigned Group, std::function<bool()> Run) {
+    if (!Pool) {
+      if (Group != StoppedGroup && !Run())
+        StoppedGroup = Group;
+      return;
+    }
+    Jobs.push_back(
+        {std::move(Run), Group, true, PendingHeader(), std::string(),
+         std::string()});
+    if (Jobs.size() >= NumThreads * 16)
+      flush();
+  }
+
+  void flush() {
+    if (Jobs.empty())
+      return;
+    parallelForBatches(*Pool, Jobs.size(), NumThreads * 4,
+                       [this](size_t, size_t Begin, size_t End) {
+                         for (size_t I = Begin; I != End; ++I)
+                           run(Jobs[I]);
+                       });
+    for (Job &J : Jobs) {
+      if (J.Group == StoppedGroup)
         continue;
+      StringRef Out = J.Out;
+      if (J.Header.Pos != std::string::npos && !berkeleyHeaderPrinted) {
+        outs() << Out.substr(0, J.Header.Pos) << J.Header.Text;
+        berkeleyHeaderPrinted = true;
+        Out = Out.substr(J.Header.Pos);
       }
-      if (ObjectFile *o = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
-        MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
-        if (!checkMachOAndArchFlags(o, file))
-          return;
-        if (OutputFormat == sysv)
-          outs() << o->getFileName() << "   (ex " << a->getFileName() << "):\n";
-        else if (MachO && OutputFormat == darwin)
-          outs() << a->getFileName() << "(" << o->getFileName() << "):\n";
-        PrintObjectSectionSizes(o);
-        if (OutputFormat == berkeley) {
-          if (MachO)
-            outs() << a->getFileName() << "(" << o->getFileName() << ")\n";
-          else
-            outs() << o->getFileName() << " (ex " << a->getFileName() << ")\n";
-        }
+      outs() << Out;
+      if (!J.Err.empty()) {
+        outs().flush();
+        errs() << J.Err;
       }
+      if (!J.Result)
+        StoppedGroup = J.Group;
+    }
+    Jobs.clear();
+  }
+};
+} // anonymous namespace
+
+/// @brief Print the section sizes for the archive member @p c of @p a.
+///        Returns false if the remaining members should not be printed.
+static bool PrintArchiveMemberSectionSizes(const Archive::Child &c,
+                                           const Archive *a, StringRef file) {
+  ErrorOr<std::unique_ptr<Binary>> ChildOrErr = c.getAsBinary();
+  if (std::error_code EC = ChildOrErr.getError()) {
+    sizeErrs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+    return true;
+  }
+  if (ObjectFile *o = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
+    MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
+    if (!checkMachOAndArchFlags(o, file))
+      return false;
+    if (OutputFormat == sysv)
+      sizeOuts() << o->getFileName() << "   (ex " << a->getFileName()
+                 << "):\n";
+    else if (MachO && OutputFormat == darwin)
+      sizeOuts() << a->getFileName() << "(" << o->getFileName() << "):\n";
+    PrintObjectSectionSizes(o);
+    if (OutputFormat == berkeley) {
+      if (MachO)
+        sizeOuts() << a->getFileName() << "(" << o->getFileName() << ")\n";
+      else
+        sizeOuts() << o->getFileName() << " (ex " << a->getFileName()
+                   << ")\n";
     }
-  } else if (MachOUniversalBinary *UB =
-                 dyn_cast<MachOUniversalBinary>(&Bin)) {
+  }
+  return true;
+}
+
+/// @brief Print the section sizes for @p Bin, which was read from @p file and
+///        is not an archive.
+static void PrintBinarySectionSizes(Binary &Bin, StringRef file) {
+  if (MachOUniversalBinary *UB = dyn_cast<MachOUniversalBinary>(&Bin)) {
     // If we have a list of architecture flags specified dump only those.
     if (!ArchAll && ArchFlags.size() != 0) {
       // Look for a slice in the universal binary that matches each ArchFlag.
@@ -474,18 +624,18 @@ static void PrintFileSectionSizes(StringRef file) {
               if (ObjectFile *o = dyn_cast<ObjectFile>(&*UO.get())) {
                 MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
                 if (OutputFormat == sysv)
-                  outs() << o->getFileName() << "  :\n";
+                  sizeOuts() << o->getFileName() << "  :\n";
                 else if (MachO && OutputFormat == darwin) {
                   if (moreThanOneFile || ArchFlags.size() > 1)
-                    outs() << o->getFileName() << " (for architecture "
-                           << I->getArchTypeName() << "): \n";
+                    sizeOuts() << o->getFileName() << " (for architecture "
+                               << I->getArchTypeName() << "): \n";
                 }
                 PrintObjectSectionSizes(o);
                 if (OutputFormat == berkeley) {
                   if (!MachO || moreThanOneFile || ArchFlags.size() > 1)
-                    outs() << o->getFileName() << " (for architecture "
-                           << I->getArchTypeName() << ")";
-                  outs() << "\n";
+                    sizeOuts() << o->getFileName() << " (for architecture "
+                               << I->getArchTypeName() << ")";
+                  sizeOuts() << "\n";
                 }
               }
             } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr =
@@ -497,39 +647,42 @@ static void PrintFileSectionSizes(StringRef file) {
                                                    e = UA->child_end();
                    i != e; ++i) {
                 if (std::error_code EC = i->getError()) {
-                  errs() << ToolName << ": " << file << ": " << EC.message()
-                         << ".\n";
+                  sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                             << ".\n";
                   exit(1);
                 }
                 auto &c = i->get();
                 ErrorOr<std::unique_ptr<Binary>> ChildOrErr = c.getAsBinary();
                 if (std::error_code EC = ChildOrErr.getError()) {
-                  errs() << ToolName << ": " << file << ": " << EC.message()
-                         << ".\n";
+                  sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                             << ".\n";
                   continue;
                 }
                 if (ObjectFile *o = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
                   MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
                   if (OutputFormat == sysv)
-                    outs() << o->getFileName() << "   (ex " << UA->getFileName()
-                           << "):\n";
+                    sizeOuts() << o->getFileName() << "   (ex "
+                               << UA->getFileName()
+                               << "):\n";
                   else if (MachO && OutputFormat == darwin)
-                    outs() << UA->getFileName() << "(" << o->getFileName()
-                           << ")"
-                           << " (for architecture " << I->getArchTypeName()
-                           << "):\n";
+                    sizeOuts() << UA->getFileName() << "(" << o->getFileName()
+                               << ")"
+                               << " (for architecture " << I->getArchTypeName()
+                               << "):\n";
                   PrintObjectSectionSizes(o);
                   if (OutputFormat == berkeley) {
                     if (MachO) {
-                      outs() << UA->getFileName() << "(" << o->getFileName()
-                             << ")";
+                      sizeOuts() << UA->getFileName() << "(" << o->getFileName()
+                                 << ")";
                       if (ArchFlags.size() > 1)
-                        outs() << " (for architecture " << I->getArchTypeName()
-                               << ")";
-                      outs() << "\n";
+                        sizeOuts() << " (for architecture "
+                                   << I->getArchTypeName()
+                                   << ")";
+                      sizeOuts() << "\n";
                     } else
-                      outs() << o->getFileName() << " (ex " << UA->getFileName()
-                             << ")\n";
+                      sizeOuts() << o->getFileName() << " (ex "
+                                 << UA->getFileName()
+                                 << ")\n";
                   }
                 }
               }
@@ -537,8 +690,9 @@ static void PrintFileSectionSizes(StringRef file) {
           }
         }
         if (!ArchFound) {
-          errs() << ToolName << ": file: " << file
-                 << " does not contain architecture" << ArchFlags[i] << ".\n";
+          sizeErrs() << ToolName << ": file: " << file
+                     << " does not contain architecture" << ArchFlags[i]
+                     << ".\n";
           return;
         }
       }
@@ -557,18 +711,18 @@ static void PrintFileSectionSizes(StringRef file) {
             if (ObjectFile *o = dyn_cast<ObjectFile>(&*UO.get())) {
               MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
               if (OutputFormat == sysv)
-                outs() << o->getFileName() << "  :\n";
+                sizeOuts() << o->getFileName() << "  :\n";
               else if (MachO && OutputFormat == darwin) {
                 if (moreThanOneFile)
-                  outs() << o->getFileName() << " (for architecture "
-                         << I->getArchTypeName() << "):\n";
+                  sizeOuts() << o->getFileName() << " (for architecture "
+                             << I->getArchTypeName() << "):\n";
               }
               PrintObjectSectionSizes(o);
               if (OutputFormat == berkeley) {
                 if (!MachO || moreThanOneFile)
-                  outs() << o->getFileName() << " (for architecture "
-                         << I->getArchTypeName() << ")";
-                outs() << "\n";
+                  sizeOuts() << o->getFileName() << " (for architecture "
+                             << I->getArchTypeName() << ")";
+                sizeOuts() << "\n";
               }
             }
           } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr =
@@ -580,34 +734,37 @@ static void PrintFileSectionSizes(StringRef file) {
                                                  e = UA->child_end();
                  i != e; ++i) {
               if (std::error_code EC = i->getError()) {
-                errs() << ToolName << ": " << file << ": " << EC.message()
-                       << ".\n";
+                sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                           << ".\n";
                 exit(1);
               }
               auto &c = i->get();
               ErrorOr<std::unique_ptr<Binary>> ChildOrErr = c.getAsBinary();
               if (std::error_code EC = ChildOrErr.getError()) {
-                errs() << ToolName << ": " << file << ": " << EC.message()
-                       << ".\n";
+                sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                           << ".\n";
                 continue;
               }
               if (ObjectFile *o = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
                 MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
                 if (OutputFormat == sysv)
-                  outs() << o->getFileName() << "   (ex " << UA->getFileName()
-                         << "):\n";
+                  sizeOuts() << o->getFileName() << "   (ex "
+                             << UA->getFileName()
+                             << "):\n";
                 else if (MachO && OutputFormat == darwin)
-                  outs() << UA->getFileName() << "(" << o->getFileName() << ")"
-                         << " (for architecture " << I->getArchTypeName()
-                         << "):\n";
+                  sizeOuts() << UA->getFileName() << "(" << o->getFileName()
+                             << ")"
+                             << " (for architecture " << I->getArchTypeName()
+                             << "):\n";
                 PrintObjectSectionSizes(o);
                 if (OutputFormat == berkeley) {
                   if (MachO)
-                    outs() << UA->getFileName() << "(" << o->getFileName()
-                           << ")\n";
+                    sizeOuts() << UA->getFileName() << "(" << o->getFileName()
+                               << ")\n";
                   else
-                    outs() << o->getFileName() << " (ex " << UA->getFileName()
-                           << ")\n";
+                    sizeOuts() << o->getFileName() << " (ex "
+                               << UA->getFileName()
+                               << ")\n";
                 }
               }
             }
@@ -627,19 +784,19 @@ static void PrintFileSectionSizes(StringRef file) {
         if (ObjectFile *o = dyn_cast<ObjectFile>(&*UO.get())) {
           MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
           if (OutputFormat == sysv)
-            outs() << o->getFileName() << "  :\n";
+            sizeOuts() << o->getFileName() << "  :\n";
           else if (MachO && OutputFormat == darwin) {
             if (moreThanOneFile || moreThanOneArch)
-              outs() << o->getFileName() << " (for architecture "
-                     << I->getArchTypeName() << "):";
-            outs() << "\n";
+              sizeOuts() << o->getFileName() << " (for architecture "
+                         << I->getArchTypeName() << "):";
+            sizeOuts() << "\n";
           }
           PrintObjectSectionSizes(o);
           if (OutputFormat == berkeley) {
             if (!MachO || moreThanOneFile || moreThanOneArch)
-              outs() << o->getFileName() << " (for architecture "
-                     << I->getArchTypeName() << ")";
-            outs() << "\n";
+              sizeOuts() << o->getFileName() << " (for architecture "
+                         << I->getArchTypeName() << ")";
+            sizeOuts() << "\n";
           }
         }
       } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr =
@@ -650,32 +807,36 @@ static void PrintFileSectionSizes(StringRef file) {
                                              e = UA->child_end();
              i != e; ++i) {
           if (std::error_code EC = i->getError()) {
-            errs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+            sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                       << ".\n";
             exit(1);
           }
           auto &c = i->get();
           ErrorOr<std::unique_ptr<Binary>> ChildOrErr = c.getAsBinary();
           if (std::error_code EC = ChildOrErr.getError()) {
-            errs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+            sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                       << ".\n";
             continue;
           }
           if (ObjectFile *o = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
             MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
             if (OutputFormat == sysv)
-              outs() << o->getFileName() << "   (ex " << UA->getFileName()
-                     << "):\n";
+              sizeOuts() << o->getFileName() << "   (ex " << UA->getFileName()
+                         << "):\n";
             else if (MachO && OutputFormat == darwin)
-              outs() << UA->getFileName() << "(" << o->getFileName() << ")"
-                     << " (for architecture " << I->getArchTypeName() << "):\n";
+              sizeOuts() << UA->getFileName() << "(" << o->getFileName() << ")"
+                         << " (for architecture " << I->getArchTypeName()
+                         << "):\n";
             PrintObjectSectionSizes(o);
             if (OutputFormat == berkeley) {
               if (MachO)
-                outs() << UA->getFileName() << "(" << o->getFileName() << ")"
-                       << " (for architecture " << I->getArchTypeName()
-                       << ")\n";
+                sizeOuts() << UA->getFileName() << "(" << o->getFileName()
+                           << ")"
+                           << " (for architecture " << I->getArchTypeName()
+                           << ")\n";
               else
-                outs() << o->getFileName() << " (ex " << UA->getFileName()
-                       << ")\n";
+                sizeOuts() << o->getFileName() << " (ex " << UA->getFileName()
+                           << ")\n";
             }
           }
         }
@@ -685,21 +846,88 @@ static void PrintFileSectionSizes(StringRef file) {
     if (!checkMachOAndArchFlags(o, file))
       return;
     if (OutputFormat == sysv)
-      outs() << o->getFileName() << "  :\n";
+      sizeOuts() << o->getFileName() << "  :\n";
     PrintObjectSectionSizes(o);
     if (OutputFormat == berkeley) {
       MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(o);
       if (!MachO || moreThanOneFile)
-        outs() << o->getFileName();
-      outs() << "\n";
+        sizeOuts() << o->getFileName();
+      sizeOuts() << "\n";
     }
   } else {
-    errs() << ToolName << ": " << file << ": "
-           << "Unrecognized file type.\n";
+    sizeErrs() << ToolName << ": " << file << ": "
+               << "Unrecognized file type.\n";
   }
   // System V adds an extra newline at the end of each file.
   if (OutputFormat == sysv)
-    outs() << "\n";
+    sizeOuts() << "\n";
+}
+
+/// @brief Print the section sizes for @p file. If @p file is an archive, print
+///        the section sizes for each archive member, each in a job of its own.
+static void PrintFileSectionSizes(std::string file, unsigned Group,
+                                  SizeQueue &Queue) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFileOrSTDIN(file);
+  if (std::error_code EC = BufferOrErr.getError()) {
+    Queue.add(Group, [=] {
+      sizeErrs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+      return true;
+    });
+    return;
+  }
+  std::shared_ptr<MemoryBuffer> Buffer = std::move(*BufferOrErr);
+
+  if (sys::fs::identify_magic(Buffer->getBuffer()) !=
+      sys::fs::file_magic::archive) {
+    Queue.add(Group, [=] {
+      ErrorOr<std::unique_ptr<Binary>> BinaryOrErr =
+          createBinary(Buffer->getMemBufferRef());
+      if (std::error_code EC = BinaryOrErr.getError()) {
+        sizeErrs() << ToolName << ": " << file << ": " << EC.message()
+                   << ".\n";
+        return true;
+      }
+      PrintBinarySectionSizes(**BinaryOrErr, file);
+      return true;
+    });
+    return;
+  }
+
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(Buffer->getMemBufferRef());
+  if (std::error_code EC = ArchiveOrErr.getError()) {
+    Queue.add(Group, [=] {
+      sizeErrs() << ToolName << ": " << file << ": " << EC.message() << ".\n";
+      return true;
+    });
+    return;
+  }
+  std::shared_ptr<Archive> a = std::move(*ArchiveOrErr);
+
+  // This is an archive. Iterate over each member and display its sizes. The
+  // archive refers to the buffer and the members to the archive, so every job
+  // holds on to both.
+  for (object::Archive::child_iterator i = a->child_begin(),
+                                       e = a->child_end();
+       i != e; ++i) {
+    if (i->getError()) {
+      Queue.flush();
+      errs() << ToolName << ": " << file << ": " << i->getError().message()
+             << ".\n";
+      exit(1);
+    }
+    Archive::Child c = i->get();
+    Queue.add(Group, [c, a, Buffer, file] {
+      return PrintArchiveMemberSectionSizes(c, a.get(), file);
+    });
+  }
+  // System V adds an extra newline at the end of each file.
+  if (OutputFormat == sysv)
+    Queue.add(Group, [] {
+      sizeOuts() << "\n";
+      return true;
+    });
 }
 
 int main(int argc, char **argv) {
@@ -732,8 +960,11 @@ int main(int argc, char **argv) {
     InputFilenames.push_back("a.out");
 
   moreThanOneFile = InputFilenames.size() > 1;
-  std::for_each(InputFilenames.begin(), InputFilenames.end(),
-                PrintFileSectionSizes);
+  {
+    SizeQueue Queue;
+    for (unsigned I = 0, E = InputFilenames.size(); I != E; ++I)
+      PrintFileSectionSizes(InputFilenames[I], I + 1, Queue);
+  }
 
   return 0;
 }
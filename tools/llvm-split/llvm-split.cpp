@@ -35,6 +35,16 @@ OutputFilename("o", cl::desc("Override output filename"),
 static cl::opt<unsigned> NumOutputs("j", cl::Prefix, cl::init(2),
                                     cl::desc("Number of output files"));
 
+static cl::opt<bool>
+    PreserveLocals("preserve-locals", cl::init(false),
+                   cl::desc("Keep local symbols local and balance the size "
+                            "of the output files"));
+
+static cl::opt<bool>
+    PreserveOrder("preserve-order", cl::init(false),
+                  cl::desc("Keep local symbols local and split the module "
+                           "into contiguous runs of similar size"));
+
 int main(int argc, char **argv) {
   LLVMContext &Context = getGlobalContext();
   SMDiagnostic Err;
@@ -61,7 +71,7 @@ int main(int argc, char **argv) {
 
     // Declare success.
     Out->keep();
-  });
+  }, PreserveLocals, PreserveOrder);
 
   return 0;
 }
@@ -86,6 +86,16 @@ static cl::opt<int> ClPrintSourceContextLines(
     "print-source-context-lines", cl::init(0),
     cl::desc("Print N number of source file context"));
 
+static cl::opt<unsigned> ClDWARFParseThreads(
+    "dwarf-parse-threads", cl::init(0),
+    cl::desc("Parse the debug info of each object file up front, on N "
+             "threads"));
+
+static cl::opt<std::string>
+    ClCacheDir("cache-dir", cl::init(""),
+               cl::desc("Directory where the results are cached, per build "
+                        "ID, for later runs"));
+
 static bool error(std::error_code ec) {
   if (!ec)
     return false;
@@ -147,6 +157,8 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClPrintFunctions, ClUseSymbolTable, ClDemangle,
                                ClUseRelativeAddress, ClDefaultArch);
+  Opts.DWARFParseThreads = ClDWARFParseThreads;
+  Opts.CacheDir = ClCacheDir;
 
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
@@ -405,6 +405,27 @@ TEST(DenseMapCustomTest, FindAsTest) {
   EXPECT_TRUE(map.find_as("d") == map.end());
 }
 
+// insert_as() tests
+TEST(DenseMapCustomTest, InsertAsTest) {
+  // Start small, so that the map grows while inserting with the alternate key.
+  DenseMap<unsigned, unsigned, TestDenseMapInfo> map(4);
+  EXPECT_TRUE(map.insert_as(std::make_pair(0u, 1u), "a").second);
+  EXPECT_TRUE(map.insert_as(std::make_pair(1u, 2u), "b").second);
+
+  // An existing entry is found with the alternate key, and left alone.
+  auto Insertion = map.insert_as(std::make_pair(0u, 5u), "a");
+  EXPECT_FALSE(Insertion.second);
+  EXPECT_EQ(1u, Insertion.first->second);
+
+  for (unsigned I = 2; I < 26; ++I) {
+    char Key[2] = {char('a' + I), 0};
+    EXPECT_TRUE(map.insert_as(std::make_pair(I, I + 1), Key).second);
+  }
+  EXPECT_EQ(26u, map.size());
+  for (unsigned I = 0; I < 26; ++I)
+    EXPECT_EQ(I + 1, map.find(I)->second);
+}
+
 struct ContiguousDenseMapInfo {
   static inline unsigned getEmptyKey() { return ~0; }
   static inline unsigned getTombstoneKey() { return ~0U - 1; }
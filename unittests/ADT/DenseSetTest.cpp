@@ -65,4 +65,13 @@ TEST(DenseSetCustomTest, FindAsTest) {
   EXPECT_TRUE(set.find_as("d") == set.end());
 }
 
+TEST(DenseSetCustomTest, InsertAsTest) {
+  DenseSet<unsigned, TestDenseSetInfo> set;
+  EXPECT_TRUE(set.insert_as(0, "a").second);
+  EXPECT_TRUE(set.insert_as(1, "b").second);
+  EXPECT_FALSE(set.insert_as(0, "a").second);
+  EXPECT_EQ(2u, set.size());
+  EXPECT_EQ(1u, *set.find_as("b"));
+}
+
 }
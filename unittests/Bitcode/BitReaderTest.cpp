@@ -12,6 +12,7 @@
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
@@ -272,4 +273,117 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+static const char *SymbolsAssembly =
+    "target datalayout = \"e-m:x-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32\"\n"
+    "$c = comdat any\n"
+    "@common = common global i64 0, align 8\n"
+    "@in_comdat = global i32 0, comdat($c)\n"
+    "@external = external global i32\n"
+    "@imported = external dllimport global i32\n"
+    "@alias = hidden alias i32, i32* @in_comdat\n"
+    "define void @func() comdat($c) {\n"
+    "  ret void\n"
+    "}\n"
+    "define internal void @internal() {\n"
+    "  ret void\n"
+    "}\n";
+
+// The symbols are the same whether they are read from the records of the
+// module or from its symbol table block, except for what only the latter
+// knows: the size of common symbols and the comdat of aliases.
+static void checkSymbols(bool EmitSymbolTable) {
+  SmallString<1024> Mem;
+  raw_svector_ostream OS(Mem);
+  WriteBitcodeToFile(parseAssembly(SymbolsAssembly).get(), OS, false, false,
+                     EmitSymbolTable);
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      readBitcodeSymbols(MemoryBufferRef(Mem.str(), "test"));
+  ASSERT_TRUE(bool(SymbolsOrErr));
+  std::vector<BitcodeSymbol> &Symbols = *SymbolsOrErr;
+  ASSERT_EQ(7u, Symbols.size());
+
+  EXPECT_EQ("_func", Symbols[0].Name);
+  EXPECT_EQ("c", Symbols[0].Comdat);
+  EXPECT_FALSE(Symbols[0].IsDeclaration);
+
+  EXPECT_EQ("_internal", Symbols[1].Name);
+  EXPECT_EQ(GlobalValue::InternalLinkage, Symbols[1].Linkage);
+
+  EXPECT_EQ("_common", Symbols[2].Name);
+  EXPECT_EQ(GlobalValue::CommonLinkage, Symbols[2].Linkage);
+  EXPECT_EQ(EmitSymbolTable ? 8u : 0u, Symbols[2].CommonSize);
+  EXPECT_EQ(8u, Symbols[2].CommonAlign);
+
+  EXPECT_EQ("_in_comdat", Symbols[3].Name);
+  EXPECT_EQ("c", Symbols[3].Comdat);
+
+  EXPECT_EQ("_external", Symbols[4].Name);
+  EXPECT_TRUE(Symbols[4].IsDeclaration);
+
+  // The names are the ones the Mangler gives, without an "__imp_" prefix.
+  EXPECT_EQ("_imported", Symbols[5].Name);
+  EXPECT_TRUE(Symbols[5].IsDeclaration);
+
+  EXPECT_EQ("_alias", Symbols[6].Name);
+  EXPECT_EQ(GlobalValue::HiddenVisibility, Symbols[6].Visibility);
+  EXPECT_EQ(EmitSymbolTable ? "c" : "", Symbols[6].Comdat);
+}
+
+TEST(BitReaderTest, ReadSymbols) {
+  checkSymbols(/*EmitSymbolTable=*/false);
+  checkSymbols(/*EmitSymbolTable=*/true);
+}
+
+TEST(BitReaderTest, ReadSymbolsCanBeOmitted) {
+  SmallString<1024> Mem;
+  raw_svector_ostream OS(Mem);
+  WriteBitcodeToFile(parseAssembly("@ptr = global void ()* @taken\n"
+                                   "define linkonce_odr void @taken() {\n"
+                                   "  ret void\n"
+                                   "}\n"
+                                   "define linkonce_odr void @called() {\n"
+                                   "  ret void\n"
+                                   "}\n"
+                                   "define void @caller() {\n"
+                                   "  call void @called()\n"
+                                   "  ret void\n"
+                                   "}\n").get(),
+                     OS, false, false, /*EmitSymbolTable=*/true);
+  bool HasSymbolTable = false;
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      readBitcodeSymbols(MemoryBufferRef(Mem.str(), "test"), &HasSymbolTable);
+  ASSERT_TRUE(bool(SymbolsOrErr));
+  EXPECT_TRUE(HasSymbolTable);
+  std::vector<BitcodeSymbol> &Symbols = *SymbolsOrErr;
+  ASSERT_EQ(4u, Symbols.size());
+
+  EXPECT_EQ("taken", Symbols[0].Name);
+  EXPECT_FALSE(Symbols[0].CanBeOmittedFromSymbolTable);
+  EXPECT_EQ("called", Symbols[1].Name);
+  EXPECT_TRUE(Symbols[1].CanBeOmittedFromSymbolTable);
+  EXPECT_EQ("caller", Symbols[2].Name);
+  EXPECT_FALSE(Symbols[2].CanBeOmittedFromSymbolTable);
+}
+
+TEST(BitReaderTest, ReadSymbolsInvalidAlignment) {
+  SmallVector<char, 64> Mem;
+  BitstreamWriter Stream(Mem);
+  Stream.Emit('B', 8);
+  Stream.Emit('C', 8);
+  Stream.Emit(0x0, 4);
+  Stream.Emit(0xC, 4);
+  Stream.Emit(0xE, 4);
+  Stream.Emit(0xD, 4);
+  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  // GLOBALVAR: [pointer type, isconst, initid, linkage, alignment, section]
+  uint64_t Record[] = {0, 0, 0, 0, 64, 0};
+  Stream.EmitRecord(bitc::MODULE_CODE_GLOBALVAR, Record);
+  Stream.ExitBlock();
+
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr = readBitcodeSymbols(
+      MemoryBufferRef(StringRef(Mem.data(), Mem.size()), "test"));
+  EXPECT_EQ(make_error_code(BitcodeError::CorruptedBitcode),
+            SymbolsOrErr.getError());
+}
+
 } // end namespace
@@ -0,0 +1,214 @@
+//===- llvm/unittest/Object/ELFObjectFileTest.cpp - ELFObjectFile tests ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/ELFObjectFile.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+namespace {
+
+typedef ELF64LEObjectFile::Elf_Ehdr Elf_Ehdr;
+typedef ELF64LEObjectFile::Elf_Shdr Elf_Shdr;
+typedef ELF64LEObjectFile::Elf_Sym Elf_Sym;
+typedef ELF64LEObjectFile::Elf_Rel Elf_Rel;
+typedef ELF64LEObjectFile::Elf_Rela Elf_Rela;
+
+// Section indices of the object built by ELFObjectFileTest.
+enum {
+  TextIdx = 1,
+  RelaIdx,
+  RelIdx,
+  SymTabIdx,
+  StrTabIdx,
+  DynSymIdx,
+  DynStrIdx,
+  ShStrTabIdx,
+  NumSections
+};
+
+class ELFObjectFileTest : public testing::Test {
+protected:
+  void SetUp() override {
+    Buf.assign(sizeof(Elf_Ehdr), '\0');
+    ShStrTab.assign(1, '\0');
+    Elf_Shdr Sections[NumSections];
+    memset(Sections, 0, sizeof(Sections));
+
+    static const char Text[8] = {0};
+    addSection(Sections[TextIdx], ".text", ELF::SHT_PROGBITS,
+               StringRef(Text, sizeof(Text)));
+
+    // Two symbols named "dup", the global one comes after the local one.
+    const char StrTab[] = "\0dup\0only_local\0func";
+    Elf_Sym Syms[5];
+    memset(Syms, 0, sizeof(Syms));
+    setSymbol(Syms[1], 1, ELF::STB_LOCAL, 1);
+    setSymbol(Syms[2], 5, ELF::STB_LOCAL, 2);
+    setSymbol(Syms[3], 1, ELF::STB_GLOBAL, 3);
+    setSymbol(Syms[4], 16, ELF::STB_GLOBAL, 4);
+    addSection(Sections[SymTabIdx], ".symtab", ELF::SHT_SYMTAB, toBytes(Syms),
+               sizeof(Elf_Sym), StrTabIdx, 3);
+    addSection(Sections[StrTabIdx], ".strtab", ELF::SHT_STRTAB,
+               StringRef(StrTab, sizeof(StrTab)));
+
+    const char DynStr[] = "\0dynfunc";
+    Elf_Sym DynSyms[2];
+    memset(DynSyms, 0, sizeof(DynSyms));
+    setSymbol(DynSyms[1], 1, ELF::STB_GLOBAL, 5);
+    addSection(Sections[DynSymIdx], ".dynsym", ELF::SHT_DYNSYM,
+               toBytes(DynSyms), sizeof(Elf_Sym), DynStrIdx, 1);
+    addSection(Sections[DynStrIdx], ".dynstr", ELF::SHT_STRTAB,
+               StringRef(DynStr, sizeof(DynStr)));
+
+    Elf_Rela Rela;
+    memset(&Rela, 0, sizeof(Rela));
+    Rela.r_offset = 0;
+    Rela.setSymbolAndType(3, ELF::R_X86_64_64, false);
+    Rela.r_addend = 8;
+    addSection(Sections[RelaIdx], ".rela.text", ELF::SHT_RELA, toBytes(Rela),
+               sizeof(Elf_Rela), SymTabIdx, TextIdx);
+
+    Elf_Rel Rel;
+    memset(&Rel, 0, sizeof(Rel));
+    Rel.r_offset = 4;
+    Rel.setSymbolAndType(4, ELF::R_X86_64_PC32, false);
+    addSection(Sections[RelIdx], ".rel.text", ELF::SHT_REL, toBytes(Rel),
+               sizeof(Elf_Rel), SymTabIdx, TextIdx);
+
+    // The section names go last, once all of them are known.
+    Sections[ShStrTabIdx].sh_name = ShStrTab.size();
+    ShStrTab.append(".shstrtab");
+    ShStrTab.push_back('\0');
+    Sections[ShStrTabIdx].sh_type = ELF::SHT_STRTAB;
+    Sections[ShStrTabIdx].sh_offset = append(ShStrTab);
+    Sections[ShStrTabIdx].sh_size = ShStrTab.size();
+
+    Elf_Ehdr Ehdr;
+    memset(&Ehdr, 0, sizeof(Ehdr));
+    memcpy(Ehdr.e_ident, ELF::ElfMagic, strlen(ELF::ElfMagic));
+    Ehdr.e_ident[ELF::EI_CLASS] = ELF::ELFCLASS64;
+    Ehdr.e_ident[ELF::EI_DATA] = ELF::ELFDATA2LSB;
+    Ehdr.e_ident[ELF::EI_VERSION] = ELF::EV_CURRENT;
+    Ehdr.e_type = ELF::ET_REL;
+    Ehdr.e_machine = ELF::EM_X86_64;
+    Ehdr.e_version = ELF::EV_CURRENT;
+    Ehdr.e_ehsize = sizeof(Elf_Ehdr);
+    Ehdr.e_shoff = append(toBytes(Sections));
+    Ehdr.e_shentsize = sizeof(Elf_Shdr);
+    Ehdr.e_shnum = NumSections;
+    Ehdr.e_shstrndx = ShStrTabIdx;
+    memcpy(&Buf[0], &Ehdr, sizeof(Ehdr));
+
+    std::error_code EC;
+    Obj.reset(new ELF64LEObjectFile(MemoryBufferRef(Buf, "test.o"), EC));
+    ASSERT_FALSE(EC);
+  }
+
+  template <class T> static StringRef toBytes(const T &V) {
+    return StringRef(reinterpret_cast<const char *>(&V), sizeof(V));
+  }
+
+  static void setSymbol(Elf_Sym &Sym, unsigned Name, unsigned char Binding,
+                        uint64_t Value) {
+    Sym.st_name = Name;
+    Sym.setBindingAndType(Binding, ELF::STT_FUNC);
+    Sym.st_shndx = TextIdx;
+    Sym.st_value = Value;
+  }
+
+  // Append \p Bytes to the object at an 8-byte aligned offset and return the
+  // offset.
+  uint64_t append(StringRef Bytes) {
+    Buf.resize(RoundUpToAlignment(Buf.size(), 8));
+    uint64_t Offset = Buf.size();
+    Buf.append(Bytes.begin(), Bytes.end());
+    return Offset;
+  }
+
+  void addSection(Elf_Shdr &Sec, StringRef Name, unsigned Type,
+                  StringRef Contents, uint64_t EntSize = 0, unsigned Link = 0,
+                  unsigned Info = 0) {
+    Sec.sh_name = ShStrTab.size();
+    ShStrTab.append(Name.begin(), Name.end());
+    ShStrTab.push_back('\0');
+    Sec.sh_type = Type;
+    Sec.sh_offset = append(Contents);
+    Sec.sh_size = Contents.size();
+    Sec.sh_entsize = EntSize;
+    Sec.sh_link = Link;
+    Sec.sh_info = Info;
+  }
+
+  StringRef sectionName(const Elf_Shdr &Sec) {
+    ErrorOr<StringRef> NameOrErr = Obj->getELFFile()->getSectionName(&Sec);
+    EXPECT_FALSE(NameOrErr.getError());
+    return NameOrErr ? *NameOrErr : StringRef();
+  }
+
+  std::string Buf;
+  std::string ShStrTab;
+  std::unique_ptr<ELF64LEObjectFile> Obj;
+};
+
+TEST_F(ELFObjectFileTest, Sections) {
+  ArrayRef<Elf_Shdr> Sections = Obj->elf_sections();
+  ASSERT_EQ(unsigned(NumSections), Sections.size());
+  EXPECT_EQ(unsigned(ELF::SHT_NULL), Sections[0].sh_type);
+  EXPECT_EQ(".text", sectionName(Sections[TextIdx]));
+  EXPECT_EQ(".symtab", sectionName(Sections[SymTabIdx]));
+  EXPECT_EQ(".shstrtab", sectionName(Sections[ShStrTabIdx]));
+
+  EXPECT_EQ(&Sections[TextIdx], Obj->findSection(".text"));
+  EXPECT_EQ(&Sections[RelaIdx], Obj->findSection(".rela.text"));
+  EXPECT_EQ(&Sections[DynStrIdx], Obj->findSection(".dynstr"));
+  EXPECT_EQ(nullptr, Obj->findSection(".data"));
+  EXPECT_EQ(nullptr, Obj->findSection(""));
+}
+
+TEST_F(ELFObjectFileTest, Symbols) {
+  ArrayRef<Elf_Sym> Syms = Obj->elf_symbols();
+  ASSERT_EQ(5u, Syms.size());
+  EXPECT_EQ("", *Obj->getSymbolName(Syms[0]));
+  EXPECT_EQ("dup", *Obj->getSymbolName(Syms[1]));
+  EXPECT_EQ("only_local", *Obj->getSymbolName(Syms[2]));
+  EXPECT_EQ("dup", *Obj->getSymbolName(Syms[3]));
+  EXPECT_EQ("func", *Obj->getSymbolName(Syms[4]));
+
+  ArrayRef<Elf_Sym> DynSyms = Obj->elf_symbols(/*Dynamic=*/true);
+  ASSERT_EQ(2u, DynSyms.size());
+  EXPECT_EQ("dynfunc", *Obj->getSymbolName(DynSyms[1], /*Dynamic=*/true));
+  EXPECT_EQ(5u, DynSyms[1].st_value);
+
+  // A global symbol wins over a local one of the same name.
+  EXPECT_EQ(&Syms[3], Obj->findSymbol("dup"));
+  EXPECT_EQ(&Syms[2], Obj->findSymbol("only_local"));
+  EXPECT_EQ(&Syms[4], Obj->findSymbol("func"));
+  // Only the static symbol table is indexed.
+  EXPECT_EQ(nullptr, Obj->findSymbol("dynfunc"));
+  EXPECT_EQ(nullptr, Obj->findSymbol(""));
+}
+
+TEST_F(ELFObjectFileTest, Relocations) {
+  ArrayRef<Elf_Rela> Relas = Obj->getRelas(Obj->findSection(".rela.text"));
+  ASSERT_EQ(1u, Relas.size());
+  EXPECT_EQ(0u, Relas[0].r_offset);
+  EXPECT_EQ(3u, Relas[0].getSymbol(false));
+  EXPECT_EQ(unsigned(ELF::R_X86_64_64), Relas[0].getType(false));
+  EXPECT_EQ(8, Relas[0].r_addend);
+
+  ArrayRef<Elf_Rel> Rels = Obj->getRels(Obj->findSection(".rel.text"));
+  ASSERT_EQ(1u, Rels.size());
+  EXPECT_EQ(4u, Rels[0].r_offset);
+  EXPECT_EQ(4u, Rels[0].getSymbol(false));
+  EXPECT_EQ(unsigned(ELF::R_X86_64_PC32), Rels[0].getType(false));
+}
+
+} // end anonymous namespace
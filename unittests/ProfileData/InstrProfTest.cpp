@@ -10,6 +10,7 @@
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ProfileData/InstrProfWriter.h"
 #include "llvm/Support/Compression.h"
+#include "llvm/Support/FileSystem.h"
 #include "gtest/gtest.h"
 
 #include <cstdarg>
@@ -122,6 +123,92 @@ TEST_F(InstrProfTest, get_function_counts) {
   ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, EC));
 }
 
+TEST_F(InstrProfTest, get_instr_prof_record_ref) {
+  InstrProfRecord Record1("foo", 0x1234, {1, 2});
+  InstrProfRecord Record2("foo", 0x1235, {3, 4, 5});
+  // Give the first record value data so that the lookup of the second one has
+  // to skip over it.
+  Record1.reserveSites(IPVK_IndirectCallTarget, 1);
+  InstrProfValueData VD0[] = {{(uint64_t) "callee1", 1},
+                              {(uint64_t) "callee2", 2}};
+  Record1.addValueData(IPVK_IndirectCallTarget, 0, VD0, 2, nullptr);
+  Writer.addRecord(std::move(Record1));
+  Writer.addRecord(std::move(Record2));
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  ErrorOr<InstrProfRecordRef> R = Reader->getInstrProfRecordRef("foo", 0x1234);
+  ASSERT_TRUE(NoError(R.getError()));
+  ASSERT_EQ(StringRef("foo"), R->Name);
+  ASSERT_EQ(0x1234U, R->Hash);
+  ASSERT_EQ(2U, R->Counts.size());
+  ASSERT_EQ(1U, R->Counts[0]);
+  ASSERT_EQ(2U, R->Counts[1]);
+
+  R = Reader->getInstrProfRecordRef("foo", 0x1235);
+  ASSERT_TRUE(NoError(R.getError()));
+  ASSERT_EQ(3U, R->Counts.size());
+  ASSERT_EQ(3U, R->Counts[0]);
+  ASSERT_EQ(4U, R->Counts[1]);
+  ASSERT_EQ(5U, R->Counts[2]);
+
+  R = Reader->getInstrProfRecordRef("foo", 0x5678);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch, R.getError()));
+
+  R = Reader->getInstrProfRecordRef("bar", 0x1234);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, R.getError()));
+}
+
+TEST_F(InstrProfTest, get_shared_reader) {
+  InstrProfRecord Record("foo", 0x1234, {1, 2});
+  Writer.addRecord(std::move(Record));
+
+  int FD;
+  SmallString<128> Path;
+  ASSERT_TRUE(NoError(
+      sys::fs::createTemporaryFile("instrprof-shared", "profdata", FD, Path)));
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    Writer.write(OS);
+  }
+
+  auto Shared1 = IndexedInstrProfReader::getShared(Path);
+  ASSERT_TRUE(NoError(Shared1.getError()));
+  auto Shared2 = IndexedInstrProfReader::getShared(Path);
+  ASSERT_TRUE(NoError(Shared2.getError()));
+  ASSERT_EQ(Shared1->get(), Shared2->get());
+
+  ErrorOr<InstrProfRecordRef> R =
+      (*Shared2)->getInstrProfRecordRef("foo", 0x1234);
+  ASSERT_TRUE(NoError(R.getError()));
+  ASSERT_EQ(2U, R->Counts.size());
+  ASSERT_EQ(2U, R->Counts[1]);
+
+  // Rewriting the profile evicts the reader of the old contents.
+  std::weak_ptr<IndexedInstrProfReader> Old = *Shared1;
+  Shared1->reset();
+  Shared2->reset();
+  Writer.addRecord(InstrProfRecord("bar", 0x5678, {3, 4, 5}));
+  {
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+    ASSERT_TRUE(NoError(EC));
+    Writer.write(OS);
+  }
+  auto Shared3 = IndexedInstrProfReader::getShared(Path);
+  ASSERT_TRUE(NoError(Shared3.getError()));
+  ASSERT_TRUE(Old.expired());
+  ASSERT_TRUE(NoError((*Shared3)->getInstrProfRecordRef("bar", 0x5678)
+                          .getError()));
+
+  // So does removing it.
+  Old = *Shared3;
+  Shared3->reset();
+  ASSERT_TRUE(NoError(sys::fs::remove(Path)));
+  ASSERT_FALSE(IndexedInstrProfReader::getShared(Path));
+  ASSERT_TRUE(Old.expired());
+}
+
 TEST_F(InstrProfTest, get_icall_data_read_write) {
   InstrProfRecord Record1("caller", 0x1234, {1, 2});
   InstrProfRecord Record2("callee1", 0x1235, {3, 4});
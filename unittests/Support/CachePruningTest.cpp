@@ -0,0 +1,133 @@
+//===- unittests/CachePruningTest.cpp - CachePruning tests ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// Create a 100 bytes file named \p Name in \p Dir, last modified \p Age
+// seconds ago.
+void createFile(StringRef Dir, StringRef Name, unsigned Age) {
+  SmallString<64> Path(Dir);
+  sys::path::append(Path, Name);
+  int FD;
+  ASSERT_FALSE(sys::fs::openFileForWrite(Path, FD, sys::fs::F_None));
+  {
+    raw_fd_ostream OS(FD, /* shouldClose */ false);
+    OS << std::string(100, 'x');
+  }
+  sys::TimeValue Time =
+      sys::TimeValue::now() - sys::TimeValue(sys::TimeValue::SecondsType(Age));
+  ASSERT_FALSE(sys::fs::setLastModificationAndAccessTime(FD, Time));
+  ASSERT_FALSE(sys::Process::SafelyCloseFileDescriptor(FD));
+}
+
+bool fileExists(StringRef Dir, StringRef Name) {
+  SmallString<64> Path(Dir);
+  sys::path::append(Path, Name);
+  return sys::fs::exists(Path);
+}
+
+void removeFile(StringRef Dir, StringRef Name) {
+  SmallString<64> Path(Dir);
+  sys::path::append(Path, Name);
+  sys::fs::remove(Path);
+}
+
+TEST(CachePruningTest, MaxSize) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+
+  createFile(TmpDir, "llvmcache-old", 300);
+  createFile(TmpDir, "llvmcache-mid", 200);
+  createFile(TmpDir, "llvmcache-new", 100);
+  createFile(TmpDir, "other", 400);
+
+  // The least recently used entry goes first, files that are not cache
+  // entries are left alone.
+  EXPECT_TRUE(CachePruning(TmpDir).setMaxSize(250).prune());
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-old"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-mid"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-new"));
+  EXPECT_TRUE(fileExists(TmpDir, "other"));
+
+  // Touching an entry makes it the most recently used one.
+  CachePruning::touch((TmpDir + "/llvmcache-mid").str());
+  EXPECT_TRUE(CachePruning(TmpDir).setMaxSize(150).prune());
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-mid"));
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-new"));
+
+  removeFile(TmpDir, "llvmcache-mid");
+  removeFile(TmpDir, "other");
+  removeFile(TmpDir, "llvmcache.timestamp");
+  ASSERT_FALSE(sys::fs::remove(StringRef(TmpDir)));
+}
+
+TEST(CachePruningTest, Expiration) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+
+  createFile(TmpDir, "llvmcache-old", 1000);
+  createFile(TmpDir, "llvmcache-new", 10);
+
+  EXPECT_TRUE(CachePruning(TmpDir).setEntryExpiration(500).prune());
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-old"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-new"));
+
+  // A pruning interval that has not elapsed yet prevents pruning.
+  createFile(TmpDir, "llvmcache-old", 1000);
+  EXPECT_FALSE(CachePruning(TmpDir)
+                   .setEntryExpiration(500)
+                   .setPruningInterval(3600)
+                   .prune());
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-old"));
+
+  removeFile(TmpDir, "llvmcache-old");
+  removeFile(TmpDir, "llvmcache-new");
+  removeFile(TmpDir, "llvmcache.timestamp");
+  ASSERT_FALSE(sys::fs::remove(StringRef(TmpDir)));
+}
+
+TEST(CachePruningTest, InFlightFiles) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+
+  createFile(TmpDir, "llvmcache-key.lock", 300);
+  createFile(TmpDir, "llvmcache-key.lock-1a2b3c4d", 300);
+  createFile(TmpDir, "llvmcache-key-1a2b3c.tmp", 300);
+  createFile(TmpDir, "llvmcache-entry", 100);
+
+  // Files that another process may be writing are neither removed nor counted
+  // by the size-based pruning.
+  EXPECT_TRUE(CachePruning(TmpDir).setMaxSize(150).prune());
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-key.lock"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-key.lock-1a2b3c4d"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-key-1a2b3c.tmp"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-entry"));
+
+  // Once expired, they are left behind by a process that went away.
+  EXPECT_TRUE(CachePruning(TmpDir).setEntryExpiration(200).prune());
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-key.lock"));
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-key.lock-1a2b3c4d"));
+  EXPECT_FALSE(fileExists(TmpDir, "llvmcache-key-1a2b3c.tmp"));
+  EXPECT_TRUE(fileExists(TmpDir, "llvmcache-entry"));
+
+  removeFile(TmpDir, "llvmcache-entry");
+  removeFile(TmpDir, "llvmcache.timestamp");
+  ASSERT_FALSE(sys::fs::remove(StringRef(TmpDir)));
+}
+
+} // anonymous namespace
@@ -570,6 +570,25 @@ TEST_F(FileSystemTest, TempFiles) {
 #endif
 }
 
+TEST_F(FileSystemTest, HardLink) {
+  int FD;
+  SmallString<64> TempPath;
+  ASSERT_NO_ERROR(fs::createTemporaryFile("prefix", "temp", FD, TempPath));
+  ASSERT_NO_ERROR(fs::resize_file(FD, 123));
+  ::close(FD);
+
+  // The hard link keeps the content alive once the original is removed.
+  SmallString<64> LinkPath(TempPath);
+  LinkPath += ".link";
+  ASSERT_NO_ERROR(fs::create_hard_link(Twine(TempPath), Twine(LinkPath)));
+  ASSERT_NO_ERROR(fs::remove(Twine(TempPath)));
+  fs::file_status Status;
+  ASSERT_NO_ERROR(fs::status(Twine(LinkPath), Status));
+  EXPECT_EQ(fs::file_type::regular_file, Status.type());
+  EXPECT_EQ(123U, Status.getSize());
+  ASSERT_NO_ERROR(fs::remove(Twine(LinkPath)));
+}
+
 TEST_F(FileSystemTest, CreateDir) {
   ASSERT_NO_ERROR(fs::create_directory(Twine(TestDirectory) + "foo"));
   ASSERT_NO_ERROR(fs::create_directory(Twine(TestDirectory) + "foo"));
@@ -166,3 +166,28 @@ TEST_F(ThreadPoolTest, PoolDestruction) {
   }
   ASSERT_EQ(5, checked_in);
 }
+
+TEST_F(ThreadPoolTest, ParallelForBatches) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool(2);
+  std::vector<std::atomic_int> Seen(10);
+  std::vector<std::atomic_int> BatchSizes(4);
+  parallelForBatches(Pool, Seen.size(), BatchSizes.size(),
+                     [&](size_t Batch, size_t Begin, size_t End) {
+                       for (size_t I = Begin; I != End; ++I)
+                         ++Seen[I];
+                       BatchSizes[Batch] += End - Begin;
+                     });
+  for (std::atomic_int &S : Seen)
+    ASSERT_EQ(1, S.load());
+  for (std::atomic_int &S : BatchSizes)
+    ASSERT_TRUE(S.load() == 2 || S.load() == 3);
+
+  // There are never more batches than indices.
+  std::atomic_int NumBatches{0};
+  parallelForBatches(Pool, 3, 8, [&](size_t Batch, size_t Begin, size_t End) {
+    ASSERT_EQ(Begin + 1, End);
+    ++NumBatches;
+  });
+  ASSERT_EQ(3, NumBatches.load());
+}
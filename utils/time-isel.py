@@ -0,0 +1,117 @@
+#!/usr/bin/env python
+
+"""time-isel.py - Time the SelectionDAG phases of llc over a corpus.
+
+Runs llc with -time-passes on every .ll or .bc file given on the command line
+(directories are searched recursively), collects the "Instruction Selection
+and Scheduling" timer group, and prints the wall time spent in each phase,
+summed over the corpus. Each file is compiled several times and the fastest
+run is kept for every phase, to reduce the noise when comparing two builds
+of llc.
+
+Example:
+
+  time-isel.py --llc=build/bin/llc --repeat=5 --llc-arg=-O2 corpus/
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+GROUP = 'Instruction Selection and Scheduling'
+TIME_RE = re.compile(r'(\d+\.\d+) \(\s*[\d.]+%\)')
+
+
+def find_inputs(paths):
+    for path in paths:
+        if not os.path.isdir(path):
+            yield path
+            continue
+        for root, dirs, files in os.walk(path):
+            dirs.sort()
+            for name in sorted(files):
+                if name.endswith('.ll') or name.endswith('.bc'):
+                    yield os.path.join(root, name)
+
+
+def parse_group(output):
+    """Return a {phase: wall seconds} dictionary for the ISel timer group."""
+    lines = output.splitlines()
+    try:
+        start = next(i for i, l in enumerate(lines) if l.strip() == GROUP)
+    except StopIteration:
+        return {}
+
+    phases = {}
+    wall_column = None
+    for line in lines[start + 1:]:
+        if '--- Name ---' in line:
+            columns = re.findall(r'-+([^-]+?)-+',
+                                 line.replace('--- Name ---', ''))
+            wall_column = [c.strip() for c in columns].index('Wall Time')
+            continue
+        if wall_column is None:
+            continue
+        times = TIME_RE.findall(line)
+        if not times:
+            if line.startswith('===') or not line.strip():
+                if phases:
+                    break
+            continue
+        name = TIME_RE.split(line)[-1].strip()
+        if name != 'Total':
+            phases[name] = float(times[wall_column])
+    return phases
+
+
+def time_file(llc, args, path, repeat):
+    best = {}
+    for _ in range(repeat):
+        proc = subprocess.Popen([llc, '-time-passes', '-o', os.devnull] +
+                                args + [path],
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                universal_newlines=True)
+        _, err = proc.communicate()
+        if proc.returncode != 0:
+            sys.stderr.write('error: llc failed on %s\n%s' % (path, err))
+            sys.exit(1)
+        for phase, seconds in parse_group(err).items():
+            best[phase] = min(best.get(phase, seconds), seconds)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--llc', default='llc', help='llc binary to time')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='number of runs per file, the fastest is kept')
+    parser.add_argument('--per-file', action='store_true',
+                        help='also print the ISel time of every file')
+    parser.add_argument('--llc-arg', action='append', default=[],
+                        help='extra option to pass to llc')
+    parser.add_argument('inputs', nargs='+',
+                        help='.ll or .bc files, or directories to search')
+    opts = parser.parse_args()
+
+    totals = {}
+    num_files = 0
+    for path in find_inputs(opts.inputs):
+        phases = time_file(opts.llc, opts.llc_arg, path, max(opts.repeat, 1))
+        num_files += 1
+        if opts.per_file:
+            print('%10.4f  %s' % (sum(phases.values()), path))
+        for phase, seconds in phases.items():
+            totals[phase] = totals.get(phase, 0.0) + seconds
+
+    total = sum(totals.values())
+    print('%d files, %.4f seconds in instruction selection and scheduling'
+          % (num_files, total))
+    for phase, seconds in sorted(totals.items(), key=lambda x: -x[1]):
+        print('%10.4f (%5.1f%%)  %s'
+              % (seconds, 100.0 * seconds / total if total else 0.0, phase))
+
+
+if __name__ == '__main__':
+    main()